@@ -0,0 +1,106 @@
+#include "Arena.hpp"
+#include <atomic>
+#include <new>
+#include <sys/mman.h>
+
+static atomic<long> heapAllocations{0};   ///< operator new calls, every thread<br>
+static atomic<long> heapFrees{0};         ///< operator delete calls, every thread<br>
+static thread_local long threadNews = 0;  ///< operator new calls on this thread<br>
+
+long Heap::allocations() { return heapAllocations.load(memory_order_relaxed); }
+long Heap::frees() { return heapFrees.load(memory_order_relaxed); }
+long Heap::threadAllocations() { return threadNews; }
+
+/**
+ * Counting replacements for the global operator new and delete. <br>
+ * -------------------------------------------------------
+ * - Each does one relaxed increment and then what the library's would:
+ *   malloc() (throwing bad_alloc if it fails) or free().
+ * - The array and sized forms forward here, so nothing goes uncounted.
+ * -------------------------------------------------------
+ */
+void* operator new(size_t bytes) {
+    heapAllocations.fetch_add(1, memory_order_relaxed);
+    threadNews++;
+    void* piece = malloc(bytes ? bytes : 1);
+    if (!piece) throw bad_alloc();
+    return piece;
+}
+
+void* operator new[](size_t bytes) { return operator new(bytes); }
+
+void operator delete(void* piece) noexcept {
+    if (!piece) return;
+    heapFrees.fetch_add(1, memory_order_relaxed);
+    free(piece);
+}
+
+void operator delete[](void* piece) noexcept { operator delete(piece); }
+void operator delete(void* piece, size_t) noexcept { operator delete(piece); }
+void operator delete[](void* piece, size_t) noexcept { operator delete(piece); }
+
+Arena::~Arena() {
+    for (auto& [block, bytes] : blocks) munmap(block, bytes);
+}
+
+/**
+ * Maps another block. <br>
+ * -------------------------------------------------------
+ * - At least `blockBytes`, rounded up to whole blocks for a piece larger than that.
+ * - With huge pages on, tries MAP_HUGETLB first; without reserved huge
+ *   pages that fails and the block is mapped normally, with MADV_HUGEPAGE
+ *   so the kernel may still back it with transparent huge pages.
+ * - Whatever was left of the current block is abandoned; with blocks much
+ *   larger than the pieces, that is little.
+ * -------------------------------------------------------
+ */
+void Arena::grow(size_t bytes) {
+    size_t length = (bytes + blockBytes - 1) / blockBytes * blockBytes;
+    void* block = MAP_FAILED;
+    if (huge) {
+        block = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        hugeBlocks += block != MAP_FAILED;
+    }
+    if (block == MAP_FAILED) {
+        block = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (block == MAP_FAILED) fatal("Out of memory for an arena block of " + to_string(length) + " bytes");
+        if (huge) madvise(block, length, MADV_HUGEPAGE);
+    }
+    blocks.emplace_back(static_cast<char*>(block), length);
+    next = static_cast<char*>(block);
+    end = next + length;
+}
+
+void* Arena::allocate(size_t bytes) {
+    bytes = (bytes + ARENA_GRAIN - 1) / ARENA_GRAIN * ARENA_GRAIN;
+    if (bytes == 0) bytes = ARENA_GRAIN;
+    if (size_t(end - next) < bytes) grow(bytes);
+    void* piece = next;
+    next += bytes;
+    used += bytes;
+    return piece;
+}
+
+void* Arena::take(size_t bytes) {
+    size_t sizeClass = (bytes + ARENA_GRAIN - 1) / ARENA_GRAIN;
+    if (sizeClass > 0 && sizeClass <= ARENA_CLASSES && freeLists[sizeClass - 1]) {
+        void* piece = freeLists[sizeClass - 1];
+        freeLists[sizeClass - 1] = *static_cast<void**>(piece);
+        reused++;
+        return piece;
+    }
+    return allocate(bytes);
+}
+
+void Arena::give(void* piece, size_t bytes) {
+    size_t sizeClass = (bytes + ARENA_GRAIN - 1) / ARENA_GRAIN;
+    if (!piece || sizeClass == 0 || sizeClass > ARENA_CLASSES) return;
+    *static_cast<void**>(piece) = freeLists[sizeClass - 1];
+    freeLists[sizeClass - 1] = piece;
+}
+
+size_t Arena::bytesMapped() const {
+    size_t total = 0;
+    for (auto& [block, bytes] : blocks) total += bytes;
+    return total;
+}
@@ -0,0 +1,271 @@
+#pragma once
+#include "tools.hpp"
+#include <memory>
+
+#define ARENA_BLOCK (2 << 20)      ///< Bytes an arena maps at a time by default: one huge page<br>
+#define ARENA_GRAIN 16             ///< Alignment of everything an arena hands out, and the step between size classes<br>
+#define ARENA_CLASSES 64           ///< Size classes given back pieces are kept in for reuse (up to 1 KB)<br>
+#define ARENA_LIST_CHUNK 256       ///< Records per chunk of an ArenaList<br>
+
+/**
+ * @class Heap<br>
+ * Counts calls to the global operator new and delete.<br>
+ * -------------------------------------------------------<br>
+ * - Arena.cpp replaces the global operators with ones that count and then
+ *   call malloc() and free(), so every container and string is counted,
+ *   whoever's code it is in.<br>
+ * - Counts are kept for the whole process and for each thread, so a sweep
+ *   worker can measure its own run while others allocate beside it.<br>
+ * -------------------------------------------------------<br>
+ */
+class Heap {
+public:
+    static long allocations();        ///< Calls to operator new so far, in every thread<br>
+    static long frees();              ///< Calls to operator delete so far, in every thread<br>
+    static long threadAllocations();  ///< Calls to operator new so far on this thread<br>
+};
+
+/**
+ * @class Arena<br>
+ * Memory mapped in large blocks and handed out in pieces, for one owner's records, nodes and buffers.<br>
+ * -------------------------------------------------------<br>
+ * - Blocks come straight from mmap(), never from the heap, and are all
+ *   unmapped together when the arena goes. allocate() bumps a pointer
+ *   through the current block; there is no per-piece header.<br>
+ * - take() and give() add reuse: a piece given back goes on the free list
+ *   of its size class (ARENA_GRAIN apart, up to ARENA_CLASSES of them) and
+ *   the next take() of that class pops it. Pieces larger than the classes
+ *   are not reused, so owners allocate those once, up front.<br>
+ * - With useHugePages(), new blocks are asked for as huge pages; if none
+ *   are reserved, the block is mapped normally and offered to transparent
+ *   huge pages instead. Either way fewer TLB entries cover the records.<br>
+ * - Not thread-safe: an arena belongs to one thread (Mom's, a kid's).<br>
+ * -------------------------------------------------------<br>
+ */
+class Arena {
+private:
+    size_t blockBytes;                ///< Smallest mapping made at a time<br>
+    bool huge = false;                ///< Ask for huge pages for new blocks<br>
+    vector<pair<char*, size_t>> blocks; ///< Every mapping, for unmapping<br>
+    char* next = nullptr;             ///< First free byte of the current block<br>
+    char* end = nullptr;              ///< End of the current block<br>
+    void* freeLists[ARENA_CLASSES] = {}; ///< Given back pieces by size class, each linked through its first bytes<br>
+    size_t used = 0;                  ///< Bytes handed out by allocate(), including those later given back<br>
+    long reused = 0;                  ///< take() calls served from a free list<br>
+    long hugeBlocks = 0;              ///< Blocks mapped as explicit huge pages<br>
+
+    /**
+     * Maps a new block of at least `bytes` and makes it current.<br>
+     * @throws Terminates the program if the system has no memory to map.<br>
+     */
+    void grow(size_t bytes);
+
+public:
+    /**
+     * @param blockBytes Smallest mapping to make at a time (ARENA_BLOCK by default)<br>
+     */
+    explicit Arena(size_t blockBytes = ARENA_BLOCK) : blockBytes(blockBytes) {}
+    ~Arena();
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    /**
+     * Maps later blocks as huge pages where the system allows it.<br>
+     */
+    void useHugePages(bool on) { huge = on; }
+
+    /**
+     * @return `bytes` of fresh memory aligned to ARENA_GRAIN; it is never reused<br>
+     */
+    void* allocate(size_t bytes);
+
+    /**
+     * @return `bytes` of memory, a piece of that size class given back earlier if there is one<br>
+     */
+    void* take(size_t bytes);
+
+    /**
+     * Gives back a piece from take() for the next take() of its size class.<br>
+     */
+    void give(void* piece, size_t bytes);
+
+    size_t bytesMapped() const;
+    size_t bytesUsed() const { return used; }
+    size_t blockCount() const { return blocks.size(); }
+    long hugeBlockCount() const { return hugeBlocks; }
+    long reuses() const { return reused; }
+};
+
+/**
+ * @struct ArenaAllocator<br>
+ * Lets a standard container take its nodes from an Arena.<br>
+ * Node-based containers (maps, lists) allocate one node at a time, so
+ * what one erases the next insert takes back. Their bucket arrays should
+ * be reserved once, as larger pieces are not reused.<br>
+ */
+template<class T>
+struct ArenaAllocator {
+    using value_type = T;
+    Arena* arena;
+
+    ArenaAllocator(Arena& arena) : arena(&arena) {}
+    template<class U> ArenaAllocator(const ArenaAllocator<U>& other) : arena(other.arena) {}
+
+    T* allocate(size_t n) { return static_cast<T*>(arena->take(n * sizeof(T))); }
+    void deallocate(T* piece, size_t n) { arena->give(piece, n * sizeof(T)); }
+
+    template<class U> bool operator==(const ArenaAllocator<U>& other) const { return arena == other.arena; }
+    template<class U> bool operator!=(const ArenaAllocator<U>& other) const { return arena != other.arena; }
+};
+
+/**
+ * A hash map whose nodes live in an Arena.<br>
+ */
+template<class K, class V>
+using ArenaMap = unordered_map<K, V, hash<K>, equal_to<K>, ArenaAllocator<pair<const K, V>>>;
+
+/**
+ * @class ArenaList<br>
+ * Records appended one after another in arena chunks, never moved or freed one by one.<br>
+ * -------------------------------------------------------<br>
+ * - A chunk holds ARENA_LIST_CHUNK records; when it fills, the next is
+ *   linked on. Nothing is copied as the list grows, unlike a vector, and
+ *   a record's address never changes.<br>
+ * - For logs that only grow, such as jobs completed.<br>
+ * -------------------------------------------------------<br>
+ */
+template<class T>
+class ArenaList {
+private:
+    struct Chunk {
+        Chunk* next = nullptr;
+        size_t count = 0;
+        alignas(T) unsigned char records[ARENA_LIST_CHUNK * sizeof(T)];
+        T* at(size_t i) { return reinterpret_cast<T*>(records) + i; }
+    };
+    static_assert(alignof(Chunk) <= ARENA_GRAIN, "ArenaList records need at most ARENA_GRAIN alignment");
+
+    Arena& arena;
+    Chunk* first = nullptr;
+    Chunk* last = nullptr;
+    size_t records = 0;
+
+public:
+    /**
+     * @class iterator<br>
+     * Forward iterator over the records, oldest first.<br>
+     */
+    class iterator {
+    private:
+        Chunk* chunk;
+        size_t i;
+    public:
+        iterator(Chunk* chunk, size_t i) : chunk(chunk), i(i) {}
+        T& operator*() const { return *chunk->at(i); }
+        T* operator->() const { return chunk->at(i); }
+        iterator& operator++() {
+            if (++i == chunk->count && chunk->next) {
+                chunk = chunk->next;
+                i = 0;
+            }
+            return *this;
+        }
+        bool operator==(const iterator& other) const { return chunk == other.chunk && i == other.i; }
+        bool operator!=(const iterator& other) const { return !(*this == other); }
+    };
+
+    explicit ArenaList(Arena& arena) : arena(arena) {}
+    ~ArenaList() {
+        for (Chunk* chunk = first; chunk; chunk = chunk->next)
+            for (size_t i = 0; i < chunk->count; i++) chunk->at(i)->~T();
+    }
+    ArenaList(const ArenaList&) = delete;
+    ArenaList& operator=(const ArenaList&) = delete;
+
+    /**
+     * Appends a record built from `args`.<br>
+     */
+    template<class... Args>
+    T& emplace_back(Args&&... args) {
+        if (!last || last->count == ARENA_LIST_CHUNK) {
+            Chunk* chunk = new (arena.allocate(sizeof(Chunk))) Chunk;
+            (last ? last->next : first) = chunk;
+            last = chunk;
+        }
+        T* record = new (last->at(last->count)) T(std::forward<Args>(args)...);
+        last->count++;
+        records++;
+        return *record;
+    }
+
+    void push_back(const T& record) { emplace_back(record); }
+    size_t size() const { return records; }
+    bool empty() const { return records == 0; }
+    iterator begin() const { return iterator(first, 0); }
+    iterator end() const { return iterator(last, last ? last->count : 0); }
+};
+
+/**
+ * @class Pool<br>
+ * Objects of one kind, kept built between uses so their buffers survive.<br>
+ * -------------------------------------------------------<br>
+ * - take() hands out an idle object, or builds a new one in the arena when
+ *   none is idle; dropping the Ptr returns it. So a pool only ever holds as
+ *   many objects as were out at once, and after warm-up takes nothing new.<br>
+ * - T is default-constructible and has recycle(), called as an object is
+ *   returned, which lets go of what belonged to its last user (a socket,
+ *   say) while keeping its allocations for the next.<br>
+ * -------------------------------------------------------<br>
+ */
+template<class T>
+class Pool {
+private:
+    Arena& arena;
+    vector<T*> idle;                  ///< Returned objects waiting to be taken again<br>
+    vector<T*> built;                 ///< Every object built, for destroying with the pool<br>
+
+public:
+    /**
+     * @struct Returner<br>
+     * Deleter that hands the object back to its pool.<br>
+     */
+    struct Returner {
+        Pool* pool = nullptr;
+        void operator()(T* item) const { pool->give(item); }
+    };
+    using Ptr = unique_ptr<T, Returner>;
+
+    explicit Pool(Arena& arena) : arena(arena) {}
+    ~Pool() { for (T* item : built) item->~T(); }
+    Pool(const Pool&) = delete;
+    Pool& operator=(const Pool&) = delete;
+
+    /**
+     * @return An idle object, or a new one<br>
+     */
+    Ptr take() {
+        T* item;
+        if (!idle.empty()) {
+            item = idle.back();
+            idle.pop_back();
+        }
+        else {
+            static_assert(alignof(T) <= ARENA_GRAIN, "Pool objects need at most ARENA_GRAIN alignment");
+            item = new (arena.allocate(sizeof(T))) T();
+            built.push_back(item);
+            idle.reserve(built.size());
+        }
+        return Ptr(item, Returner{this});
+    }
+
+    /**
+     * Recycles `item` and keeps it for the next take().<br>
+     */
+    void give(T* item) {
+        item->recycle();
+        idle.push_back(item);
+    }
+
+    size_t size() const { return built.size(); }
+    size_t idleCount() const { return idle.size(); }
+};
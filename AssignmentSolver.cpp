@@ -0,0 +1,70 @@
+#include "AssignmentSolver.hpp"
+
+size_t AssignmentSolver::addBidder(const vector<pair<int, long>>& options) {
+    for (auto& [object, worth] : options) {
+        objects.push_back(object);
+        worths.push_back(worth);
+        objectCount = max(objectCount, object + 1);
+    }
+    firstOption.push_back(objects.size());
+    return bidders() - 1;
+}
+
+void AssignmentSolver::clear() {
+    firstOption.resize(1);
+    objects.clear();
+    worths.clear();
+    objectCount = 0;
+}
+
+/**
+ * Runs the auction. <br>
+ * -------------------------------------------------------
+ * - Bidders wait in a queue, in the order they were added. A bidder is
+ *   queued at most once at a time, so a ring of one slot each holds it. The one at the
+ *   front looks over its options for the best and second-best worth less
+ *   price; staying out is always an option worth 0.
+ * - If nothing beats staying out, the bidder drops out for good: prices
+ *   only rise, so nothing will later. Otherwise it raises the best
+ *   object's price by best - second best + 1, takes it, and its previous
+ *   holder goes to the back of the queue.
+ * - Every bid raises a price by at least 1, so the auction ends; with
+ *   worths scaled by bidders + 1, every bidder ends within 1 of its best
+ *   deal, which is enough for the assignment to be optimal.
+ * -------------------------------------------------------
+ */
+const vector<int>& AssignmentSolver::solve() {
+    size_t count = bidders();
+    long scale = count + 1;
+    price.assign(objectCount, 0);
+    holder.assign(objectCount, -1);
+    won.assign(count, -1);
+    unassigned.resize(count);
+    for (size_t bidder = 0; bidder < count; bidder++) unassigned[bidder] = bidder;
+    size_t head = 0, waiting = count;
+    while (waiting > 0) {
+        int bidder = unassigned[head];
+        head = (head + 1) % count;
+        waiting--;
+        long best = 0, second = 0;
+        int choice = -1;
+        for (size_t k = firstOption[bidder]; k < firstOption[bidder + 1]; k++) {
+            long net = worths[k] * scale - price[objects[k]];
+            if (net > best) {
+                second = best;
+                best = net;
+                choice = objects[k];
+            }
+            else if (net > second) second = net;
+        }
+        if (choice < 0) continue;
+        price[choice] += best - second + 1;
+        if (holder[choice] >= 0) {
+            won[holder[choice]] = -1;
+            unassigned[(head + waiting++) % count] = holder[choice];
+        }
+        holder[choice] = bidder;
+        won[bidder] = choice;
+    }
+    return won;
+}
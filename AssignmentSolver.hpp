@@ -0,0 +1,58 @@
+#pragma once
+#include "tools.hpp"
+
+/**
+ * @class AssignmentSolver<br>
+ * Best assignment of bidders to objects, each bidder taking at most one.<br>
+ * -------------------------------------------------------<br>
+ * - Each bidder lists the objects it would take and what each is worth to
+ *   it; anything unlisted is out of reach. Bidders may be left with
+ *   nothing, and most objects usually go unasked for.<br>
+ * - Solved with Bertsekas' auction: an unassigned bidder bids for the
+ *   object with the best worth less price, raising its price by the gap to
+ *   the second best plus epsilon, and takes it from whoever held it. A
+ *   bidder for whom nothing is worth more than its price drops out.<br>
+ * - Worths are integers scaled by bidders + 1 and epsilon is 1, so the
+ *   result is an optimal assignment, not just one within epsilon of it.<br>
+ * - Only listed pairs are ever looked at, so a batch costs time in the
+ *   pairs offered, not bidders times objects. Ties go to the bidder added first.<br>
+ * - Meant to be kept and clear()ed between problems: once its vectors have
+ *   grown to the largest problem seen, solving allocates nothing.<br>
+ * -------------------------------------------------------<br>
+ */
+class AssignmentSolver {
+private:
+    vector<size_t> firstOption;   ///< Where each bidder's options start; one extra entry at the end<br>
+    vector<int> objects;          ///< Object of every option, grouped by bidder<br>
+    vector<long> worths;          ///< Worth of every option<br>
+    int objectCount = 0;          ///< One more than the largest object named<br>
+    vector<long> price;           ///< Scratch for solve(): each object's price<br>
+    vector<int> holder;           ///< Scratch: bidder holding each object, or -1<br>
+    vector<int> won;              ///< Scratch: the result<br>
+    vector<int> unassigned;       ///< Scratch: bidders waiting to bid, a ring of one slot per bidder<br>
+
+public:
+    AssignmentSolver() : firstOption{0} {}
+
+    /**
+     * Adds a bidder and the objects it would take, each with its worth (>= 0).<br>
+     * @return The bidder's index<br>
+     */
+    size_t addBidder(const vector<pair<int, long>>& options);
+
+    /**
+     * @return Bidders added so far<br>
+     */
+    size_t bidders() const { return firstOption.size() - 1; }
+
+    /**
+     * Removes every bidder, keeping the memory for the next problem.<br>
+     */
+    void clear();
+
+    /**
+     * Solves the assignment.<br>
+     * @return The object each bidder won, or -1; valid until the next clear() or solve()<br>
+     */
+    const vector<int>& solve();
+};
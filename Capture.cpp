@@ -0,0 +1,117 @@
+#include "Capture.hpp"
+#include "TableCodec.hpp"
+#include "Enums.hpp"
+
+/**
+ * @return true for the codes a kid sends; Moms and relays send the rest.
+ */
+static bool fromKid(short code) {
+    return code == static_cast<short>(messageCodes::QUIT) || code == static_cast<short>(messageCodes::WANT_JOB)
+        || code == static_cast<short>(messageCodes::NEED_JOB) || code == static_cast<short>(messageCodes::JOB_DONE)
+        || code == static_cast<short>(messageCodes::USE_FORMAT) || code == static_cast<short>(messageCodes::NEED_JOB_SINCE)
+        || code == static_cast<short>(messageCodes::WANT_JOBS) || code == static_cast<short>(messageCodes::DONE_AND_NEXT)
+        || code == static_cast<short>(messageCodes::SUBSCRIBE);
+}
+
+/**
+ * Zigzag: small negative numbers (a slot of -1) stay one byte as varints.
+ */
+static uint32_t zigzag(int value) { return (uint32_t(value) << 1) ^ uint32_t(value >> 31); }
+static int unzigzag(uint32_t value) { return int(value >> 1) ^ -int(value & 1); }
+
+Capture::Capture(Clock& clock, unsigned seed, int slots) : clock(clock) {
+    bytes.reserve(CAPTURE_RESERVE);
+    bytes += CAPTURE_MAGIC;
+    TableCodec::putVarint(bytes, seed);
+    TableCodec::putVarint(bytes, slots);
+}
+
+void Capture::begin(Kind kind, short session) {
+    double now = clock.now();
+    if (last < 0) last = now;
+    TableCodec::putVarint(bytes, uint32_t(llround((now - last) * 1e6)));
+    last = now;
+    bytes += static_cast<char>(kind);
+    TableCodec::putVarint(bytes, session);
+    recorded++;
+}
+
+void Capture::join(short session) { begin(Kind::JOIN, session); }
+
+void Capture::leave(short session) { begin(Kind::LEAVE, session); }
+
+void Capture::message(short session, const Message& message) {
+    if (!fromKid(message.code)) return;
+    begin(Kind::MESSAGE, session);
+    TableCodec::putVarint(bytes, message.code);
+    TableCodec::putVarint(bytes, zigzag(message.arg));
+    TableCodec::putVarint(bytes, message.wanted);
+    TableCodec::putVarint(bytes, message.count);
+    for (short k = 0; k < message.count; k++) {
+        TableCodec::putVarint(bytes, zigzag(message.slots[k]));
+        TableCodec::putVarint(bytes, message.generations[k]);
+    }
+    TableCodec::putVarint(bytes, message.name.size());
+    bytes += message.name;
+}
+
+void Capture::save(const string& path) const {
+    ofstream file(path, ios::binary);
+    if (!file) fatal("Can't write capture file " + path);
+    file.write(bytes.data(), bytes.size());
+}
+
+/**
+ * Decodes a capture file. <br>
+ * -------------------------------------------------------
+ * - The whole file is read at once; captures are a few bytes a message.
+ * - Times are added up from the deltas, so `at` counts from the first record.
+ * - A record cut short, or a message with more than MAX_CLAIMS candidates
+ *   or a name longer than MAX_NAME, means the file is damaged.
+ * -------------------------------------------------------
+ */
+vector<Capture::Record> Capture::load(const string& path, unsigned& seed, int& slots) {
+    ifstream file(path, ios::binary);
+    if (!file) fatal("Can't read capture file " + path);
+    string in((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+    size_t magic = strlen(CAPTURE_MAGIC);
+    if (in.compare(0, magic, CAPTURE_MAGIC) != 0) fatal(path + " is not a capture file");
+    size_t at = magic;
+    uint32_t value;
+    auto next = [&]() {
+        if (!TableCodec::getVarint(in, at, value)) fatal("Capture file " + path + " is cut short");
+        return value;
+    };
+    seed = next();
+    slots = next();
+    vector<Record> records;
+    double clock = 0;
+    while (at < in.size()) {
+        Record record;
+        clock += next() / 1e6;
+        record.at = clock;
+        if (at >= in.size()) fatal("Capture file " + path + " is cut short");
+        record.kind = static_cast<Kind>(in[at++]);
+        record.session = next();
+        if (record.kind == Kind::MESSAGE) {
+            Message& message = record.message;
+            message.code = next();
+            message.arg = unzigzag(next());
+            message.wanted = next();
+            uint32_t count = next();
+            if (count > MAX_CLAIMS) fatal("Capture file " + path + " has a claim of " + to_string(count) + " candidates");
+            message.count = count;
+            for (short k = 0; k < message.count; k++) {
+                message.slots[k] = unzigzag(next());
+                message.generations[k] = next();
+            }
+            size_t length = next();
+            if (length > MAX_NAME || at + length > in.size()) fatal("Capture file " + path + " has a damaged name");
+            message.name.assign(in, at, length);
+            at += length;
+        }
+        else if (record.kind != Kind::JOIN && record.kind != Kind::LEAVE) fatal("Capture file " + path + " has an unknown record");
+        records.push_back(std::move(record));
+    }
+    return records;
+}
@@ -0,0 +1,106 @@
+#pragma once
+#include "tools.hpp"
+#include "Clock.hpp"
+#include "Connection.hpp"
+
+#define CAPTURE_MAGIC "SSCAP1"       ///< First bytes of every capture file<br>
+#define CAPTURE_RESERVE (1 << 20)    ///< Bytes reserved up front so recording rarely reallocates<br>
+
+/**
+ * @class Capture<br>
+ * Records what each kid says to Mom, with timestamps, for replay (see Replay).<br>
+ * -------------------------------------------------------<br>
+ * - Mom reports every kid that joins, every kid-protocol message it sends
+ *   (as the kid sent it, before any queue view is applied), and its leaving.
+ *   Messages from other Moms and a relay's ATTACH and DETACH are left out;
+ *   a kid behind a relay is recorded as if it had connected directly.<br>
+ * - Like Tracer, recording only appends to memory; save() writes the file.
+ *   Records are encoded as they come in, so a capture stays compact in
+ *   memory as well as on disk.<br>
+ * - File: CAPTURE_MAGIC, then varint seed and table slots of the Mom that
+ *   was recorded, then one record after another:<br>
+ *     varint microseconds since the previous record, one byte of Kind, varint session,<br>
+ *     and for a MESSAGE: varint code, zigzag arg, varint wanted, varint count,
+ *     a zigzag slot and varint generation per candidate, varint name length and the name.<br>
+ *   A claim of one candidate takes about ten bytes.<br>
+ * - Mom's replies are not stored: they are what a replay measures, and
+ *   they depend on the build being measured.<br>
+ * -------------------------------------------------------<br>
+ */
+class Capture {
+public:
+    /**
+     * @enum Kind<br>
+     * What a record says happened.<br>
+     */
+    enum class Kind : char { JOIN, MESSAGE, LEAVE };
+
+    /**
+     * @struct Record<br>
+     * One decoded record.<br>
+     */
+    struct Record {
+        double at = 0;                ///< Seconds since the first record<br>
+        Kind kind = Kind::JOIN;
+        short session = -1;           ///< Mom's session ID for the kid<br>
+        Message message;              ///< For Kind::MESSAGE<br>
+    };
+
+private:
+    Clock& clock;                     ///< Time source for every record<br>
+    string bytes;                     ///< The file so far<br>
+    double last = -1;                 ///< Time of the previous record; -1 before the first<br>
+    long recorded = 0;                ///< Records so far<br>
+
+    /**
+     * Starts a record: the time since the last one, its kind and session.<br>
+     */
+    void begin(Kind kind, short session);
+
+public:
+    /**
+     * @param clock Clock the recorded Mom runs on<br>
+     * @param seed Seed the recorded Mom's jobs are rolled from<br>
+     * @param slots Slots in the recorded Mom's table<br>
+     */
+    Capture(Clock& clock, unsigned seed, int slots);
+
+    /**
+     * Records a kid joining as `session`.<br>
+     */
+    void join(short session);
+
+    /**
+     * Records `message` from `session`, if it is one a kid sends.<br>
+     */
+    void message(short session, const Message& message);
+
+    /**
+     * Records `session` leaving.<br>
+     */
+    void leave(short session);
+
+    /**
+     * @return Records so far<br>
+     */
+    long records() const { return recorded; }
+
+    /**
+     * @return Bytes the file will take<br>
+     */
+    size_t size() const { return bytes.size(); }
+
+    /**
+     * Writes the capture to `path`.<br>
+     * @throws Terminates the program if the file can't be written.<br>
+     */
+    void save(const string& path) const;
+
+    /**
+     * Reads a capture file.<br>
+     * @param seed Set to the recorded Mom's seed<br>
+     * @param slots Set to the recorded Mom's table slots<br>
+     * @throws Terminates the program if the file can't be read or is malformed.<br>
+     */
+    static vector<Record> load(const string& path, unsigned& seed, int& slots);
+};
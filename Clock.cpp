@@ -0,0 +1,23 @@
+#include "Clock.hpp"
+#include <chrono>
+#include <thread>
+
+/**
+ * @class WallClock<br>
+ * Real time: a monotonic clock and a real sleep.<br>
+ */
+class WallClock : public Clock {
+public:
+    double now() override {
+        return chrono::duration<double>(chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    void sleepFor(double seconds) override {
+        this_thread::sleep_for(chrono::duration<double>(seconds));
+    }
+};
+
+Clock& Clock::wall() {
+    static WallClock clock;
+    return clock;
+}
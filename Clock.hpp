@@ -0,0 +1,31 @@
+#pragma once
+#include "tools.hpp"
+
+/**
+ * @class Clock<br>
+ * Source of time for Mom's run loop and the Kids' work.<br>
+ * -------------------------------------------------------<br>
+ * - Mom and Kid never call time() or sleep() themselves; they ask their clock.<br>
+ * - The wall clock is the default. The simulator hands out a virtual clock
+ *   so the same code runs without waiting for real seconds to pass.<br>
+ * -------------------------------------------------------<br>
+ */
+class Clock {
+public:
+    virtual ~Clock() = default;
+
+    /**
+     * @return Seconds since an arbitrary, fixed starting point<br>
+     */
+    virtual double now() = 0;
+
+    /**
+     * Lets `seconds` pass for the caller.<br>
+     */
+    virtual void sleepFor(double seconds) = 0;
+
+    /**
+     * @return The process-wide real-time clock<br>
+     */
+    static Clock& wall();
+};
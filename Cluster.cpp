@@ -0,0 +1,155 @@
+#include "Cluster.hpp"
+#include "Printer.hpp"
+
+/**
+ * @return `ports` with `self` added, sorted, and without repeats.<br>
+ */
+static vector<int> members(vector<int> ports, int self) {
+    ports.push_back(self);
+    sort(ports.begin(), ports.end());
+    ports.erase(unique(ports.begin(), ports.end()), ports.end());
+    return ports;
+}
+
+Cluster::Cluster(TransportKind transport, int self, vector<int> ports)
+    : transport(transport), self(self), ring(members(std::move(ports), self)) {
+    for (int port : ring.nodes())
+        if (port != self) peers.push_back(Peer{port});
+}
+
+/**
+ * Tries every unlinked peer whose retry time has come. <br>
+ * -------------------------------------------------------
+ * - A Mom that isn't listening yet is simply tried again CLUSTER_RETRY later.
+ * - A new link says PEER_HELLO with this Mom's port straight away; her
+ *   greeting (ACK and a session ID) is read later by service().
+ * -------------------------------------------------------
+ */
+void Cluster::connect(IoEngine& engine, double now) {
+    for (Peer& peer : peers) {
+        if (peer.link || now < peer.askAfter) continue;
+        unique_ptr<Transport> link = Transport::connect(transport, peer.port, false);
+        if (!link) {
+            peer.askAfter = now + CLUSTER_RETRY;
+            continue;
+        }
+        peer.link = make_unique<Connection>(engine.add(std::move(link)));
+        peer.greeted = peer.asking = false;
+        short hello[2] = {static_cast<short>(messageCodes::PEER_HELLO), static_cast<short>(self)};
+        peer.link->queue(hello, sizeof(hello));
+        peer.link->flush();
+        engine.watch(peer.link->transport(), true, peer.link->backlog() > 0);
+        ss << "Linked to the Mom on port " << peer.port << endl;
+        Printer::write(ss, cout);
+    }
+}
+
+void Cluster::drop(Peer& peer, IoEngine& engine, double now) {
+    engine.remove(peer.link->transport());
+    peer.link.reset();
+    peer.askAfter = now + CLUSTER_RETRY;
+    ss << "Lost the Mom on port " << peer.port << endl;
+    Printer::write(ss, cout);
+}
+
+bool Cluster::owns(const Transport* link) const {
+    for (const Peer& peer : peers)
+        if (peer.link && &peer.link->transport() == link) return true;
+    return false;
+}
+
+/**
+ * Handles whatever a peer has sent back. <br>
+ * -------------------------------------------------------
+ * - First her greeting: ACK and a session ID, or QUIT if she is full, in
+ *   which case the link is closed and retried later.
+ * - Then the answer to an outstanding STEAL_JOBS, once all of it is here:
+ *   ACK, a count, and three shorts per job. An empty answer backs off.
+ * -------------------------------------------------------
+ */
+bool Cluster::service(const Transport* link, IoEngine& engine, double now) {
+    for (Peer& peer : peers) {
+        if (!peer.link || &peer.link->transport() != link) continue;
+        Connection& mom = *peer.link;
+        bool open = mom.flush() && mom.fill();
+        short head[2];
+        if (!peer.greeted && mom.take(head, sizeof(head))) {
+            peer.greeted = head[0] == static_cast<short>(messageCodes::ACK);
+            if (!peer.greeted) open = false;
+        }
+        bool got = false;
+        while (open && peer.asking && mom.peek(head, sizeof(head))) {
+            size_t rowBytes = max<short>(head[1], 0) * 3 * sizeof(short);
+            if (mom.buffered() < sizeof(head) + rowBytes) break;
+            mom.take(head, sizeof(head));
+            vector<short> rows(rowBytes / sizeof(short));
+            mom.take(rows.data(), rowBytes);
+            for (size_t j = 0; j < rows.size(); j += 3) {
+                if (min({rows[j], rows[j + 1], rows[j + 2]}) < 1 || max({rows[j], rows[j + 1], rows[j + 2]}) > 5) continue;
+                stolen.emplace_back(rows[j], rows[j + 1], rows[j + 2]);
+                received++;
+                got = true;
+            }
+            peer.asking = false;
+            if (head[1] <= 0) peer.askAfter = now + CLUSTER_BACKOFF;
+        }
+        if (open) open = !mom.isClosed() && mom.flush();
+        if (!open) drop(peer, engine, now);
+        else engine.watch(mom.transport(), true, mom.backlog() > 0);
+        return got;
+    }
+    return false;
+}
+
+void Cluster::askForJobs(short count, double now) {
+    if (!stolen.empty()) return;
+    for (size_t tried = 0; tried < peers.size(); tried++) {
+        Peer& peer = peers[nextPeer++ % peers.size()];
+        if (!peer.link || !peer.greeted || peer.asking || now < peer.askAfter) continue;
+        short request[2] = {static_cast<short>(messageCodes::STEAL_JOBS), count};
+        peer.link->queue(request, sizeof(request));
+        peer.link->flush();
+        peer.asking = true;
+        requests++;
+        return;
+    }
+}
+
+bool Cluster::takeStolen(Job& job) {
+    if (stolen.empty()) return false;
+    job = stolen.front();
+    stolen.pop_front();
+    return true;
+}
+
+void Cluster::shareEarnings(const unordered_map<string, long>& totals, IoEngine& engine) {
+    for (Peer& peer : peers) {
+        if (!peer.link) continue;
+        auto send = [&](const string& name, int32_t total) {
+            short code = static_cast<short>(messageCodes::EARNINGS);
+            short length = min<size_t>(name.size(), MAX_NAME);
+            peer.link->queue(&code, sizeof(code));
+            peer.link->queue(&total, sizeof(total));
+            peer.link->queue(&length, sizeof(length));
+            peer.link->queue(name.data(), length);
+        };
+        for (auto& [name, total] : totals) send(name, total);
+        send("", 0);
+        peer.link->flush();
+        engine.watch(peer.link->transport(), true, peer.link->backlog() > 0);
+    }
+}
+
+size_t Cluster::linked() const {
+    size_t count = 0;
+    for (const Peer& peer : peers) count += peer.link != nullptr;
+    return count;
+}
+
+void Cluster::disconnect(IoEngine& engine) {
+    for (Peer& peer : peers) {
+        if (!peer.link) continue;
+        engine.remove(peer.link->transport());
+        peer.link.reset();
+    }
+}
@@ -0,0 +1,124 @@
+#pragma once
+#include "tools.hpp"
+#include "Job.hpp"
+#include "HashRing.hpp"
+#include "Connection.hpp"
+#include "IoEngine.hpp"
+#include <deque>
+
+#define CLUSTER_RETRY 1.0       ///< Seconds between attempts to reach a peer Mom that isn't up<br>
+#define CLUSTER_BACKOFF 0.25    ///< Seconds before asking a peer that had nothing to spare again<br>
+#define CLUSTER_REPORT_WAIT 5   ///< Seconds a Mom waits at the end for the other Moms' earnings<br>
+
+/**
+ * @class Cluster<br>
+ * One Mom's links to the other Moms sharing a job supply.<br>
+ * -------------------------------------------------------<br>
+ * - Every Mom is named by the port her kids connect to. Each one connects
+ *   to every other one like a kid would, then says PEER_HELLO, so between
+ *   two Moms there are two links: each sends requests on her own and
+ *   answers the other's on the session it arrived on.<br>
+ * - The job supply is split with `ring` (see ShardedJobSource); kids may
+ *   connect to any Mom and only ever see her table.<br>
+ * - A Mom whose share has run dry (slots left vacant) steals: she sends
+ *   STEAL_JOBS to one peer at a time, round robin, with one request
+ *   outstanding per peer. The peer answers ACK, a count, and that many
+ *   (slow, dirty, heavy) shorts; the jobs wait in `stolen` until slots
+ *   take them. A peer with nothing to spare is left alone for CLUSTER_BACKOFF.<br>
+ * - At the end each Mom sends her per-kid totals to the others with
+ *   EARNINGS, so every Mom can print the whole cluster's earnings.<br>
+ * - Links are non-blocking and watched by Mom's own I/O engine; a peer that
+ *   is down or hangs up is tried again every CLUSTER_RETRY seconds.<br>
+ * -------------------------------------------------------<br>
+ */
+class Cluster {
+private:
+    /**
+     * @struct Peer<br>
+     * Link to one other Mom.<br>
+     */
+    struct Peer {
+        int port;
+        unique_ptr<Connection> link;  ///< Null while not connected<br>
+        bool greeted = false;         ///< Her ACK and session ID have been read<br>
+        bool asking = false;          ///< A STEAL_JOBS is waiting for its answer<br>
+        double askAfter = 0;          ///< Earliest time to connect or ask again<br>
+    };
+
+    TransportKind transport;      ///< How to reach the other Moms<br>
+    int self;                     ///< This Mom's port<br>
+    HashRing ring;                ///< Every Mom's port, this one included<br>
+    vector<Peer> peers;           ///< The other Moms<br>
+    size_t nextPeer = 0;          ///< Where the next steal starts looking<br>
+    deque<Job> stolen;            ///< Jobs taken from peers and not yet in a slot<br>
+    long requests = 0;            ///< STEAL_JOBS sent<br>
+    long received = 0;            ///< Jobs received in answer<br>
+
+    /**
+     * Closes the link to a peer and schedules a reconnect.<br>
+     */
+    void drop(Peer& peer, IoEngine& engine, double now);
+
+public:
+    /**
+     * @param transport Transport of every Mom in the cluster (TCP or UNIX)<br>
+     * @param self This Mom's port<br>
+     * @param ports Every Mom's port; `self` is added if missing<br>
+     */
+    Cluster(TransportKind transport, int self, vector<int> ports);
+
+    /**
+     * @return The ring the job supply is split by<br>
+     */
+    const HashRing& hashRing() const { return ring; }
+
+    /**
+     * Connects to every peer that is not linked and is due a retry.<br>
+     */
+    void connect(IoEngine& engine, double now);
+
+    /**
+     * @return true if `link` is one of this Mom's links to a peer<br>
+     */
+    bool owns(const Transport* link) const;
+
+    /**
+     * Reads a peer's greeting and steal answers, and flushes what is queued for it.<br>
+     * @return true if jobs were received<br>
+     */
+    bool service(const Transport* link, IoEngine& engine, double now);
+
+    /**
+     * Asks the next peer that can be asked for up to `count` jobs.<br>
+     */
+    void askForJobs(short count, double now);
+
+    /**
+     * Takes the oldest stolen job.<br>
+     * @return false if there is none<br>
+     */
+    bool takeStolen(Job& job);
+
+    /**
+     * Sends this Mom's per-kid totals to every connected peer, ending with an empty name.<br>
+     */
+    void shareEarnings(const unordered_map<string, long>& totals, IoEngine& engine);
+
+    /**
+     * @return Peers currently connected<br>
+     */
+    size_t linked() const;
+
+    /**
+     * @return Other Moms in the cluster<br>
+     */
+    size_t peerCount() const { return peers.size(); }
+
+    /**
+     * Closes every peer link.<br>
+     */
+    void disconnect(IoEngine& engine);
+
+    long stealRequests() const { return requests; }
+    long jobsReceived() const { return received; }
+};
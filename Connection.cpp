@@ -0,0 +1,189 @@
+#include "Connection.hpp"
+
+void Connection::open(unique_ptr<Transport> link) {
+    recycle();
+    this->link = std::move(link);
+}
+
+void Connection::recycle() {
+    link.reset();
+    in.clear();
+    out.clear();
+    inHead = outHead = 0;
+    closed = full = false;
+}
+
+/**
+ * Reads until the transport would block. <br>
+ * -------------------------------------------------------
+ * - Already-parsed bytes are dropped first so `in` does not grow without bound.
+ * - A throttled connection is left alone; its input waits in the transport.
+ * -------------------------------------------------------
+ */
+bool Connection::fill() {
+    if (closed) return false;
+    if (full) return true;
+    if (inHead > 0) { in.erase(0, inHead); inHead = 0; }
+    char chunk[4096];
+    for (;;) {
+        long nBytes = link->tryRecv(chunk, sizeof(chunk));
+        if (nBytes == TRANSPORT_AGAIN) return true;
+        if (nBytes <= 0) { closed = true; return false; }
+        in.append(chunk, nBytes);
+    }
+}
+
+/**
+ * Bytes of argument after each message code.<br>
+ */
+static size_t argBytes(short code) {
+    if (code == static_cast<short>(messageCodes::WANT_JOB) || code == static_cast<short>(messageCodes::JOB_DONE)
+        || code == static_cast<short>(messageCodes::USE_FORMAT)
+        || code == static_cast<short>(messageCodes::DONE_AND_NEXT)
+        || code == static_cast<short>(messageCodes::STEAL_JOBS)
+        || code == static_cast<short>(messageCodes::PEER_HELLO)
+        || code == static_cast<short>(messageCodes::DETACH)
+        || code == static_cast<short>(messageCodes::VIA)) return sizeof(short);
+    if (code == static_cast<short>(messageCodes::NEED_JOB_SINCE)
+        || code == static_cast<short>(messageCodes::EARNINGS)) return sizeof(int32_t);
+    return 0;
+}
+
+/**
+ * Parses one message. <br>
+ * -------------------------------------------------------
+ * - WANT_JOB and JOB_DONE carry one extra short (the job index),
+ *   USE_FORMAT one (the TableFormat), and NEED_JOB_SINCE a 32-bit table
+ *   version; every other code is a single short. WANT_JOB then carries
+ *   the generation the kid saw in that slot.
+ * - WANT_JOBS then carries the most jobs wanted, a candidate count, and
+ *   that many (job index, generation) pairs of shorts; DONE_AND_NEXT is
+ *   the same after the index of the finished job.
+ * - From another Mom: STEAL_JOBS carries a job count and PEER_HELLO a
+ *   port, one short each; EARNINGS a 32-bit total, then a name length
+ *   and that many bytes of kid name.
+ * - From a relay: DETACH and VIA carry a session ID; ATTACH nothing.
+ * - SUBSCRIBE carries a name length and that many bytes of queue name.
+ * - Nothing is consumed until the whole message has arrived.
+ * -------------------------------------------------------
+ */
+bool Connection::nextMessage(Message& message) {
+    if (full) return false;
+    size_t at = inHead;
+    auto take = [&](void* value, size_t len) {
+        if (in.size() - at < len) return false;
+        memcpy(value, in.data() + at, len);
+        at += len;
+        return true;
+    };
+    if (!take(&message.code, sizeof(short))) return false;
+    size_t extra = argBytes(message.code);
+    if (extra == sizeof(short)) {
+        short value;
+        if (!take(&value, sizeof(short))) return false;
+        message.arg = value;
+    }
+    else if (extra == sizeof(int32_t)) {
+        int32_t value;
+        if (!take(&value, sizeof(int32_t))) return false;
+        message.arg = value;
+    }
+    message.count = 0;
+    if (message.code == static_cast<short>(messageCodes::WANT_JOB) && !take(&message.generations[0], sizeof(uint16_t))) return false;
+    if (message.code == static_cast<short>(messageCodes::WANT_JOBS)
+        || message.code == static_cast<short>(messageCodes::DONE_AND_NEXT)) {
+        if (!take(&message.wanted, sizeof(short)) || !take(&message.count, sizeof(short))) return false;
+        if (message.count < 0 || message.count > MAX_CLAIMS) {
+            closed = true;
+            return false;
+        }
+        short pairs[2 * MAX_CLAIMS];
+        if (!take(pairs, message.count * 2 * sizeof(short))) return false;
+        for (short k = 0; k < message.count; k++) {
+            message.slots[k] = pairs[2 * k];
+            message.generations[k] = pairs[2 * k + 1];
+        }
+    }
+    if (message.code == static_cast<short>(messageCodes::EARNINGS)
+        || message.code == static_cast<short>(messageCodes::SUBSCRIBE)) {
+        short length;
+        if (!take(&length, sizeof(short))) return false;
+        if (length < 0 || length > MAX_NAME) {
+            closed = true;
+            return false;
+        }
+        char name[MAX_NAME];
+        if (!take(name, length)) return false;
+        message.name.assign(name, length);
+    }
+    inHead = at;
+    return true;
+}
+
+bool Connection::peek(void* data, size_t len) const {
+    if (buffered() < len) return false;
+    memcpy(data, in.data() + inHead, len);
+    return true;
+}
+
+bool Connection::take(void* data, size_t len) {
+    if (!peek(data, len)) return false;
+    inHead += len;
+    return true;
+}
+
+void Connection::queue(const void* data, size_t len) {
+    out.append(static_cast<const char*>(data), len);
+    if (backlog() > CONN_HIGH_WATER) full = true;
+}
+
+void Connection::queueMessage(const Message& message) {
+    queue(&message.code, sizeof(short));
+    size_t extra = argBytes(message.code);
+    short arg = message.arg;
+    int32_t wide = message.arg;
+    if (extra == sizeof(short)) queue(&arg, sizeof(short));
+    else if (extra == sizeof(int32_t)) queue(&wide, sizeof(int32_t));
+    if (message.code == static_cast<short>(messageCodes::WANT_JOB)) queue(&message.generations[0], sizeof(uint16_t));
+    if (message.code == static_cast<short>(messageCodes::WANT_JOBS)
+        || message.code == static_cast<short>(messageCodes::DONE_AND_NEXT)) {
+        queue(&message.wanted, sizeof(short));
+        queue(&message.count, sizeof(short));
+        for (short k = 0; k < message.count; k++) {
+            queue(&message.slots[k], sizeof(short));
+            queue(&message.generations[k], sizeof(uint16_t));
+        }
+    }
+    if (message.code == static_cast<short>(messageCodes::EARNINGS)
+        || message.code == static_cast<short>(messageCodes::SUBSCRIBE)) {
+        short length = message.name.size();
+        queue(&length, sizeof(short));
+        queue(message.name.data(), length);
+    }
+}
+
+void Connection::takeOutput(string& bytes) {
+    bytes.clear();
+    if (outHead == 0) swap(bytes, out);
+    else bytes.append(out, outHead, string::npos);
+    out.clear();
+    outHead = 0;
+    full = false;
+}
+
+/**
+ * Hands queued output to the transport and updates the throttle.<br>
+ */
+bool Connection::flush() {
+    while (outHead < out.size()) {
+        long nBytes = link->trySend(out.data() + outHead, out.size() - outHead);
+        if (nBytes < 0) { closed = true; return false; }
+        if (nBytes == 0) break;
+        outHead += nBytes;
+    }
+    if (outHead == out.size()) { out.clear(); outHead = 0; }
+    else if (outHead > CONN_HIGH_WATER) { out.erase(0, outHead); outHead = 0; }
+    if (backlog() <= CONN_LOW_WATER) full = false;
+    else if (backlog() > CONN_HIGH_WATER) full = true;
+    return true;
+}
@@ -0,0 +1,134 @@
+#pragma once
+#include "tools.hpp"
+#include "Transport.hpp"
+
+#define CONN_HIGH_WATER (64 * 1024)  ///< Queued output that stops Mom reading from a kid<br>
+#define CONN_LOW_WATER (16 * 1024)   ///< Queued output at which reading resumes<br>
+#define MAX_NAME 64                  ///< Longest kid name in an EARNINGS message, or queue name in a SUBSCRIBE<br>
+#define MAX_CLAIMS 16                ///< Most candidate jobs in one WANT_JOBS or DONE_AND_NEXT (one reply bit each)<br>
+
+/**
+ * @struct Message<br>
+ * One message from a kid, as reassembled by Connection.<br>
+ */
+struct Message {
+    short code = 0;           ///< Message code<br>
+    int arg = 0;              ///< Job index of WANT_JOB, JOB_DONE and DONE_AND_NEXT, USE_FORMAT's TableFormat, NEED_JOB_SINCE's version,
+                              ///< STEAL_JOBS' job count, PEER_HELLO's port, EARNINGS' total, or DETACH's and VIA's session<br>
+    short wanted = 0;         ///< Most jobs to grant (WANT_JOBS, DONE_AND_NEXT)<br>
+    short count = 0;          ///< Candidates in `slots`<br>
+    short slots[MAX_CLAIMS];  ///< Candidate job indices, best first<br>
+    uint16_t generations[MAX_CLAIMS]; ///< Generation the kid saw in each candidate slot (WANT_JOB's job in the first)<br>
+    string name;              ///< Kid named in EARNINGS, or queue named in SUBSCRIBE<br>
+};
+
+/**
+ * @class Connection<br>
+ * Mom's (or a relay's) non-blocking view of one kid, relay, or other Mom.<br>
+ * -------------------------------------------------------<br>
+ * - fill() pulls whatever the transport holds into `in`; nextMessage()
+ *   only hands out a message once all of its shorts have arrived.<br>
+ * - queue() appends replies to `out`; flush() writes as much as the
+ *   transport takes and keeps the rest for later.<br>
+ * - Once `out` passes CONN_HIGH_WATER the connection is throttled: Mom
+ *   stops reading it until the backlog drains to CONN_LOW_WATER.<br>
+ * -------------------------------------------------------<br>
+ */
+class Connection {
+private:
+    unique_ptr<Transport> link;   ///< Transport to the kid<br>
+    string in;                    ///< Received bytes not yet parsed<br>
+    size_t inHead = 0;            ///< Parse position in `in`<br>
+    string out;                   ///< Replies not yet accepted by the transport<br>
+    size_t outHead = 0;           ///< Send position in `out`<br>
+    bool closed = false;          ///< Peer hung up or the transport failed<br>
+    bool full = false;            ///< Backlog passed the high-water mark<br>
+
+public:
+    explicit Connection(unique_ptr<Transport> link) : link(std::move(link)) {}
+
+    /**
+     * An unopened connection, for a Pool; open() gives it a transport.<br>
+     */
+    Connection() = default;
+
+    /**
+     * Starts the connection over on `link`, keeping the buffers it has grown.<br>
+     */
+    void open(unique_ptr<Transport> link);
+
+    /**
+     * Closes the transport and empties the buffers without freeing them (Pool).<br>
+     */
+    void recycle();
+
+    Transport& transport() const { return *link; }
+
+    /**
+     * Reads everything the transport has without blocking.<br>
+     * @return false once the peer has closed or the transport failed<br>
+     */
+    bool fill();
+
+    /**
+     * Takes the next complete message out of the input buffer.<br>
+     * A claim naming more than MAX_CLAIMS candidates, or EARNINGS with a name
+     * longer than MAX_NAME, closes the connection.<br>
+     * @return false if no complete message is buffered<br>
+     */
+    bool nextMessage(Message& message);
+
+    /**
+     * Copies the next `len` unparsed bytes without consuming them.<br>
+     * @return false if fewer have arrived<br>
+     */
+    bool peek(void* data, size_t len) const;
+
+    /**
+     * Consumes the next `len` unparsed bytes, for replies that aren't kid messages.<br>
+     * @return false, consuming nothing, if fewer have arrived<br>
+     */
+    bool take(void* data, size_t len);
+
+    /**
+     * @return Bytes received and not yet parsed<br>
+     */
+    size_t buffered() const { return in.size() - inHead; }
+
+    /**
+     * Appends bytes to the output queue; nothing is written until flush().<br>
+     */
+    void queue(const void* data, size_t len);
+
+    /**
+     * Queues `message` laid out the way nextMessage() reads it (a relay passing a kid's message on).<br>
+     */
+    void queueMessage(const Message& message);
+
+    /**
+     * Writes queued output until the transport stops taking it.<br>
+     * @return false if the peer is gone<br>
+     */
+    bool flush();
+
+    /**
+     * Swaps the queued output into `bytes` instead of writing it, for a
+     * connection whose transport another thread owns (an I/O lane's kid).<br>
+     */
+    void takeOutput(string& bytes);
+
+    /**
+     * @return Bytes queued but not yet accepted by the transport<br>
+     */
+    size_t backlog() const { return out.size() - outHead; }
+
+    /**
+     * @return true while the backlog is between the high- and low-water marks after passing the high one<br>
+     */
+    bool throttled() const { return full; }
+
+    /**
+     * @return true once fill() has seen the end of the stream<br>
+     */
+    bool isClosed() const { return closed; }
+};
@@ -52,9 +52,21 @@ enum class messageCodes {
     ACK,        ///< Acknowledgement<br>
     NACK,       ///< Negative Acknowledgement (Job denied)<br>
     QUIT,       ///< Signals termination<br>
-    WANT_JOB,   ///< Kid wants to request a specific job<br>
+    WANT_JOB,   ///< Kid wants a specific job: its index and the generation the kid saw there<br>
     NEED_JOB,   ///< Kid needs the full job table<br>
-    JOB_DONE    ///< Kid finished a job and is reporting it<br>
+    JOB_DONE,   ///< Kid finished a job and is reporting it<br>
+    USE_FORMAT, ///< Kid asks for a table encoding (TableFormat); Mom answers ACK or NACK<br>
+    NEED_JOB_SINCE, ///< Kid needs the table unless it still holds this 32-bit version<br>
+    NOT_MODIFIED,   ///< Mom's reply when the kid's table is still current<br>
+    WANT_JOBS,      ///< Kid tries several candidate jobs at once; Mom answers ACK and a bitmask of grants<br>
+    DONE_AND_NEXT,  ///< JOB_DONE and WANT_JOBS in one message<br>
+    STEAL_JOBS,     ///< Another Mom asks for up to this many open jobs; answered ACK, a count, and the jobs<br>
+    PEER_HELLO,     ///< First message on a link from another Mom, carrying her port<br>
+    EARNINGS,       ///< Another Mom's total for one kid; an empty name ends her report<br>
+    ATTACH,         ///< A relay asks for a session for a kid behind it; Mom answers ACK and its ID, or NACK<br>
+    DETACH,         ///< A relay reports that the kid on this session has left<br>
+    VIA,            ///< A relay's next message is from the kid on this session<br>
+    SUBSCRIBE       ///< Kid asks for the named job queue in its table; Mom answers ACK, or NACK if there is none<br>
 };
 
 /**
@@ -66,5 +78,70 @@ const string messageCodes[] = {
     "TIME TO QUIT",
     "WANT JOB",
     "NEED A JOB",
-    "JOB DONE"
+    "JOB DONE",
+    "USE FORMAT",
+    "NEED A JOB SINCE",
+    "NOT MODIFIED",
+    "WANT JOBS",
+    "DONE AND NEXT",
+    "STEAL JOBS",
+    "PEER HELLO",
+    "EARNINGS",
+    "ATTACH",
+    "DETACH",
+    "VIA",
+    "SUBSCRIBE"
+};
+
+/**
+ * @enum TableFormat<br>
+ * Encoding of the job table in Mom's NEED_JOB reply, chosen per connection.<br>
+ */
+enum class TableFormat {
+    SHORTS,  ///< Slot count, then ROW_SHORTS (seven) shorts per slot (what every kid gets unless it asks)<br>
+    PACKED   ///< Byte length, then 12 bits per slot with the value left out<br>
+};
+
+/**
+ * Array mapping TableFormat enum to command-line names<br>
+ */
+const string tableFormatName[] = {
+    "shorts",
+    "packed"
+};
+
+/**
+ * @enum TransportKind<br>
+ * Selects how bytes move between Mom and the Kids.<br>
+ */
+enum class TransportKind {
+    TCP,   ///< AF_INET stream socket on localhost<br>
+    UNIX,  ///< AF_UNIX stream socket in the file system<br>
+    SHM    ///< Shared-memory rings with eventfd wakeups<br>
+};
+
+/**
+ * Array mapping TransportKind enum to command-line names<br>
+ */
+const string transportName[] = {
+    "tcp",
+    "unix",
+    "shm"
+};
+
+/**
+ * @enum IoEngineKind<br>
+ * Selects how Mom waits for and moves kid traffic.<br>
+ */
+enum class IoEngineKind {
+    POLL,  ///< poll() plus one read()/write() per transfer<br>
+    URING  ///< io_uring with multishot accept/recv and batched sends<br>
+};
+
+/**
+ * Array mapping IoEngineKind enum to command-line names<br>
+ */
+const string ioEngineName[] = {
+    "poll",
+    "uring"
 };
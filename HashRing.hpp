@@ -0,0 +1,57 @@
+#pragma once
+#include "tools.hpp"
+
+#define RING_POINTS 64   ///< Points each node gets on a HashRing<br>
+
+/**
+ * @class HashRing<br>
+ * Consistent hashing of 64-bit keys onto a set of nodes (Mom ports).<br>
+ * -------------------------------------------------------<br>
+ * - Every node is hashed to RING_POINTS points on a 64-bit circle; a key
+ *   belongs to the node owning the first point at or after the key's hash.<br>
+ * - Nodes are named by port, not by position, so every Mom given the same
+ *   ports in any order builds the same ring, and adding or removing one
+ *   Mom only moves the keys next to its points.<br>
+ * -------------------------------------------------------<br>
+ */
+class HashRing {
+private:
+    vector<int> members;                 ///< Node ports, in the order given<br>
+    vector<pair<uint64_t, short>> points; ///< Points on the circle and the node (index in `members`) owning each, sorted<br>
+
+    /**
+     * splitmix64 finalizer: spreads consecutive keys across the circle.<br>
+     */
+    static uint64_t mix(uint64_t x) {
+        x += 0x9e3779b97f4a7c15ULL;
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+        return x ^ (x >> 31);
+    }
+
+public:
+    explicit HashRing(const vector<int>& ports) : members(ports) {
+        for (short node = 0; node < short(members.size()); node++)
+            for (uint64_t k = 0; k < RING_POINTS; k++)
+                points.emplace_back(mix(uint64_t(members[node]) << 32 | k), node);
+        sort(points.begin(), points.end());
+    }
+
+    /**
+     * @return Index in nodes() of the node that owns `key`<br>
+     */
+    short owner(uint64_t key) const {
+        auto at = lower_bound(points.begin(), points.end(), make_pair(mix(key), short(-1)));
+        return at == points.end() ? points.front().second : at->second;
+    }
+
+    /**
+     * @return Index of `port` in nodes(), or -1 if it is not on the ring<br>
+     */
+    short indexOf(int port) const {
+        auto at = find(members.begin(), members.end(), port);
+        return at == members.end() ? -1 : short(at - members.begin());
+    }
+
+    const vector<int>& nodes() const { return members; }
+};
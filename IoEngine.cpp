@@ -0,0 +1,112 @@
+#include "IoEngine.hpp"
+#include "Printer.hpp"
+#include "UringEngine.hpp"
+
+IoEngineKind ioEngineFromName(const string& name) {
+    for (short k = 0; k < 2; k++)
+        if (caseInsensitiveEquals(name, ioEngineName[k])) return static_cast<IoEngineKind>(k);
+    fatal("Unknown I/O engine: " + name + " (use poll or uring)");
+    return IoEngineKind::POLL;
+}
+
+/**
+ * Creates Mom's I/O engine. <br>
+ * -------------------------------------------------------
+ * - URING is used when the build has io_uring support and the kernel
+ *   lets us set up a ring; otherwise Mom keeps the poll() path.
+ * -------------------------------------------------------
+ */
+unique_ptr<IoEngine> IoEngine::create(IoEngineKind kind) {
+#ifdef HAVE_IO_URING
+    if (kind == IoEngineKind::URING) {
+        unique_ptr<IoEngine> uring = UringEngine::open();
+        if (uring) return uring;
+        Printer::write("io_uring is unavailable, falling back to poll\n", cerr);
+    }
+#else
+    if (kind == IoEngineKind::URING)
+        Printer::write("Built without io_uring, falling back to poll\n", cerr);
+#endif
+    return make_unique<PollEngine>();
+}
+
+// -------------------------------------------------------------------
+// PollEngine
+// -------------------------------------------------------------------
+void PollEngine::listen(Listener& welcome) {
+    fds.insert(fds.begin(), toPoll{welcome.pollFd(), POLLIN, 0});
+    links.insert(links.begin(), nullptr);
+    stalled.insert(stalled.begin(), false);
+}
+
+/**
+ * Accepts while the last poll() saw the listener readable; the listener is
+ * non-blocking, so the first empty accept clears the flag.<br>
+ */
+unique_ptr<Transport> PollEngine::accept(Listener& welcome) {
+    if (!incoming) return nullptr;
+    unique_ptr<Transport> kid = welcome.accept();
+    Transport::syscalls++;
+    if (!kid) incoming = false;
+    return kid;
+}
+
+unique_ptr<Transport> PollEngine::add(unique_ptr<Transport> link) {
+    fds.push_back(toPoll{link->pollFd(), POLLIN, 0});
+    links.push_back(link.get());
+    stalled.push_back(false);
+    return link;
+}
+
+void PollEngine::remove(Transport& link) {
+    for (size_t i = 0; i < links.size(); i++) {
+        if (links[i] != &link) continue;
+        fds[i] = fds.back();
+        links[i] = links.back();
+        stalled[i] = stalled.back();
+        fds.pop_back();
+        links.pop_back();
+        stalled.pop_back();
+        return;
+    }
+}
+
+/**
+ * Maps Mom's interest onto poll events. <br>
+ * -------------------------------------------------------
+ * - Socket transports poll one descriptor for both directions.
+ * - A shared-memory ring has no descriptor that turns writable, so while
+ *   it holds back output the transport is retried on a short timer.
+ * -------------------------------------------------------
+ */
+void PollEngine::watch(Transport& link, bool read, bool write) {
+    for (size_t i = 0; i < links.size(); i++) {
+        if (links[i] != &link) continue;
+        bool pollable = link.writeFd() >= 0;
+        fds[i].events = (read ? POLLIN : 0) | (write && pollable ? POLLOUT : 0);
+        stalled[i] = write && !pollable;
+        return;
+    }
+}
+
+/**
+ * One poll() over every transport. <br>
+ * -------------------------------------------------------
+ * - Input is reported once wakeup() confirms it, which drops stale
+ *   eventfd notifications from shared-memory links.
+ * - Writable, hung-up, and stalled transports are reported as well.
+ * -------------------------------------------------------
+ */
+void PollEngine::wait(int timeoutMs, vector<Transport*>& ready) {
+    ready.clear();
+    bool retry = find(stalled.begin(), stalled.end(), true) != stalled.end();
+    int status = poll(fds.data(), fds.size(), retry ? min(timeoutMs, 1) : timeoutMs);
+    Transport::syscalls++;
+    if (status < 0) return;
+    for (size_t i = 0; i < fds.size(); i++) {
+        short revents = fds[i].revents;
+        if (links[i] == nullptr) { incoming |= (revents & POLLIN) != 0; continue; }
+        bool input = (revents & POLLIN) && links[i]->wakeup();
+        if (input || (revents & (POLLOUT | POLLHUP | POLLERR)) || stalled[i]) ready.push_back(links[i]);
+    }
+}
@@ -0,0 +1,104 @@
+#pragma once
+#include "tools.hpp"
+#include "Enums.hpp"
+#include "Transport.hpp"
+
+#if __has_include(<linux/io_uring.h>) && !defined(NO_IO_URING)
+#define HAVE_IO_URING 1
+#endif
+
+/**
+ * Maps a command-line name (poll, uring) to its IoEngineKind.<br>
+ * @throws Terminates the program on an unknown name.<br>
+ */
+IoEngineKind ioEngineFromName(const string& name);
+
+/**
+ * @class IoEngine<br>
+ * Waits for kid traffic on behalf of Mom's dispatch loop.<br>
+ * -------------------------------------------------------<br>
+ * - Kids may join at any time: wait() also returns when the welcome
+ *   listener has someone waiting, and accept() never blocks.<br>
+ * - Mom hands every accepted transport to add() and keeps what it returns;
+ *   an engine may wrap the transport to route its reads and writes.<br>
+ * - wait() reports the transports that have input; Mom's message handling
+ *   is the same whichever engine is underneath.<br>
+ * -------------------------------------------------------<br>
+ */
+class IoEngine {
+public:
+    virtual ~IoEngine() = default;
+
+    /**
+     * @return Short name for reports (poll, uring, ...)<br>
+     */
+    virtual string name() const = 0;
+
+    /**
+     * Starts watching the welcome listener; wait() returns when a kid knocks.<br>
+     */
+    virtual void listen(Listener& welcome) = 0;
+
+    /**
+     * Hands out a kid that is waiting on the welcome listener.<br>
+     * @return nullptr once no more kids are waiting<br>
+     */
+    virtual unique_ptr<Transport> accept(Listener& welcome) = 0;
+
+    /**
+     * Starts watching a kid's transport.<br>
+     * @return The transport Mom should use from now on<br>
+     */
+    virtual unique_ptr<Transport> add(unique_ptr<Transport> link) = 0;
+
+    /**
+     * Stops watching a transport that is about to be destroyed.<br>
+     */
+    virtual void remove(Transport& link) = 0;
+
+    /**
+     * Sets which directions Mom is interested in for a watched transport.<br>
+     * @param read Report it when input arrives (off while Mom throttles the kid)<br>
+     * @param write Report it when queued output can make progress<br>
+     */
+    virtual void watch(Transport& link, bool read, bool write) {}
+
+    /**
+     * Waits up to `timeoutMs` for input or output progress.<br>
+     * @param ready Filled with the transports worth servicing; reads and writes
+     *        on them are non-blocking, so an occasional spurious entry is harmless<br>
+     */
+    virtual void wait(int timeoutMs, vector<Transport*>& ready) = 0;
+
+    /**
+     * Blocks until every queued outbound byte has been handed to the kernel.<br>
+     */
+    virtual void drain() {}
+
+    /**
+     * Creates the requested engine, falling back to poll() if io_uring is unavailable.<br>
+     */
+    static unique_ptr<IoEngine> create(IoEngineKind kind);
+};
+
+/**
+ * @class PollEngine<br>
+ * The original poll() loop: one poll per wait, transports read and write directly.<br>
+ * Entry 0 of `fds` is the welcome listener (its `links` entry is null).<br>
+ */
+class PollEngine : public IoEngine {
+private:
+    vector<toPoll> fds;          ///< One entry per watched transport<br>
+    vector<Transport*> links;    ///< Transport behind each entry of `fds`<br>
+    vector<char> stalled;        ///< Output queued on a transport whose writability can't be polled<br>
+    bool incoming = false;       ///< The welcome listener was readable at the last wait<br>
+
+public:
+    string name() const override { return "poll"; }
+    void listen(Listener& welcome) override;
+    unique_ptr<Transport> accept(Listener& welcome) override;
+    unique_ptr<Transport> add(unique_ptr<Transport> link) override;
+    void remove(Transport& link) override;
+    void watch(Transport& link, bool read, bool write) override;
+    void wait(int timeoutMs, vector<Transport*>& ready) override;
+};
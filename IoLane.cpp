@@ -0,0 +1,209 @@
+#include "IoLane.hpp"
+#include "Clock.hpp"
+#include <sys/eventfd.h>
+
+Doorbell::Doorbell() {
+    fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (fd < 0) fatal("Can't create an eventfd for a doorbell");
+}
+
+Doorbell::~Doorbell() { ::close(fd); }
+
+void Doorbell::ring() {
+    atomic_thread_fence(memory_order_seq_cst);
+    if (!napping.load(memory_order_relaxed) || !napping.exchange(false)) return;
+    uint64_t one = 1;
+    if (write(fd, &one, sizeof(one)) == sizeof(one)) rung.fetch_add(1, memory_order_relaxed);
+    Transport::syscalls++;
+}
+
+void Doorbell::nap() {
+    napping.store(true, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+}
+
+bool Doorbell::wakeup() {
+    uint64_t count;
+    Transport::syscalls++;
+    return read(fd, &count, sizeof(count)) == sizeof(count);
+}
+
+IoLane::IoLane(IoEngineKind io, MpmcRing<Request>& requests, Doorbell& scheduler)
+    : io(io), requests(requests), scheduler(scheduler), kids(memory), sessionOf(memory) {
+    unique_ptr<Doorbell> doorbell = make_unique<Doorbell>();
+    bell = doorbell.get();
+    bellLink = std::move(doorbell);
+    worker = thread([this] { work(); });
+}
+
+IoLane::~IoLane() {
+    if (worker.joinable()) {
+        stop(0);
+        join();
+    }
+}
+
+void IoLane::post(Reply& reply) {
+    while (!replies.push(reply)) {
+        bell->ring();
+        this_thread::yield();
+    }
+    bell->ring();
+}
+
+void IoLane::stop(double seconds) {
+    flushSeconds = seconds;
+    stopping.store(true, memory_order_release);
+    bell->ring();
+}
+
+void IoLane::join() {
+    if (worker.joinable()) worker.join();
+}
+
+/**
+ * Runs the lane. <br>
+ * -------------------------------------------------------
+ * - The engine is made here, on the lane's own thread: an io_uring ring
+ *   set up single-issuer takes submissions only from the thread that made it.
+ * - Each turn takes every posted reply (adopting new kids on the way),
+ *   flushes the kids that got some, retries any requests kept back, and
+ *   then waits on the engine: for kid traffic, the doorbell, or, while
+ *   requests are kept back, one millisecond.
+ * - Kids the engine reports are serviced as in Mom's own loop.
+ * - Once stopped, the replies posted before stop() are still taken, so
+ *   every kid gets its QUIT, and output is flushed before the thread ends.
+ * -------------------------------------------------------
+ */
+void IoLane::work() {
+    engine = IoEngine::create(io);
+    bellLink = engine->add(std::move(bellLink));
+    vector<Transport*> ready;
+    Reply reply;
+    for (;;) {
+        bool last = stopping.load(memory_order_acquire);
+        while (replies.pop(reply)) take(reply);
+        flushDirty();
+        if (last) break;
+        retry();
+        bell->nap();
+        int waitMs = !unsent.empty() ? 1 : !replies.empty() || stopping.load(memory_order_relaxed) ? 0 : 1000;
+        engine->wait(waitMs, ready);
+        bell->wake();
+        for (Transport* link : ready) {
+            auto found = sessionOf.find(link);
+            if (found != sessionOf.end()) service(found->second);
+        }
+    }
+    finish();
+}
+
+void IoLane::take(Reply& reply) {
+    if (reply.adopt) {
+        Pool<Connection>::Ptr& kid = kids[reply.session];
+        kid = links.take();
+        kid->open(engine->add(unique_ptr<Transport>(reply.adopt)));
+        sessionOf[&kid->transport()] = reply.session;
+        reply.adopt = nullptr;
+    }
+    auto found = kids.find(reply.session);
+    if (found == kids.end() || reply.bytes.empty()) return;
+    delivered++;
+    found->second->queue(reply.bytes.data(), reply.bytes.size());
+    dirty.push_back(reply.session);
+}
+
+void IoLane::flushDirty() {
+    for (short session : dirty) {
+        auto found = kids.find(session);
+        if (found == kids.end()) continue;
+        Connection& kid = *found->second;
+        if (!kid.flush()) hangUp(session);
+        else engine->watch(kid.transport(), !kid.throttled(), kid.backlog() > 0);
+    }
+    dirty.clear();
+}
+
+/**
+ * Services one kid the engine reported. <br>
+ * -------------------------------------------------------
+ * - Same steps as Mom::serviceKid(): flush, read, handle what is complete,
+ *   flush the rest; handling here means decoding and forwarding.
+ * -------------------------------------------------------
+ */
+void IoLane::service(short session) {
+    Connection& kid = *kids[session];
+    bool open = kid.flush() && kid.fill();
+    decode(session, kid);
+    if (open) open = !kid.isClosed() && kid.flush();
+    if (!open) {
+        hangUp(session);
+        return;
+    }
+    engine->watch(kid.transport(), !kid.throttled(), kid.backlog() > 0);
+}
+
+void IoLane::decode(short session, Connection& kid) {
+    while (unsent.empty() && kid.nextMessage(request.message)) {
+        request.session = session;
+        request.hungUp = false;
+        forward(request);
+    }
+}
+
+void IoLane::forward(Request& request) {
+    if (unsent.empty() && requests.push(request)) {
+        forwarded++;
+        scheduler.ring();
+        return;
+    }
+    stalls++;
+    unsent.push_back(std::move(request));
+}
+
+void IoLane::retry() {
+    if (unsent.empty()) return;
+    bool pushed = false;
+    while (!unsent.empty() && requests.push(unsent.front())) {
+        unsent.pop_front();
+        forwarded++;
+        pushed = true;
+    }
+    if (pushed) scheduler.ring();
+    if (!unsent.empty()) return;
+    for (auto& [session, kid] : kids) decode(session, *kid);
+}
+
+void IoLane::hangUp(short session) {
+    auto found = kids.find(session);
+    if (found == kids.end()) return;
+    Connection& kid = *found->second;
+    Request last;
+    while (kid.nextMessage(last.message)) {
+        last.session = session;
+        last.hungUp = false;
+        forward(last);
+    }
+    engine->remove(kid.transport());
+    sessionOf.erase(&kid.transport());
+    kids.erase(found);
+    last.session = session;
+    last.hungUp = true;
+    forward(last);
+}
+
+void IoLane::finish() {
+    double start = Clock::wall().now();
+    vector<Transport*> ready;
+    for (;;) {
+        bool waiting = false;
+        for (auto& [session, kid] : kids) {
+            if (!kid->flush() || kid->backlog() == 0) continue;
+            engine->watch(kid->transport(), false, true);
+            waiting = true;
+        }
+        if (!waiting || Clock::wall().now() - start >= flushSeconds) break;
+        engine->wait(100, ready);
+    }
+    engine->drain();
+}
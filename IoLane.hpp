@@ -0,0 +1,218 @@
+#pragma once
+#include "tools.hpp"
+#include "Transport.hpp"
+#include "IoEngine.hpp"
+#include "Connection.hpp"
+#include "MpmcRing.hpp"
+#include "Arena.hpp"
+#include <deque>
+#include <thread>
+
+#define LANE_RING 4096        ///< Requests the scheduler's queue holds, and replies each lane's holds<br>
+#define MAX_IO_THREADS 16     ///< Most I/O lanes Mom runs<br>
+
+/**
+ * @class Doorbell<br>
+ * An eventfd that wakes a thread sleeping in its I/O engine when work is queued for it.<br>
+ * -------------------------------------------------------<br>
+ * - It is watched like a transport, so the engine's wait() returns when it
+ *   is rung; it carries no data.<br>
+ * - The sleeper calls nap() before its last look at its queues and wait(),
+ *   and wake() after. ring() only writes the eventfd if the owner is
+ *   napping, so a busy thread is never sent a system call. Each side
+ *   fences between its store and its look, so either the sleeper sees the
+ *   new work or the ringer sees the nap.<br>
+ * -------------------------------------------------------<br>
+ */
+class Doorbell : public Transport {
+private:
+    int fd;                           ///< Non-blocking eventfd<br>
+    atomic<bool> napping{false};      ///< Owner is about to wait, or waiting<br>
+    atomic<long> rung{0};             ///< Times the eventfd was written<br>
+
+public:
+    Doorbell();
+    ~Doorbell() override;
+
+    /**
+     * Wakes the owner if it is napping; call after queuing its work. Any thread.<br>
+     */
+    void ring();
+
+    /**
+     * Owner: announces a wait; look at the queues afterwards, then wait.<br>
+     */
+    void nap();
+
+    /**
+     * Owner: back from the wait.<br>
+     */
+    void wake() { napping.store(false, memory_order_relaxed); }
+
+    /**
+     * @return Times ring() actually had to wake the owner<br>
+     */
+    long rings() const { return rung.load(memory_order_relaxed); }
+
+    long send(const void*, size_t) override { return -1; }
+    long recv(void*, size_t) override { return -1; }
+    long tryRecv(void*, size_t) override { return TRANSPORT_AGAIN; }
+    long trySend(const void*, size_t) override { return -1; }
+    int pollFd() const override { return fd; }
+
+    /**
+     * Clears the eventfd.<br>
+     */
+    bool wakeup() override;
+};
+
+/**
+ * @class IoLane<br>
+ * One of Mom's I/O threads: it owns some kids' connections and does all their reading, parsing and writing.<br>
+ * -------------------------------------------------------<br>
+ * - Mom's scheduler thread accepts a kid and hands its transport over with
+ *   a Reply carrying `adopt`. From then on only the lane touches it, with
+ *   its own I/O engine, arena and connection pool.<br>
+ * - Every complete message is decoded here and pushed as a Request onto
+ *   the scheduler's queue, shared by all lanes. A kid that hangs up (or
+ *   sends something malformed) is closed and sent on as a Request with
+ *   `hungUp` set, after the messages it had already sent.<br>
+ * - Replies come back on the lane's own queue, already encoded, and go
+ *   out on the next flush. A reply for a kid that has since left is dropped.<br>
+ * - When the scheduler's queue is full the lane stops decoding, keeps what
+ *   it could not push, and retries every millisecond; it never blocks, so
+ *   it always keeps draining its replies and the two sides can't deadlock.<br>
+ * - Throttling works as in Mom's own loop: a connection with too much
+ *   output queued is not read until the kid catches up.<br>
+ * -------------------------------------------------------<br>
+ */
+class IoLane {
+public:
+    /**
+     * @struct Request<br>
+     * A message from one of the lane's kids, for the scheduler.<br>
+     */
+    struct Request {
+        short session = -1;
+        bool hungUp = false;          ///< The kid is gone; no message<br>
+        Message message;
+    };
+
+    /**
+     * @struct Reply<br>
+     * Bytes for one of the lane's kids, and with `adopt`, the kid's transport itself.<br>
+     */
+    struct Reply {
+        short session = -1;
+        Transport* adopt = nullptr;   ///< A newly accepted kid, now the lane's to own<br>
+        string bytes;                 ///< Encoded replies, queued as they are<br>
+    };
+
+private:
+    IoEngineKind io;                  ///< Engine kind to make once the thread runs<br>
+    unique_ptr<IoEngine> engine;      ///< This lane's own poll or io_uring engine<br>
+    MpmcRing<Request>& requests;      ///< The scheduler's queue, shared by every lane<br>
+    Doorbell& scheduler;              ///< Rung after pushing a request<br>
+    MpmcRing<Reply> replies{LANE_RING}; ///< From the scheduler: adoptions and replies<br>
+    Doorbell* bell;                   ///< Rung by the scheduler after posting a reply<br>
+    unique_ptr<Transport> bellLink;   ///< The bell, and once the engine watches it, as the engine returned it<br>
+    Arena memory;                     ///< Where the lane's connections and map nodes live<br>
+    Pool<Connection> links{memory};   ///< Connections of kids that left, buffers kept<br>
+    ArenaMap<short, Pool<Connection>::Ptr> kids; ///< The lane's kids by session ID<br>
+    ArenaMap<Transport*, short> sessionOf; ///< Session behind each watched transport<br>
+    vector<short> dirty;              ///< Kids given replies since the last flush<br>
+    Request request;                  ///< Scratch for decoding<br>
+    deque<Request> unsent;            ///< Requests that didn't fit on the scheduler's queue, oldest first<br>
+    atomic<bool> stopping{false};     ///< stop() was called<br>
+    double flushSeconds = 0;          ///< How long stop() lets output drain<br>
+    long forwarded = 0;               ///< Requests pushed to the scheduler<br>
+    long delivered = 0;               ///< Replies taken off the lane's queue<br>
+    long stalls = 0;                  ///< Requests that found the scheduler's queue full<br>
+    thread worker;                    ///< The lane's thread<br>
+
+    /**
+     * Body of the lane's thread.<br>
+     */
+    void work();
+
+    /**
+     * Adopts the transport in `reply`, if any, and queues its bytes.<br>
+     */
+    void take(Reply& reply);
+
+    /**
+     * Reads, decodes and forwards whatever one kid has sent.<br>
+     */
+    void service(short session);
+
+    /**
+     * Forwards `kid`'s complete messages until it has none or the scheduler's queue backs up.<br>
+     */
+    void decode(short session, Connection& kid);
+
+    /**
+     * Pushes `request` to the scheduler, or keeps it for later behind those already kept.<br>
+     */
+    void forward(Request& request);
+
+    /**
+     * Pushes the kept requests; once they are all through, decodes again what was left buffered.<br>
+     */
+    void retry();
+
+    /**
+     * Closes a kid's connection and tells the scheduler, after every message it had buffered.<br>
+     */
+    void hangUp(short session);
+
+    /**
+     * Writes the output of the kids in `dirty`, hanging up on any that have gone.<br>
+     */
+    void flushDirty();
+
+    /**
+     * Pushes out what is still queued for up to `flushSeconds`.<br>
+     */
+    void finish();
+
+public:
+    /**
+     * Starts the lane's thread.<br>
+     * @param io Engine kind to create for the lane<br>
+     * @param requests The scheduler's queue<br>
+     * @param scheduler The scheduler's doorbell<br>
+     */
+    IoLane(IoEngineKind io, MpmcRing<Request>& requests, Doorbell& scheduler);
+
+    /**
+     * Stops the thread if stop() wasn't called, then closes every connection.<br>
+     */
+    ~IoLane();
+    IoLane(const IoLane&) = delete;
+    IoLane& operator=(const IoLane&) = delete;
+
+    /**
+     * Scheduler thread: swaps `reply` onto the lane's queue, waiting for room if it is full.<br>
+     */
+    void post(Reply& reply);
+
+    /**
+     * Scheduler thread: asks the lane to send what it has been posted, flush for up to `seconds`, and stop.<br>
+     */
+    void stop(double seconds);
+
+    /**
+     * Waits for the lane's thread to finish.<br>
+     */
+    void join();
+
+    /**
+     * @return The lane's engine name, for reports; only after join()<br>
+     */
+    string engineName() const { return engine->name(); }
+
+    long requestsForwarded() const { return forwarded; }   ///< Only after join()<br>
+    long repliesDelivered() const { return delivered; }    ///< Only after join()<br>
+    long stallCount() const { return stalls; }              ///< Only after join()<br>
+    long wakeups() const { return bell->rings(); }
+};
@@ -11,9 +11,9 @@
  * -------------------------------------------------------<br>
  */
 Job::Job() {
-    slow = rand() % 5 + 1;
-    dirty = rand() % 5 + 1;
-    heavy = rand() % 5 + 1;
+    slow = randomInt(5) + 1;
+    dirty = randomInt(5) + 1;
+    heavy = randomInt(5) + 1;
     value = slow * (dirty + heavy);
     status = JobStatus::NOT_STARTED;
 };
@@ -27,13 +27,25 @@ Job::Job() {
  * -------------------------------------------------------<br>
  */
 Job::Job(short index) : jobNumber(index) {
-    slow = rand() % 5 + 1;
-    dirty = rand() % 5 + 1;
-    heavy = rand() % 5 + 1;
+    slow = randomInt(5) + 1;
+    dirty = randomInt(5) + 1;
+    heavy = randomInt(5) + 1;
     value = slow * (dirty + heavy);
     status = JobStatus::NOT_STARTED;
 };
 
+/**
+ * Attribute Constructor<br>
+ * -------------------------------------------------------<br>
+ * - Takes `slow`, `dirty`, and `heavy` as given instead of rolling them. <br>
+ * - Calculates the value the same way and sets the status to `NOT_STARTED`. <br>
+ * -------------------------------------------------------<br>
+ */
+Job::Job(short slow, short dirty, short heavy)
+    : jobNumber(0), slow(slow), dirty(dirty), heavy(heavy), value(slow * (dirty + heavy)), kidID(0) {
+    status = JobStatus::NOT_STARTED;
+}
+
 /**
  * Assigns a job to a kid<br>
  * -------------------------------------------------------<br>
@@ -13,6 +13,8 @@
  * - `value`: Calculated as slow × (dirty + heavy)<br>
  * - `status`: Current status of the job (NOT_STARTED, WORKING, COMPLETE)<br>
  * - `kidID`: ID of the kid currently working on or who completed the job<br>
+ * - `generation`: Which job this is of all those its slot has held<br>
+ * - `deadline`: Optional; seconds Mom allows from taking the job in to its completion<br>
  * -------------------------------------------------------<br>
  */
 class Job {
@@ -23,9 +25,11 @@ private:
     short heavy;      ///< Weight/difficulty level of the job<br>
     short value;      ///< Total value (score) of the job<br>
     short kidID;      ///< ID of the kid assigned to the job<br>
+    uint16_t generation = 0; ///< Times Mom has refilled this job's slot; claims must name it<br>
 
 public:
     JobStatus status; ///< Current status of the job<br>
+    double deadline = 0; ///< Seconds from Mom taking it in until it must be done; 0 for none (Mom-side only, never sent)<br>
 
     /**
      * Default constructor<br>
@@ -41,6 +45,12 @@ public:
      */
     Job(short index);
 
+    /**
+     * Constructor with given attributes<br>
+     * Computes the value and initializes status to NOT_STARTED; jobNumber is 0<br>
+     */
+    Job(short slow, short dirty, short heavy);
+
     ~Job() = default;
 
     /**
@@ -63,8 +73,15 @@ public:
      */
     ostream& print(ostream& os) const;
 
+    /**
+     * @return The job's value (score)<br>
+     */
+    short getValue() const { return value; }
+
     friend class Kid;
     friend class Mom;
+    friend class TableCodec;
+    friend class Replay;
 };
 
 /**
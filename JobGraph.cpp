@@ -0,0 +1,98 @@
+#include "JobGraph.hpp"
+#include <fcntl.h>
+
+/**
+ * Reads the graph and lays it out for handing out. <br>
+ * -------------------------------------------------------
+ * - The file is read whole and parsed in place. Each job line gives three
+ *   attributes (1-5) and any number of parents, all numbers earlier than
+ *   its own; spaces, tabs and a trailing CR are ignored.
+ * - Parents are gathered per job as the lines go by, then turned around
+ *   into children per parent with a counting pass, so the edges are
+ *   copied once and never sorted.
+ * - Jobs with no parents start out in the ready queue, in file order.
+ * -------------------------------------------------------
+ */
+JobGraph::JobGraph(const string& path) : path(path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) fatal("Can't open job graph " + path);
+    string text;
+    char chunk[65536];
+    ssize_t got;
+    while ((got = read(fd, chunk, sizeof(chunk))) > 0) text.append(chunk, got);
+    close(fd);
+    if (got < 0) fatal("Can't read job graph " + path);
+
+    vector<uint32_t> firstParent = {0};
+    vector<uint32_t> parents;
+    size_t lineNumber = 0;
+    auto malformed = [&](const string& why) { fatal(why + " in " + path + " line " + to_string(lineNumber)); };
+    for (size_t at = 0; at < text.size();) {
+        size_t newline = text.find('\n', at);
+        size_t end = newline == string::npos ? text.size() : newline;
+        const char* c = text.data() + at;
+        const char* stop = text.data() + end;
+        at = end + 1;
+        lineNumber++;
+        while (c < stop && (*c == ' ' || *c == '\t' || *c == '\r')) c++;
+        if (c == stop || *c == '#' || isalpha(static_cast<unsigned char>(*c))) continue;
+        uint64_t node = pending.size();
+        if (node >= UINT32_MAX) malformed("Too many jobs");
+        int field = 0;
+        for (;;) {
+            uint64_t value = 0;
+            bool digits = false;
+            while (c < stop && (*c == ' ' || *c == '\t' || *c == '\r')) c++;
+            for (; c < stop && *c >= '0' && *c <= '9'; c++) {
+                value = value * 10 + (*c - '0');
+                if (value > UINT32_MAX) malformed("Job number too large");
+                digits = true;
+            }
+            while (c < stop && (*c == ' ' || *c == '\t' || *c == '\r')) c++;
+            if (!digits) malformed("Malformed job");
+            if (field < 3) {
+                if (value < 1 || value > 5) malformed("Job attributes are 1-5");
+                attributes.push_back(value);
+            }
+            else {
+                if (value >= node) malformed("A job's parents must come before it");
+                parents.push_back(value);
+            }
+            field++;
+            if (c == stop) break;
+            if (*c++ != ',') malformed("Malformed job");
+        }
+        if (field < 3) malformed("Malformed job");
+        firstParent.push_back(parents.size());
+        pending.push_back(field - 3);
+    }
+
+    size_t jobs = pending.size();
+    firstChild.assign(jobs + 1, 0);
+    for (uint32_t parent : parents) firstChild[parent + 1]++;
+    for (size_t i = 0; i < jobs; i++) firstChild[i + 1] += firstChild[i];
+    children.resize(parents.size());
+    vector<uint32_t> fill(firstChild.begin(), firstChild.end() - 1);
+    for (uint32_t child = 0; child < jobs; child++)
+        for (uint32_t k = firstParent[child]; k < firstParent[child + 1]; k++)
+            children[fill[parents[k]]++] = child;
+
+    ready.reserve(jobs);
+    for (uint32_t node = 0; node < jobs; node++)
+        if (pending[node] == 0) ready.push_back(node);
+    mostReady = ready.size();
+}
+
+bool JobGraph::takeReady(uint32_t& node, Job& job) {
+    if (head == ready.size()) return false;
+    node = ready[head++];
+    job = Job(attributes[3 * node], attributes[3 * node + 1], attributes[3 * node + 2]);
+    return true;
+}
+
+void JobGraph::complete(uint32_t node) {
+    done++;
+    for (uint32_t k = firstChild[node]; k < firstChild[node + 1]; k++)
+        if (--pending[children[k]] == 0) ready.push_back(children[k]);
+    mostReady = max(mostReady, ready.size() - head);
+}
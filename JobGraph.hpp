@@ -0,0 +1,69 @@
+#pragma once
+#include "tools.hpp"
+#include "Job.hpp"
+
+/**
+ * @class JobGraph<br>
+ * Jobs with prerequisites: a job is handed out only once its parents are done.<br>
+ * -------------------------------------------------------<br>
+ * - Read from a CSV file, one `slow,dirty,heavy[,parent,...]` line per job.
+ *   Jobs are numbered from 0 in file order; blank lines and lines starting
+ *   with `#` or a letter don't count. A parent is named by its number and
+ *   must come earlier in the file, so the graph can't have a cycle.<br>
+ * - Each job keeps a count of parents not yet complete. Children are kept
+ *   in one flat array indexed by parent (compressed rows), built once.<br>
+ * - Jobs whose count is zero wait in the ready queue, oldest first. A job
+ *   enters it exactly once, so the queue is one preallocated array and an
+ *   index; taking a job is a read, completing one touches only its own
+ *   children. Nothing is ever rescanned, however large the graph.<br>
+ * - Runs on Mom's thread: readiness depends on completions she records,
+ *   so there is nothing to make ahead.<br>
+ * -------------------------------------------------------<br>
+ */
+class JobGraph {
+private:
+    string path;                  ///< File the graph was read from<br>
+    vector<uint8_t> attributes;   ///< slow, dirty, heavy for each job<br>
+    vector<uint32_t> pending;     ///< Parents of each job not yet complete<br>
+    vector<uint32_t> firstChild;  ///< Where each job's children start in `children`; one extra entry at the end<br>
+    vector<uint32_t> children;    ///< Children of every job, grouped by parent<br>
+    vector<uint32_t> ready;       ///< Every job that has become ready, in order<br>
+    size_t head = 0;              ///< First job in `ready` not yet handed out<br>
+    size_t done = 0;              ///< Jobs completed<br>
+    size_t mostReady = 0;         ///< Longest the ready queue has been<br>
+
+public:
+    /**
+     * Reads the graph in `path`.<br>
+     * @throws Terminates the program if the file can't be read or a line is malformed.<br>
+     */
+    explicit JobGraph(const string& path);
+
+    /**
+     * Takes the oldest ready job.<br>
+     * @param node Set to the job's number<br>
+     * @return false if no job is ready<br>
+     */
+    bool takeReady(uint32_t& node, Job& job);
+
+    /**
+     * Records job `node` as complete and queues every child it was the last parent of.<br>
+     */
+    void complete(uint32_t node);
+
+    /**
+     * @return true once every job is complete<br>
+     */
+    bool finished() const { return done == pending.size(); }
+
+    /**
+     * @return Short description for Mom's report<br>
+     */
+    string name() const { return "graph " + path; }
+
+    size_t size() const { return pending.size(); }
+    size_t edges() const { return children.size(); }
+    size_t completed() const { return done; }
+    size_t waiting() const { return ready.size() - head; }
+    size_t longestQueue() const { return mostReady; }
+};
@@ -0,0 +1,251 @@
+#include "JobSource.hpp"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/un.h>
+
+/**
+ * Parses one CSV job line in [at, end), which holds no newline. <br>
+ * -------------------------------------------------------
+ * - `slow,dirty,heavy`, each 1-5, optionally followed by `,deadline` in
+ *   whole seconds (1-86400); spaces, tabs and a trailing CR are ignored.
+ * - Blank lines and lines starting with `#` or a letter are skipped quietly.
+ * -------------------------------------------------------
+ * @return 1 for a job, 0 for a line to skip, -1 for a malformed line.
+ */
+static int parseCsvJob(const char* at, const char* end, Job& job) {
+    while (at < end && (*at == ' ' || *at == '\t' || *at == '\r')) at++;
+    if (at == end || *at == '#' || isalpha(static_cast<unsigned char>(*at))) return 0;
+    int fields[4] = {0, 0, 0, 0};
+    int field = 0;
+    bool digits = false;
+    for (; at < end; at++) {
+        char c = *at;
+        if (c >= '0' && c <= '9') {
+            if (fields[field] > (field < 3 ? 5 : 86400)) return -1;
+            fields[field] = fields[field] * 10 + (c - '0');
+            digits = true;
+        }
+        else if (c == ',') {
+            if (!digits || ++field > 3) return -1;
+            digits = false;
+        }
+        else if (c != ' ' && c != '\t' && c != '\r') return -1;
+    }
+    if (field < 2 || !digits) return -1;
+    for (int k = 0; k < 3; k++)
+        if (fields[k] < 1 || fields[k] > 5) return -1;
+    if (field == 3 && (fields[3] < 1 || fields[3] > 86400)) return -1;
+    job = Job(fields[0], fields[1], fields[2]);
+    job.deadline = fields[3];
+    return 1;
+}
+
+unique_ptr<JobSource> JobSource::open(const string& spec) {
+    if (spec == "random") return make_unique<RandomJobSource>();
+    if (spec == "-") return make_unique<StreamJobSource>(STDIN_FILENO, false, "on standard input");
+    if (spec.rfind("unix:", 0) == 0) {
+        string path = spec.substr(5);
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        if (path.size() >= sizeof(addr.sun_path)) fatal("Job socket path too long: " + path);
+        strcpy(addr.sun_path, path.c_str());
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0 || connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0)
+            fatal("Can't connect to job socket " + path);
+        return make_unique<StreamJobSource>(fd, true, "from " + path);
+    }
+    struct stat info;
+    if (stat(spec.c_str(), &info) < 0) fatal("Can't find job source " + spec);
+    if (S_ISFIFO(info.st_mode)) {
+        int fd = ::open(spec.c_str(), O_RDONLY);
+        if (fd < 0) fatal("Can't open job pipe " + spec);
+        return make_unique<StreamJobSource>(fd, true, "from " + spec);
+    }
+    return make_unique<FileJobSource>(spec);
+}
+
+FileJobSource::FileJobSource(const string& path) : path(path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) fatal("Can't open job file " + path);
+    struct stat info;
+    if (fstat(fd, &info) < 0) {
+        close(fd);
+        fatal("Can't read job file " + path);
+    }
+    size = info.st_size;
+    if (size > 0) {
+        void* map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map == MAP_FAILED) {
+            close(fd);
+            fatal("Can't map job file " + path);
+        }
+        madvise(map, size, MADV_SEQUENTIAL);
+        data = static_cast<const char*>(map);
+        binary = data[0] >= 1 && data[0] <= 5;
+    }
+    close(fd);
+}
+
+FileJobSource::~FileJobSource() {
+    if (data) munmap(const_cast<char*>(data), size);
+}
+
+/**
+ * Takes the next record from the mapping. <br>
+ * -------------------------------------------------------
+ * - Malformed records (an attribute out of range, a truncated binary
+ *   record, a CSV line that doesn't parse) are counted and skipped.
+ * - Every JOB_FILE_RELEASE bytes, the whole pages behind `at` are
+ *   dropped with MADV_DONTNEED; the kernel reads them again only if
+ *   they are touched, which they won't be.
+ * -------------------------------------------------------
+ */
+bool FileJobSource::next(Job& job) {
+    static const size_t page = sysconf(_SC_PAGESIZE);
+    for (;;) {
+        if (at - released >= JOB_FILE_RELEASE) {
+            size_t upto = at / page * page;
+            madvise(const_cast<char*>(data) + released, upto - released, MADV_DONTNEED);
+            released = upto;
+        }
+        if (at >= size) return false;
+        if (binary) {
+            if (size - at < 3) {
+                bad++;
+                at = size;
+                return false;
+            }
+            const uint8_t* record = reinterpret_cast<const uint8_t*>(data) + at;
+            at += 3;
+            if (record[0] >= 1 && record[0] <= 5 && record[1] >= 1 && record[1] <= 5 && record[2] >= 1 && record[2] <= 5) {
+                job = Job(record[0], record[1], record[2]);
+                return true;
+            }
+            bad++;
+            continue;
+        }
+        const char* line = data + at;
+        const char* newline = static_cast<const char*>(memchr(line, '\n', size - at));
+        const char* end = newline ? newline : data + size;
+        at = end - data + (newline ? 1 : 0);
+        int parsed = parseCsvJob(line, end, job);
+        if (parsed > 0) return true;
+        if (parsed < 0) bad++;
+    }
+}
+
+StreamJobSource::~StreamJobSource() {
+    if (owned) close(fd);
+}
+
+/**
+ * Takes the next whole line from the stream. <br>
+ * -------------------------------------------------------
+ * - Lines already in the buffer are parsed where they lie.
+ * - Only when no whole line is left is the unparsed tail moved to the
+ *   front and more read; at end of stream a last line without a newline
+ *   still counts.
+ * -------------------------------------------------------
+ */
+bool StreamJobSource::next(Job& job) {
+    for (;;) {
+        const char* start = buffer.data() + head;
+        size_t left = buffer.size() - head;
+        const char* newline = left > 0 ? static_cast<const char*>(memchr(start, '\n', left)) : nullptr;
+        if (newline || (ended && left > 0)) {
+            const char* end = newline ? newline : start + left;
+            head += end - start + (newline ? 1 : 0);
+            int parsed = parseCsvJob(start, end, job);
+            if (parsed > 0) return true;
+            if (parsed < 0) bad++;
+            continue;
+        }
+        if (ended || stopped) return false;
+        if (head > 0) {
+            buffer.erase(0, head);
+            head = 0;
+        }
+        pollfd input{fd, POLLIN, 0};
+        int ready = poll(&input, 1, 100);
+        if (ready < 0 && errno != EINTR) ended = true;
+        if (ready <= 0) continue;
+        size_t had = buffer.size();
+        buffer.resize(had + JOB_STREAM_CHUNK);
+        long nBytes = read(fd, buffer.data() + had, JOB_STREAM_CHUNK);
+        buffer.resize(had + max(nBytes, 0L));
+        if (nBytes == 0 || (nBytes < 0 && errno != EINTR && errno != EAGAIN)) ended = true;
+    }
+}
+
+bool ShardedJobSource::next(Job& job) {
+    while (source->next(job))
+        if (ring.owner(serial++) == self) return true;
+    return false;
+}
+
+JobProducer::JobProducer(unique_ptr<JobSource> source, size_t capacity)
+    : source(std::move(source)), ring(capacity, Job(1, 1, 1)) {
+    producer = thread(&JobProducer::produce, this, static_cast<unsigned>(randomInt(numeric_limits<int>::max())));
+}
+
+JobProducer::~JobProducer() {
+    stopping = true;
+    source->stop();
+    {
+        lock_guard<mutex> lock(sleepLock);
+        wake.notify_one();
+    }
+    producer.join();
+}
+
+/**
+ * Producer loop. <br>
+ * -------------------------------------------------------
+ * - Keeps one job in hand and pushes it as soon as there is room; stops
+ *   once the source runs dry.
+ * - When the ring is full, sleeps until it is down to half. `sleeping`
+ *   is set before the ring is checked again, and next() checks it after
+ *   popping, so one of the two always sees the other.
+ * -------------------------------------------------------
+ */
+void JobProducer::produce(unsigned seed) {
+    seedRandom(seed);
+    Job job(1, 1, 1);
+    bool have = source->next(job);
+    while (have && !stopping) {
+        if (ring.push(job)) {
+            have = source->next(job);
+            continue;
+        }
+        unique_lock<mutex> lock(sleepLock);
+        sleeping = true;
+        wake.wait(lock, [&] { return stopping || ring.size() <= ring.capacity() / 2; });
+        sleeping = false;
+    }
+    finished = true;
+}
+
+/**
+ * Pops a ready job. <br>
+ * -------------------------------------------------------
+ * - A streaming source may not send anything for a long time, so an
+ *   empty ring means "nothing yet" and Mom is never kept waiting.
+ * - Otherwise the producer is only briefly behind, so wait for it; jobs
+ *   come out the same however the threads are scheduled.
+ * -------------------------------------------------------
+ */
+bool JobProducer::next(Job& job) {
+    if (!ring.pop(job)) {
+        if (streaming() || finished) return ring.pop(job);
+        emptyPops++;
+        while (!ring.pop(job)) {
+            if (finished) return ring.pop(job);
+            this_thread::yield();
+        }
+    }
+    if (sleeping && ring.size() <= ring.capacity() / 2) {
+        lock_guard<mutex> lock(sleepLock);
+        wake.notify_one();
+    }
+    return true;
+}
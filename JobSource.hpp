@@ -0,0 +1,236 @@
+#pragma once
+#include "tools.hpp"
+#include "Job.hpp"
+#include "SpscRing.hpp"
+#include "HashRing.hpp"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#define JOB_RING 1024   ///< Ready jobs a JobProducer keeps ahead of Mom<br>
+#define JOB_FILE_RELEASE (64 << 20) ///< Bytes of a mapped job file read before its pages are given back<br>
+#define JOB_STREAM_CHUNK 65536      ///< Bytes read from a job stream at a time<br>
+
+/**
+ * @class JobSource<br>
+ * Supplies the jobs Mom puts in empty slots.<br>
+ * -------------------------------------------------------<br>
+ * - Mom always runs her source behind a JobProducer, so next() on the
+ *   source itself is called on the producer thread and may take its time.<br>
+ * - Mom numbers each job after its slot herself.<br>
+ * - A slot with no job to put in it stays vacant (COMPLETE, so no kid
+ *   claims it) until the source has one.<br>
+ * -------------------------------------------------------<br>
+ */
+class JobSource {
+public:
+    virtual ~JobSource() = default;
+
+    /**
+     * Builds the source named on the command line. <br>
+     * - `random`: rolled jobs, as always.<br>
+     * - `-`: a stream of CSV lines on standard input.<br>
+     * - `unix:PATH`: a stream of CSV lines from the Unix socket at PATH.<br>
+     * - A FIFO: a stream of CSV lines.<br>
+     * - Any other file: mapped, as CSV or binary records.<br>
+     * @throws Terminates the program if the file or socket can't be opened.<br>
+     */
+    static unique_ptr<JobSource> open(const string& spec);
+
+    /**
+     * @return Short description for Mom's report<br>
+     */
+    virtual string name() const = 0;
+
+    /**
+     * Takes the next job.<br>
+     * @return false once the source has run dry<br>
+     */
+    virtual bool next(Job& job) = 0;
+
+    /**
+     * @return true if next() waits on another process, so nobody should wait on next()<br>
+     */
+    virtual bool streaming() const { return false; }
+
+    /**
+     * Asks a next() blocked on input to give up; called from another thread.<br>
+     */
+    virtual void stop() {}
+
+    /**
+     * @return Times next() had to wait for a job to be ready<br>
+     */
+    virtual long waits() const { return 0; }
+
+    /**
+     * @return Malformed job definitions skipped so far<br>
+     */
+    virtual long rejected() const { return 0; }
+};
+
+/**
+ * @class RandomJobSource<br>
+ * The original supply: rolls slow, dirty and heavy on the calling thread.<br>
+ */
+class RandomJobSource : public JobSource {
+public:
+    string name() const override { return "random"; }
+    bool next(Job& job) override { job = Job(); return true; }
+};
+
+/**
+ * @class FileJobSource<br>
+ * Reads job definitions from a memory-mapped file, front to back.<br>
+ * -------------------------------------------------------<br>
+ * - Binary files are three bytes per job: slow, dirty, heavy (each 1-5).<br>
+ * - CSV files are one `slow,dirty,heavy[,deadline]` line per job; blank lines and
+ *   lines starting with a letter or `#` (headers, comments) are skipped.<br>
+ * - A file whose first byte is 1-5 is binary; anything else is CSV.<br>
+ * - Jobs are parsed straight out of the mapping; nothing is copied.<br>
+ * - Pages are read ahead sequentially and handed back to the kernel every
+ *   JOB_FILE_RELEASE bytes, so a file of tens of millions of jobs never
+ *   has to be resident at once.<br>
+ * -------------------------------------------------------<br>
+ */
+class FileJobSource : public JobSource {
+private:
+    string path;                  ///< File being read<br>
+    const char* data = nullptr;   ///< Start of the mapping<br>
+    size_t size = 0;              ///< Bytes mapped<br>
+    size_t at = 0;                ///< Next byte to parse<br>
+    size_t released = 0;          ///< Bytes whose pages have been handed back<br>
+    bool binary = false;          ///< Three-byte records rather than CSV<br>
+    atomic<long> bad{0};          ///< Malformed records skipped<br>
+
+public:
+    /**
+     * Maps `path`.<br>
+     * @throws Terminates the program if the file can't be opened or mapped.<br>
+     */
+    explicit FileJobSource(const string& path);
+    ~FileJobSource() override;
+
+    string name() const override { return (binary ? "binary file " : "CSV file ") + path; }
+    bool next(Job& job) override;
+    long rejected() const override { return bad; }
+};
+
+/**
+ * @class StreamJobSource<br>
+ * Reads CSV job lines as they arrive on a pipe or socket.<br>
+ * -------------------------------------------------------<br>
+ * - Input is read JOB_STREAM_CHUNK bytes at a time into one buffer and
+ *   parsed in place; a line cut off at the end of a read waits there for
+ *   the rest of it.<br>
+ * - next() blocks until a whole line has arrived, waking every 100 ms to
+ *   notice stop(). It returns false at end of stream.<br>
+ * - Lines are parsed the same way as in a CSV file.<br>
+ * -------------------------------------------------------<br>
+ */
+class StreamJobSource : public JobSource {
+private:
+    int fd;                       ///< Pipe or socket to read<br>
+    bool owned;                   ///< Close `fd` when done (not standard input)<br>
+    string description;           ///< What `fd` is, for the report<br>
+    string buffer;                ///< Bytes read and not yet parsed<br>
+    size_t head = 0;              ///< Parse position in `buffer`<br>
+    bool ended = false;           ///< End of stream reached<br>
+    atomic<bool> stopped{false};  ///< stop() was called<br>
+    atomic<long> bad{0};          ///< Malformed lines skipped<br>
+
+public:
+    StreamJobSource(int fd, bool owned, string description) : fd(fd), owned(owned), description(std::move(description)) {}
+    ~StreamJobSource() override;
+
+    string name() const override { return "stream " + description; }
+    bool next(Job& job) override;
+    bool streaming() const override { return true; }
+    void stop() override { stopped = true; }
+    long rejected() const override { return bad; }
+};
+
+/**
+ * @class ShardedJobSource<br>
+ * One Mom's share of a job supply split across a cluster.<br>
+ * -------------------------------------------------------<br>
+ * - Jobs are numbered in the order the wrapped source makes them; job k
+ *   is kept if the cluster's HashRing gives key k to this Mom and skipped
+ *   otherwise. Every Mom reading the same file therefore takes a disjoint
+ *   share of it without talking to the others.<br>
+ * - Skipping happens in next(), so behind a JobProducer it costs the
+ *   producer thread, not Mom.<br>
+ * -------------------------------------------------------<br>
+ */
+class ShardedJobSource : public JobSource {
+private:
+    unique_ptr<JobSource> source; ///< The whole supply<br>
+    HashRing ring;                ///< Cluster membership<br>
+    short self;                   ///< This Mom's index on `ring`<br>
+    uint64_t serial = 0;          ///< Number of the next job `source` makes<br>
+
+public:
+    ShardedJobSource(unique_ptr<JobSource> source, HashRing ring, short self)
+        : source(std::move(source)), ring(std::move(ring)), self(self) {}
+
+    string name() const override {
+        return source->name() + ", shard " + to_string(self + 1) + " of " + to_string(ring.nodes().size());
+    }
+    bool next(Job& job) override;
+    bool streaming() const override { return source->streaming(); }
+    void stop() override { source->stop(); }
+    long rejected() const override { return source->rejected(); }
+};
+
+/**
+ * @class JobProducer<br>
+ * Runs another JobSource on a background thread, ahead of demand.<br>
+ * -------------------------------------------------------<br>
+ * - The producer thread fills an SpscRing of ready jobs; next() pops one,
+ *   so Mom pays for a copy instead of building the job.<br>
+ * - Once the ring is full the producer sleeps until Mom has taken half
+ *   of it. Mom only touches the lock when the producer is asleep.<br>
+ * - If the ring ever runs dry, next() yields until the producer catches
+ *   up, unless the source is streaming or has run dry: then it returns
+ *   false and Mom tries again later. Jobs always come out in the order
+ *   the source made them.<br>
+ * - The producer seeds its own random generator from the constructing
+ *   thread's, so a seeded run makes the same jobs every time.<br>
+ * -------------------------------------------------------<br>
+ */
+class JobProducer : public JobSource {
+private:
+    unique_ptr<JobSource> source;     ///< Source run on the producer thread<br>
+    SpscRing<Job> ring;               ///< Jobs made but not yet handed out<br>
+    mutex sleepLock;                  ///< Guards the producer going to sleep<br>
+    condition_variable wake;          ///< Signalled when the ring is half empty or on shutdown<br>
+    atomic<bool> sleeping{false};     ///< The producer is waiting on `wake`<br>
+    atomic<bool> stopping{false};     ///< Destructor has asked the producer to exit<br>
+    atomic<bool> finished{false};     ///< The source has run dry and everything it made is in `ring`<br>
+    long emptyPops = 0;               ///< next() calls that found the ring empty<br>
+    thread producer;                  ///< Fills `ring` from `source`<br>
+
+    /**
+     * Body of the producer thread.<br>
+     */
+    void produce(unsigned seed);
+
+public:
+    /**
+     * Starts the producer thread.<br>
+     * @param source Jobs to make ahead<br>
+     * @param capacity Ready jobs to keep<br>
+     */
+    explicit JobProducer(unique_ptr<JobSource> source, size_t capacity = JOB_RING);
+
+    /**
+     * Stops and joins the producer thread.<br>
+     */
+    ~JobProducer() override;
+
+    string name() const override { return source->name() + ", made ahead"; }
+    bool next(Job& job) override;
+    bool streaming() const override { return source->streaming(); }
+    long waits() const override { return emptyPops; }
+    long rejected() const override { return source->rejected(); }
+};
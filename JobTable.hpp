@@ -2,25 +2,40 @@
 #include "tools.hpp"
 #include "Job.hpp"
 
+#define JOB_SLOTS 10        ///< Default number of job slots<br>
+#define MAX_JOB_SLOTS 16384 ///< Largest table Mom will run<br>
+#define ROW_SHORTS 7        ///< Shorts per slot in the rows encoding<br>
+
 /**
  * @class JobTable<br>
- * Stores and manages a fixed-size list of Job objects.<br>
+ * Stores and manages the list of Job objects.<br>
  * -------------------------------------------------------<br>
- * - Contains 10 Job slots used by the Mom and accessed by the Kids.<br>
+ * - Contains JOB_SLOTS Job slots by default; Mom may run a larger table,
+ *   and a Kid's copy takes whatever size Mom sends.<br>
  * - Includes a `quitFlag` to indicate when to stop job processing.<br>
  * - Provides controlled access to job entries through friend classes.<br>
  */
 class JobTable {
 private:
-  Job jobs[10]{};   ///< Array of 10 Job objects<br>
-  bool quitFlag;    ///< True if kids should continue working<br>
+  vector<Job> jobs;   ///< One Job per slot<br>
+  bool quitFlag;      ///< True if kids should continue working<br>
 
 public:
   /**
    * Default Constructor<br>
    * Initializes the quit flag to true.<br>
    */
-  JobTable() : quitFlag(true) {}
+  explicit JobTable(short slots = JOB_SLOTS) : jobs(slots), quitFlag(true) {}
+
+  /**
+   * @return Number of job slots<br>
+   */
+  short size() const { return jobs.size(); }
+
+  /**
+   * Changes the number of slots; new slots hold fresh random jobs.<br>
+   */
+  void resize(short slots) { jobs.resize(slots); }
 
   /**
    * (Optional) Print Function<br>
@@ -32,4 +47,6 @@ public:
   // Granting friend access to allow direct job manipulation
   friend class Kid;
   friend class Mom;
+  friend class TableCodec;
+  friend class Replay;
 };
@@ -4,46 +4,26 @@
 /**
  * Constructor for the Kid class. <br>
  * -------------------------------------------------------
- * - Initializes a TCP socket for the kid.
- * - Resolves localhost and configures socket address.
- * - Connects to the Mom (server) on the predefined port.
- * - Prints client socket information upon successful connection. <br>
+ * - Connects to the Mom (server) on `port` over the chosen transport.
+ * - TCP resolves localhost and prints client socket information;
+ *   UNIX and SHM use Mom's socket file on the same host.
+ * - With `useSnapshot`, maps Mom's shared-memory job table so table reads
+ *   need no round trip; the link is then only used for claims and completions. <br>
  * -------------------------------------------------------
+ * @param transport How to reach Mom.
+ * @param useSnapshot Read the table from shared memory.
+ * @param port Port (or socket-file suffix) of the Mom to join.
  */
-Kid::Kid():inProgress(nullptr){
-
-    // ================================================================
-    // Install a socket in the client's file table.
-    // Make an internet-transmitted, file-i/o-style, protocol-whatever plug
-    clientSock = socket( AF_INET, SOCK_STREAM, 0 );
-    if ( clientSock<0 ) fatal( "Can't assign fd for client socket");
-
-    // ================================================================
-    // Use a domain name server to get the IP address associated with the host.
-    // The name server returns a list of IP addresses.  We want the first one.
-    hostInfo* remoteHost = gethostbyname(LOCALHOST);
-    if(remoteHost == nullptr) fatal("unknown host: "+string(LOCALHOST)+"\n");
-
-    // ================================================================
-    // This series of system calls sets up the client's socket structure.
-    sockInfo clientInfo;
-    clientInfo.sin_family = AF_INET;	// Address family internet
-
-    // Copy info about the server into the client's socket structure.
-    memmove( &clientInfo.sin_addr, remoteHost->h_addr_list[0], remoteHost->h_length);
-
-    // Copy the agreed-upon port number into the client's socket structure.
-    // Convert it first from the local representation to the internet standard.
-    clientInfo.sin_port = htons( PORT );
-    printSockInfo( "client", clientInfo );
-
-    // ================================================================
-    // Info in the client struct is now complete and ready to connect to server.
-    int status = connect( clientSock, (sockUnion*) &clientInfo, sizeof clientInfo );
-    if ( status < 0 ) fatal("Connection to "+string(LOCALHOST)+" refused.");
-    cout <<"connection established to " <<LOCALHOST<<".\n";
+Kid::Kid(TransportKind transport, bool useSnapshot, int port):inProgress(nullptr){
+    link = Transport::connect(transport, port);
+    if (!useSnapshot) return;
+    snapshot = SharedTable::attach(port);
+    if (!snapshot) fatal("Mom's shared-memory table is not available");
 }
 
+Kid::Kid(unique_ptr<Transport> link, Clock& clock)
+    : inProgress(nullptr), link(std::move(link)), clock(&clock) {}
+
 /**
  * Reads a short message from the server.
  * -------------------------------------------------------
@@ -55,19 +35,22 @@ Kid::Kid():inProgress(nullptr){
  */
 short Kid::readData() {
     // wait for server to acknowledge the connection.
-    long nBytes = read( clientSock, &buf, sizeof(short));
-    if(!nBytes) throw 0;
+    if (!link->recvAll(&buf, sizeof(short))) throw 0;
     return buf;
 }
 
 /**
  * Sends a short message to the server.
  * -------------------------------------------------------
+ * - If Mom has already gone (say, she quit while the kid was mid-job),
+ *   throws an int so the kid winds down as it does on QUIT.
+ * -------------------------------------------------------
  * @param msg The short integer message to write to the socket.
+ * @throws int 0 if the link is closed.
  */
 void Kid::writeData(const short& msg) const {
-    long nBytes = write( clientSock, &msg, sizeof(short));
-    if( nBytes < 0 ) fatal("%s: Error while writing to socket.");
+    long nBytes = link->send(&msg, sizeof(short));
+    if( nBytes < 0 ) throw 0;
 }
 
 /**
@@ -76,7 +59,7 @@ void Kid::writeData(const short& msg) const {
  * Mood types: LAZY, PRISSY, OVERTIRED, GREEDY, COOPERATIVE.
  */
 void Kid::selectMood() {
-    mood = static_cast<Mood>(rand()%5);
+    mood = static_cast<Mood>(randomInt(5));
 }
 
 /**
@@ -99,58 +82,81 @@ bool Kid::moodChecker(const Job& job) const {
 }
 
 /**
- * Sends a job request to Mom and processes the response.
+ * Claims one job out of a list of candidates in a single round trip.
  * -------------------------------------------------------
- * - Sends WANT_JOB with job index.
- * - Receives ACK or NACK or QUIT.
- * - On ACK, assigns job to Kid.
- * - On NACK, returns false to keep searching.
- * - On QUIT, throws int to exit.
+ * - Sends WANT_JOBS (or DONE_AND_NEXT, reporting `done` first) asking for
+ *   one job: code, [done], wanted = 1, count, then each candidate's index
+ *   and the generation the kid saw there, so Mom never grants a job that
+ *   has replaced the one the kid chose.
+ * - Receives ACK, a bitmask of the candidates Mom granted and one of those
+ *   that were stale, or QUIT.
+ * - On a grant, assigns that job to the Kid.
+ * - Otherwise returns nullptr so the kid fetches a fresh table; a stale
+ *   candidate means that table will differ from the one it holds.
  * -------------------------------------------------------
- * @param job Job to be attempted.
- * @param index Index of the job in the table.
- * @return true if job was accepted; false if rejected.
+ * @param done Job just finished, or -1 for a plain claim.
+ * @param slots Candidate job indices, best first.
+ * @param count Number of candidates.
+ * @return The job granted; nullptr if every candidate was taken.
  * @throws int 0 if Mom sends QUIT.
  */
-bool Kid::wantJob(Job& job, const short index) {
-    writeData(static_cast<short>(messageCodes::WANT_JOB));
-    writeData(index);
-    readData();
-    ss<<messageCodes[buf]<<endl;
+Job* Kid::claimJob(const short done, const short* slots, const short count) {
+    double start = tracer ? tracer->now() : 0;
+    short request[4 + 2 * CLAIM_BATCH];
+    short length = 0;
+    request[length++] = static_cast<short>(done < 0 ? messageCodes::WANT_JOBS : messageCodes::DONE_AND_NEXT);
+    if (done >= 0) request[length++] = done;
+    request[length++] = 1;
+    request[length++] = count;
+    for (short k = 0; k < count; k++) {
+        request[length++] = slots[k];
+        request[length++] = static_cast<short>(table.jobs[slots[k]].generation);
+    }
+    if (link->send(request, length * sizeof(short)) < 0) throw 0;
+    if (readData() == static_cast<short>(messageCodes::QUIT)) throw 0;
+    uint16_t granted = readData();
+    uint16_t stale = readData();
+    short index = -1;
+    for (short k = 0; k < count && index < 0; k++)
+        if (granted & (1 << k)) index = slots[k];
+    if (tracer) tracer->span("claim", "round trip", tracePid, 0, start, Tracer::arg("candidates", count) + ","
+                             + Tracer::arg("slot", index) + "," + Tracer::arg("stale", __builtin_popcount(stale)));
+    ss<<messageCodes[static_cast<short>(index < 0 ? messageCodes::NACK : messageCodes::ACK)]<<endl;
+    if (stale != 0) ss<<"Job Table stale"<<endl;
     Printer::write(ss,cout);
-    if (buf == static_cast<short>(messageCodes::NACK)) return false;
-    if (buf == static_cast<short>(messageCodes::QUIT)) throw 0;
-    job.chooseJob(kidID,index);
-    inProgress = &job;
-    return true;
+    if (index < 0) return nullptr;
+    table.jobs[index].chooseJob(kidID,index);
+    return &table.jobs[index];
 }
 
 /**
- * Selects a job for non-cooperative moods.
+ * Lists jobs for non-cooperative moods.
  * -------------------------------------------------------
  * - Loops from beginning of job table.
- * - Tries to find the first job matching moodChecker.
- * - Sends WANT_JOB request for match.
+ * - Takes every NOT_STARTED job matching moodChecker, up to CLAIM_BATCH.
  */
-void Kid::non_Coop_Task_Select() {
-    for (short j=0; j<10;j++) {
+short Kid::non_Coop_Task_Select(short* slots) const {
+    short count = 0;
+    for (short j=0; j<table.size() && count<CLAIM_BATCH;j++) {
         if (table.jobs[j].status != JobStatus::NOT_STARTED ) continue;
-        if (moodChecker(table.jobs[j]) && wantJob(table.jobs[j], j)) break;
+        if (moodChecker(table.jobs[j])) slots[count++] = j;
     }
+    return count;
 }
 
 /**
- * Selects a job for cooperative kids.
+ * Lists jobs for cooperative kids.
  * -------------------------------------------------------
  * - Loops from end of job table backwards.
- * - Chooses last available NOT_STARTED job.
+ * - Takes the last NOT_STARTED jobs first, up to CLAIM_BATCH.
  */
-void Kid::coop_Task_Select() {
-
-    for ( short j = 9 ;j >= 0; j--) {
+short Kid::coop_Task_Select(short* slots) const {
+    short count = 0;
+    for ( short j = table.size() - 1 ;j >= 0 && count<CLAIM_BATCH; j--) {
         if (table.jobs[j].status != JobStatus::NOT_STARTED ) continue;
-        if (wantJob(table.jobs[j], j)) break;
+        slots[count++] = j;
     }
+    return count;
 }
 
 /**
@@ -159,14 +165,93 @@ void Kid::coop_Task_Select() {
  * - If mood is COOPERATIVE: use coop_Task_Select.
  * - Otherwise: use non_Coop_Task_Select.
  */
+short Kid::candidates(short* slots) const {
+    if (mood != Mood::COOPERATIVE) return non_Coop_Task_Select(slots);
+    return coop_Task_Select(slots);
+}
+
+/**
+ * Selects a job based on mood and claims it.
+ * -------------------------------------------------------
+ * - All candidates go to Mom in one WANT_JOBS, so a kid whose first
+ *   choices were taken still needs only one round trip.
+ */
 void Kid::selectJob() {
-    if (mood != Mood::COOPERATIVE) non_Coop_Task_Select();
-    else coop_Task_Select();
+    short slots[CLAIM_BATCH];
+    short count = candidates(slots);
+    if (count > 0) inProgress = claimJob(-1, slots, count);
+}
+
+/**
+ * Reserves the next job (pipelined mode).
+ * -------------------------------------------------------
+ * - Runs at the start of a job, so the table fetch and the claim overlap
+ *   the work instead of following it.
+ * - The job just finished (if it was followed by a reserved one) is
+ *   reported here too, as DONE_AND_NEXT, so nothing at all is sent
+ *   between one job and the next.
+ * - Mom holds each kid to a limit of reserved jobs and refuses claims
+ *   past it; the kid then simply has no reservation.
+ * -------------------------------------------------------
+ * @param done Finished job still to report, or -1.
+ */
+void Kid::reserveNext(const short done) {
+    parseJobTable();
+    short slots[CLAIM_BATCH];
+    short count = candidates(slots);
+    if (count > 0) reserved = claimJob(done, slots, count);
+    else if (done >= 0) {
+        short report[2] = {static_cast<short>(messageCodes::JOB_DONE), done};
+        if (link->send(report, sizeof(report)) < 0) throw 0;
+    }
+}
+
+/**
+ * Reports a finished job.
+ * -------------------------------------------------------
+ * - Picks the next candidates from the table the kid already holds and
+ *   sends them with the completion as DONE_AND_NEXT, so a kid that gets
+ *   one goes straight back to work: one round trip per job.
+ * - With no candidate left it sends a plain JOB_DONE, which has no reply.
+ * -------------------------------------------------------
+ * @param done Index of the finished job.
+ */
+void Kid::finishJob(const short done) {
+    short slots[CLAIM_BATCH];
+    short count = candidates(slots);
+    if (count > 0) {
+        inProgress = claimJob(done, slots, count);
+        return;
+    }
+    short request[2] = {static_cast<short>(messageCodes::JOB_DONE), done};
+    if (link->send(request, sizeof(request)) < 0) throw 0;
+}
+
+/**
+ * Backs off between table fetches that found nothing to take.
+ * -------------------------------------------------------
+ * - Without it an idle kid asks again as soon as the answer arrives, once
+ *   per round trip for the rest of the run: live, a core of Mom's goes to
+ *   answering it; simulated, time barely moves while the messages pile up.
+ * - The wait starts at KID_IDLE_MIN and doubles up to KID_IDLE_MAX, so a
+ *   job that turns up is seen within a tenth of a second; jobs take seconds.
+ *   Only NOT_MODIFIED lets it grow: a table that changed starts it over,
+ *   since the next change is likely close behind.
+ * - It goes on the kid's clock, so a simulated kid jumps ahead instead.
+ *   A kid reading the snapshot already sleeps until the table changes.
+ * -------------------------------------------------------
+ */
+void Kid::idle() {
+    if (snapshot) return;
+    idleFor = idleFor > 0 ? min(idleFor * 2, KID_IDLE_MAX) : KID_IDLE_MIN;
+    clock->sleepFor(idleFor);
 }
 
 /** Sending message to mom <br>
- * Name: NEED A JOB <br>
- * Receiving message from mom <br>
+ * Name: NEED A JOB SINCE, with the version of the table the kid holds <br>
+ * Receiving message from mom: NOT_MODIFIED if that table is still current
+ * (the kid keeps it), else ACK, the new version, and the table in the
+ * negotiated TableFormat. SHORTS is a slot count followed by one row per slot: <br>
  *  Field      | Description         | Example          <br>
  *  -----------|---------------------|----------------  <br>
  *  jobNumber  | Job ID number       | 1                <br>
@@ -175,31 +260,67 @@ void Kid::selectJob() {
  *  heavy      | Weight factor       | 3                <br>
  *  value      | Value of job        | 25               <br>
  *  status     | Job status enum     | 0 (NOT_STARTED)  <br>
+ *  generation | Slot refill count   | 4                <br>
+ *
+ * Job Number, Slow, Dirty, Heavy, Value, Status, Generation <br>
+ * 1 5 2 3 25 0 4<br>
  *
- * Job Number, Slow, Dirty, Heavy, Value, Status <br>
- * 1 5 2 3 25 0<br>
+ * PACKED is a 32-bit byte count followed by TableCodec's packed encoding. <br>
+ *
+ * With a shared-memory snapshot the same rows are copied out of the
+ * seqlock region instead; the kid only sleeps (futex) when the table
+ * has not changed since its last look. <br>
  */
 void Kid::parseJobTable() {
-    // Requesting for Job
-    writeData(static_cast<short>(messageCodes::NEED_JOB));
+    double start = tracer ? tracer->now() : 0;
+    bool decoded;
+    if (snapshot) {
+        bool quit;
+        rows.resize(snapshot->slots() * ROW_SHORTS);
+        snapshot->waitForChange(seenSeq);
+        seenSeq = snapshot->read(rows.data(), quit);
+        if (quit) throw 0;
+        decoded = TableCodec::decodeRows(rows.data(), snapshot->slots(), table);
+    }
+    else {
+        // Requesting for Job, in one write: the code and the version we hold
+        char request[sizeof(short) + sizeof(uint32_t)];
+        short code = static_cast<short>(messageCodes::NEED_JOB_SINCE);
+        memcpy(request, &code, sizeof(short));
+        memcpy(request + sizeof(short), &tableVersion, sizeof(uint32_t));
+        if (link->send(request, sizeof(request)) < 0) throw 0;
 
-    //If mom sends to QUIT signal, I will quit
-    //If mom sends ACKNOWLEDGE signal, I get the job table
-    if (readData() == static_cast<short>(messageCodes::QUIT)) throw 0;
-    short jobDesc[60];
-    long nBytes = read( clientSock, &jobDesc, sizeof(jobDesc));
-    if(!nBytes) throw 0;
+        //If mom sends to QUIT signal, I will quit
+        //If mom sends NOT_MODIFIED, the table I have is still right
+        //If mom sends ACKNOWLEDGE signal, I get the job table
+        if (readData() == static_cast<short>(messageCodes::QUIT)) throw 0;
+        if (buf == static_cast<short>(messageCodes::NOT_MODIFIED)) {
+            if (tracer) tracer->span("fetch table", "round trip", tracePid, 0, start, Tracer::arg("modified", 0L));
+            Printer::write("Job Table unchanged\n", cout);
+            return;
+        }
+        if (!link->recvAll(&tableVersion, sizeof(tableVersion))) throw 0;
+        idleFor = 0;
+        if (format == TableFormat::PACKED) {
+            uint32_t length;
+            if (!link->recvAll(&length, sizeof(length))) throw 0;
+            payload.resize(length);
+            if (!link->recvAll(payload.data(), length)) throw 0;
+            decoded = TableCodec::decodePacked(payload, table);
+        }
+        else {
+            short slots = readData();
+            if (slots < 0 || slots > MAX_JOB_SLOTS) fatal("Mom sent a job table of " + to_string(slots) + " slots");
+            rows.resize(slots * ROW_SHORTS);
+            if (!link->recvAll(rows.data(), rows.size() * sizeof(short))) throw 0;
+            decoded = TableCodec::decodeRows(rows.data(), slots, table);
+        }
+    }
+    if (!decoded) fatal("Malformed job table from Mom");
+    if (tracer) tracer->span(snapshot ? "read snapshot" : "fetch table", "round trip", tracePid, 0, start);
     ss<<"-----------------------------------------------------"<<endl;
     ss<<"Retrieving Job Table"<<endl;
-    for (short j=0;j<60;j+=6) {
-        Job job{};
-        job.jobNumber = jobDesc[j];
-        job.slow = jobDesc[j+1];
-        job.dirty = jobDesc[j+2];
-        job.heavy = jobDesc[j+3];
-        job.value = jobDesc[j+4];
-        job.status = static_cast<JobStatus>(jobDesc[j+5]);
-        table.jobs[job.jobNumber] = job;
+    for (const Job& job : table.jobs) {
         ss<<"Job number: "<<job.jobNumber <<" has been added"<<endl;
     }
     ss<<"Retrieved Job Table"<<endl;
@@ -210,39 +331,80 @@ void Kid::parseJobTable() {
 /**
  * Main loop for Kid behavior.
  * -------------------------------------------------------
- * - Gets assigned Kid ID and sets mood.
+ * - Gets assigned Kid ID (its session ID with Mom) and sets mood; leaves at once if Mom turns it away.
+ * - Asks Mom for its preferred table encoding; keeps SHORTS if she refuses.
+ * - Subscribes to its queues, if it was given any; a queue Mom doesn't have ends the kid.
  * - In loop:
- *     - Requests job table from Mom.
- *     - Selects job based on mood.
- *     - Sleeps for job's duration (simulating work).
- *     - Sends JOB_DONE to Mom when finished.
- * - Exits gracefully if Mom sends QUIT.
+ *     - Requests job table from Mom, unless the last report already won a job.
+ *     - Selects job based on mood; with nothing to take, waits a little
+ *       (see idle()) before asking again.
+ *     - Sleeps on its clock for job's duration (simulating work); in
+ *       pipelined mode the next job is reserved during that time.
+ *     - Reports it to Mom when finished, claiming the next job in the same
+ *       message, or starts the reserved job right away and reports the
+ *       finished one with the next reservation.
+ * - Exits gracefully if Mom sends QUIT or hangs up, even during the handshake.
  */
 void Kid::run() {
-    //Gets the ID
-    ss<<messageCodes[readData()]<<endl; //First Acknowledgement
-    Printer::write(ss,cout);
-    kidID = readData(); //KidID received
-    ss<<"Kid ID: "<<kidID<<endl;
-    Printer::write(ss,cout);
-    //Selects the mood of the kid
-    selectMood();
-    ss<<kidID<<" mood is: "<<moodName[static_cast<short>(mood)] <<endl;
-    Printer::write(ss, cout);
-
     try {
+        double start = tracer ? tracer->now() : 0;
+        //Gets the ID
+        ss<<messageCodes[readData()]<<endl; //First Acknowledgement
+        Printer::write(ss,cout);
+        if (buf == static_cast<short>(messageCodes::QUIT)) return; //Mom is full
+        kidID = readData(); //KidID received
+        ss<<"Kid ID: "<<kidID<<endl;
+        Printer::write(ss,cout);
+        if (wanted != TableFormat::SHORTS) {
+            writeData(static_cast<short>(messageCodes::USE_FORMAT));
+            writeData(static_cast<short>(wanted));
+            if (readData() == static_cast<short>(messageCodes::QUIT)) throw 0;
+            if (buf == static_cast<short>(messageCodes::ACK)) format = wanted;
+        }
+        for (const string& name : queues) {
+            short head[2] = {static_cast<short>(messageCodes::SUBSCRIBE), static_cast<short>(name.size())};
+            string request(reinterpret_cast<const char*>(head), sizeof(head));
+            if (link->send((request + name).data(), request.size() + name.size()) < 0) throw 0;
+            if (readData() == static_cast<short>(messageCodes::QUIT)) throw 0;
+            if (buf != static_cast<short>(messageCodes::ACK)) fatal("Mom has no queue named " + name + " for this kid");
+        }
+        //Selects the mood of the kid
+        if (!moodSet) selectMood();
+        ss<<kidID<<" mood is: "<<moodName[static_cast<short>(mood)] <<endl;
+        Printer::write(ss, cout);
+        if (tracer) {
+            tracePid = TRACE_MOM_PID + 1 + kidID;
+            tracer->label(tracePid, -1, "Kid " + to_string(kidID) + " (" + moodName[static_cast<short>(mood)] + ")");
+            tracer->span("connect", "round trip", tracePid, 0, start);
+        }
+
+        short unreported = -1;  // finished job to report with the next reservation
         while (table.quitFlag) {
-            parseJobTable();
-            selectJob();
+            if (inProgress == nullptr) {
+                parseJobTable();
+                selectJob();
+                if (inProgress == nullptr) idle();
+                else idleFor = 0;
+            }
             if (inProgress != nullptr && inProgress->status == JobStatus::WORKING) {
-                sleep(inProgress->slow);
+                double workStart = tracer ? tracer->now() : 0;
+                double began = clock->now();
+                if (prefetch && reserved == nullptr) {
+                    reserveNext(unreported);
+                    unreported = -1;
+                }
+                double left = inProgress->slow - (clock->now() - began);
+                if (left > 0) clock->sleepFor(left);
+                if (tracer) tracer->span("work", "job", tracePid, 0, workStart, Tracer::arg("slot", inProgress->jobNumber));
                 inProgress->announceDone();
                 finishedJobs.push_back(*inProgress);
-                writeData(static_cast<short>(messageCodes::JOB_DONE));
-                writeData(inProgress->jobNumber);
                 ss<<"Job Completed status: "<< jobStatusName[static_cast<short>(inProgress->status)]<<endl;
                 Printer::write(ss, cout);
-                inProgress = nullptr;
+                short done = inProgress->jobNumber;
+                inProgress = reserved;
+                reserved = nullptr;
+                if (inProgress == nullptr) finishJob(done);
+                else unreported = done;
             }
         }
     }catch (int _) {
@@ -3,6 +3,17 @@
 #include "Enums.hpp"
 #include "Job.hpp"
 #include "JobTable.hpp"
+#include "TableCodec.hpp"
+#include "Transport.hpp"
+#include "SharedTable.hpp"
+#include "Clock.hpp"
+#include "Tracer.hpp"
+#include "Arena.hpp"
+
+#define CLAIM_BATCH 8   ///< Candidate jobs a kid names in one claim (Mom takes up to MAX_CLAIMS)<br>
+#define KID_ARENA_BLOCK (64 << 10) ///< Bytes a kid's arena maps at a time; a kid keeps little<br>
+#define KID_IDLE_MIN 0.001 ///< Seconds an idle kid first waits before asking for the table again<br>
+#define KID_IDLE_MAX 0.1   ///< Longest it waits, after doubling on every round that found nothing<br>
 
 /**
  * @class Kid<br>
@@ -13,21 +24,46 @@ class Kid {
 private:
     short kidID;                          ///< Unique identifier for the kid<br>
     Mood mood{};                          ///< Mood affecting job selection behavior<br>
-    vector<Job> finishedJobs;             ///< List of jobs completed by this kid<br>
+    bool moodSet = false;                 ///< Mood was fixed by setMood(); run() keeps it<br>
+    Arena memory{KID_ARENA_BLOCK};        ///< Where the kid's records live<br>
+    ArenaList<Job> finishedJobs{memory};  ///< List of jobs completed by this kid<br>
     Job* inProgress;                      ///< Pointer to the current job in progress<br>
+    Job* reserved = nullptr;              ///< Next job, claimed while the current one runs<br>
+    bool prefetch = false;                ///< Reserve the next job while working (pipelined mode)<br>
     JobTable table;                       ///< Local copy of the job table received from Mom<br>
-    int clientSock;                       ///< Socket descriptor for communicating with Mom<br>
+    unique_ptr<Transport> link;           ///< Transport for communicating with Mom<br>
+    unique_ptr<SharedTable> snapshot;     ///< Mom's shared-memory table, when reading locally<br>
+    Clock* clock = &Clock::wall();        ///< Time source for doing a job<br>
+    uint32_t seenSeq = 0;                 ///< Snapshot sequence of the last table read<br>
+    TableFormat wanted = TableFormat::PACKED; ///< Table encoding to ask Mom for<br>
+    TableFormat format = TableFormat::SHORTS; ///< Table encoding Mom agreed to<br>
+    uint32_t tableVersion = 0;            ///< Mom's version of the table we hold (0 = none yet)<br>
+    vector<string> queues;                ///< Mom's job queues to subscribe to; none takes the whole table<br>
     short buf;                            ///< Buffer for reading incoming socket data<br>
+    string payload;                       ///< Last PACKED table received, kept for its capacity<br>
+    vector<short> rows;                   ///< Last rows received or read from the snapshot, likewise<br>
+    Tracer* tracer = nullptr;             ///< Span recorder, when the run is traced<br>
+    int tracePid = TRACE_MOM_PID + 1;     ///< This kid's trace process, set once Mom gives it an ID<br>
+    double idleFor = 0;                   ///< Last wait between fruitless table fetches; 0 once a job is won or the table changes<br>
 
     /**
-     * Selects a job for non-cooperative kids based on mood conditions.<br>
+     * Lists jobs for non-cooperative kids based on mood conditions, first slots first.<br>
+     * @param slots Receives up to CLAIM_BATCH job indices<br>
+     * @return Number of candidates<br>
      */
-    void non_Coop_Task_Select();
+    short non_Coop_Task_Select(short* slots) const;
 
     /**
-     * Selects a job for cooperative kids by picking the last available job.<br>
+     * Lists jobs for cooperative kids, last available job first.<br>
+     * @param slots Receives up to CLAIM_BATCH job indices<br>
+     * @return Number of candidates<br>
      */
-    void coop_Task_Select();
+    short coop_Task_Select(short* slots) const;
+
+    /**
+     * Lists the jobs this kid's mood would take, best first.<br>
+     */
+    short candidates(short* slots) const;
 
     /**
      * Checks if the job is acceptable based on the kid's mood.<br>
@@ -46,31 +82,60 @@ private:
     /**
      * Writes a short value to the socket.<br>
      * @param msg Message to be sent to Mom<br>
+     * @throws int 0 if Mom has gone<br>
      */
     void writeData(const short& msg) const;
 
     /**
      * Parses the incoming job table sent from Mom and fills the local table.<br>
+     * Reads the shared-memory snapshot instead of asking when one is attached.<br>
      */
     void parseJobTable();
 
     /**
-     * Sends a WANT_JOB message and receives a response.<br>
-     * If ACK is received, the job is assigned.<br>
-     * If NACK or QUIT is received, handles accordingly.<br>
-     * @param job Job object reference<br>
-     * @param index Index of the job in the table<br>
-     * @return true if job was accepted<br>
-     * @throws int 0 if Mom sends QUIT<br>
+     * Sends WANT_JOBS (or DONE_AND_NEXT when `done` is a job index) for one
+     * of the candidates and takes the job Mom grants, if any.<br>
+     * @param done Index of the job just finished, or -1<br>
+     * @param slots Candidate job indices, best first<br>
+     * @param count Number of candidates<br>
+     * @return The job granted, or nullptr<br>
+     * @throws int 0 if Mom sends QUIT or has gone<br>
+     */
+    Job* claimJob(short done, const short* slots, short count);
+
+    /**
+     * Fetches the table and claims the job to do after the current one.<br>
+     * @param done Finished job not yet reported, or -1; reported in the same message<br>
      */
-    bool wantJob(Job& job, short index);
+    void reserveNext(short done);
+
+    /**
+     * Reports the finished job, claiming the next one in the same message when the table has a candidate.<br>
+     * @param done Index of the finished job<br>
+     */
+    void finishJob(short done);
+
+    /**
+     * Waits before the next table fetch after one that offered nothing, a little longer each time.<br>
+     */
+    void idle();
 
 public:
     /**
      * Constructor<br>
-     * Establishes a connection to Mom's server at localhost on port 1099<br>
+     * Establishes a connection to Mom on `port` (1099 by default) over the given transport<br>
+     * @param transport TCP, Unix socket, or shared memory (TCP by default)<br>
+     * @param useSnapshot Read the table from Mom's shared-memory snapshot<br>
+     * @param port Which Mom to join, when several are running<br>
+     */
+    explicit Kid(TransportKind transport = TransportKind::TCP, bool useSnapshot = false, int port = PORT);
+
+    /**
+     * Constructor for a kid whose link to Mom already exists (simulation)<br>
+     * @param link Connected transport<br>
+     * @param clock Time source used while doing jobs<br>
      */
-    Kid();
+    Kid(unique_ptr<Transport> link, Clock& clock);
 
     /**
      * Destructor (default)<br>
@@ -82,6 +147,31 @@ public:
      */
     void selectMood();
 
+    /**
+     * Fixes the kid's mood instead of rolling one when run() starts.<br>
+     */
+    void setMood(Mood chosen) { mood = chosen; moodSet = true; }
+
+    /**
+     * Chooses the table encoding to ask Mom for when connecting (PACKED by default).<br>
+     */
+    void askFormat(TableFormat chosen) { wanted = chosen; }
+
+    /**
+     * Subscribes to Mom's queues `names` when connecting, so the kid's table holds only their jobs.<br>
+     */
+    void subscribeTo(const vector<string>& names) { queues = names; }
+
+    /**
+     * Turns on pipelined mode: the kid reserves its next job while the current one runs.<br>
+     */
+    void setPrefetch(bool on) { prefetch = on; }
+
+    /**
+     * Records the kid's round trips to Mom and its work into `tracer`.<br>
+     */
+    void traceTo(Tracer& tracer) { this->tracer = &tracer; }
+
     /**
      * Selects a job based on the kid’s mood and job availability.<br>
      */
@@ -2,187 +2,1128 @@
 #include "Printer.hpp"
 
 /**
- * Updates the Mom server's socket address information (e.g., port number and IP). <br>
+ * Opens Mom's welcome listener for the chosen transport. <br>
  * -------------------------------------------------------
- *  - Calls `getsockname` to retrieve the socket's local address structure after binding.
- *  - This information is stored in the `info` member variable for later use (e.g., printing).
- *  - If the call fails, it terminates the program using `fatal()`.
+ * - TCP binds all interfaces on `port`; UNIX and SHM bind a socket file named after `port`.
+ * - The listener prints its bound address and starts listening for kids.
  * -------------------------------------------------------
- * @throws Terminates the program if `getsockname` fails.
+ * @param port The port number on which the Mom server listens for client connections.
+ * @throws Terminates the program if socket creation, binding, or listening fails.
  */
-void Mom::refresh() {
-    socklen_t addrlen = sizeof(struct sockaddr_in);
-    int status = getsockname( fd, (sockaddr*)&info, &addrlen);
-    if ( status < 0 ) fatal("Socket: getsockname failed on socket %d." + fd);
+void Mom::listen(int port) {
+    welcomeSock = Listener::open(transport, port);
     cout << *this;
 }
 
 /**
- * Creates, binds, and configures the server (Mom's) listening socket. <br>
+ * Admits every kid waiting on the welcome listener. <br>
  * -------------------------------------------------------
- * - Creates a TCP socket using `AF_INET` and `SOCK_STREAM`.
- * - Sets the socket's address family, port (converted to network byte order), and binds it to all available interfaces.
- * - Uses `bind()` to associate the socket with the specified port.
- * - Calls `refresh()` to retrieve and print the socket's local address.
- * - Calls `listen()` to mark the socket as a passive socket that will accept incoming client (kid) connections.
+ * - Runs whenever the I/O engine wakes up, so kids can join at any point of the run.
+ * - Each kid gets the lowest free session ID and a generated name, and its
+ *   transport is registered with the engine and wrapped in a Connection.
+ * - Queues an ACK message and the kid's session ID and flushes them.
+ * - When MAXCLIENTS connections are open, the newcomer gets QUIT instead;
+ *   kids behind relays don't count, only the relays do.
+ * - In a cluster, names carry this Mom's port (Ali@1099) so kids of
+ *   different Moms stay apart in the merged earnings.
+ * - Another Mom is admitted the same way and makes herself known with PEER_HELLO.
+ * - With I/O lanes, the transport goes to the next lane round-robin
+ *   instead; the greeting waits in the session's link until the replies
+ *   are posted.
  * -------------------------------------------------------
- * @param port The port number on which the Mom server listens for client connections.
- * @throws Terminates the program if socket creation, binding, or listening fails.
  */
-void Mom::listen(int port) {
-    fd = socket(AF_INET, SOCK_STREAM, 0);
-    if (fd<0) fatal("Socket: Can't create socket");
-
-    info.sin_family = AF_INET;
-    info.sin_port = htons(port);
-    info.sin_addr.s_addr = INADDR_ANY;
-
-    // sockaddr is used to set fields of kernel socket.
-    int status = ::bind(fd, (sockaddr*)&info, sizeof(struct sockaddr_in));
-    if (status < 0) fatal("Can't bind socket (%d)" + fd);
-    refresh();
-    cout << "Just bound socket " << fd << ": " << *this << endl;
-
-    // Declare that this is the welcome socket and it listens for kid contacts.
-    status = ::listen(fd, 4);
-    if (status < 0) fatal("Socket: Unable to listen on socket %d." + fd);
-    cout << "Just called listen(); now waiting for a client to show up\n";
-}
-
-/**
- * Accepts connections from kid clients and assigns each one a socket. <br>
- * -------------------------------------------------------
- * - Calls listen() to prepare the Mom server to accept connections.
- * - Sets up the welcome socket in the poll structure to monitor incoming connections.
- * - Repeats for MAXCLIENTS:
- *     - Accepts a connection from a kid using accept().
- *     - Initializes the corresponding pollfd entry in the worker array.
- *     - Sends an ACK message and the kid's assigned ID back to the client.
- *     - Logs the connection using Printer.
- * -------------------------------------------------------
- * @throws If accept() fails, it prints an error message but continues to attempt connections.
- */
-void Mom::addClient() {
-    listen(PORT);
-    welcomeFd = fd;
-    welcome -> fd = welcomeFd;
-    welcome -> events = POLLIN;
-    for (nCli = 0; nCli < MAXCLIENTS; nCli++) {
-        sockaddr_in newCaller{};
-        socklen_t sockLen = sizeof(newCaller);
-        short newfd = accept(welcomeFd, (sockaddr*)&newCaller, &sockLen);
-        if (newfd < 0){cerr << "No new client was added" << endl; continue;}
-        worker[nCli].fd = newfd;
-        worker[nCli].events = POLLIN;
-        worker[nCli].revents = 0;
+void Mom::admitKids() {
+    while (unique_ptr<Transport> kid = engine->accept(*welcomeSock)) {
+        if (sessionOf.size() + piped.size() >= MAXCLIENTS || kids.size() >= MAXSESSIONS) {
+            message = static_cast<short>(messageCodes::QUIT);
+            kid->trySend(&message, sizeof(short));
+            Printer::write("Turned a kid away: Mom is full\n", cerr);
+            continue;
+        }
+        short session = sessionIds.acquire();
+        Session& joined = kids[session];
+        joined.name = kidName(joins++);
+        if (cluster) joined.name += "@" + to_string(port);
+        joined.link = links.take();
+        if (lanes.empty()) {
+            joined.link->open(engine->add(std::move(kid)));
+            sessionOf[&joined.link->transport()] = session;
+        }
+        else {
+            joined.lane = nextLane++ % lanes.size();
+            piped.push_back(session);
+            reply.session = session;
+            reply.adopt = kid.release();
+            reply.bytes.clear();
+            lanes[joined.lane]->post(reply);
+        }
         message = static_cast<short>(messageCodes::ACK);
-        write(newfd, &message, sizeof(short));
-        write(newfd, &nCli,sizeof(short));
-        ss << kidNames[nCli] << " has connected to Mom with ID: " << nCli << endl;
+        joined.link->queue(&message, sizeof(short));
+        joined.link->queue(&session, sizeof(short));
+        if (joined.lane < 0) joined.link->flush();
+        if (capture) capture->join(session);
+        ss << joined.name << " has connected to Mom with ID: " << session << endl;
         Printer::write(ss, cout);
+        if (tracer) {
+            tracer->label(TRACE_MOM_PID, 1 + session, "session " + to_string(session));
+            tracer->instant("join", "session", TRACE_MOM_PID, 1 + session, Tracer::arg("kid", joined.name));
+        }
+    }
+}
+
+/**
+ * Ends a kid's session. <br>
+ * -------------------------------------------------------
+ * - Unregisters its transport and closes the connection.
+ * - Jobs it was still WORKING on go back to NOT_STARTED so others can take them.
+ * - Its session ID returns to the pool for the next kid to join.
+ * - A relay takes every kid behind it along.
+ * - A piped kid's lane has already closed its transport.
+ * -------------------------------------------------------
+ * @param session Session ID of the kid.
+ */
+void Mom::dropKid(short session) {
+    vector<short> riders;
+    for (auto& [id, other] : kids)
+        if (other.via == session) riders.push_back(id);
+    for (short id : riders) dropKid(id);
+    Session& kid = kids[session];
+    ss << kid.name << " has left Mom (ID: " << session << ")" << endl;
+    Printer::write(ss, cout);
+    if (kid.link && kid.lane < 0) {
+        engine->remove(kid.link->transport());
+        sessionOf.erase(&kid.link->transport());
+    }
+    if (kid.lane >= 0) piped.erase(find(piped.begin(), piped.end(), session));
+    if (tracer) tracer->instant("leave", "session", TRACE_MOM_PID, 1 + session, Tracer::arg("kid", kid.name));
+    if (capture) capture->leave(session);
+    bool released = false;
+    for (short i = 0; i < table.size(); i++) {
+        if (table.jobs[i].status == JobStatus::WORKING && table.jobs[i].kidID == session) {
+            table.jobs[i].status = JobStatus::NOT_STARTED;
+            released = true;
+            if (tracer) {
+                tracer->end("working", "job", TRACE_MOM_PID, jobSerial[i], Tracer::arg("released", 1));
+                tracer->begin("waiting", "job", TRACE_MOM_PID, jobSerial[i], Tracer::arg("slot", i));
+            }
+        }
+    }
+    if (released) publishTable();
+    for (size_t q = 0; q < queues.size(); q++) queues[q].subscribers -= kid.queues >> q & 1;
+    batch.erase(remove_if(batch.begin(), batch.end(), [&](const HeldClaim& claim) { return claim.session == session; }), batch.end());
+    kids.erase(session);
+    sessionIds.release(session);
+}
+
+string Mom::kidName(long serial) const {
+    string name = kidNames[serial % 4];
+    if (serial >= 4) name += to_string(serial / 4 + 1);
+    return name;
+}
+
+string Mom::nameOf(short session) const {
+    auto found = kids.find(session);
+    return found != kids.end() ? found->second.name : "Kid " + to_string(session);
+}
+
+void Mom::renameSession(short session, const string& name) {
+    string suffix = cluster ? "@" + to_string(port) : "";
+    if (joins > 0 && kids[session].name == kidName(joins - 1) + suffix) joins--;
+    kids[session].name = name;
+}
+
+Connection& Mom::linkOf(short session) {
+    Session& kid = kids[session];
+    return kid.via >= 0 ? *kids[kid.via].link : *kid.link;
+}
+
+/**
+ * Admits a kid that joined through a relay. <br>
+ * -------------------------------------------------------
+ * - The kid gets a session, a name, and an ID like any other, but no
+ *   link: its replies go on the relay's connection, in the order the
+ *   relay sent its messages, and the relay sorts them out.
+ * - Refused (NACK) past MAXSESSIONS, or if asked for by a kid that is
+ *   itself behind a relay.
+ * - The relay's own session is renamed the first time.
+ * -------------------------------------------------------
+ * @param relay Session of the relay.
+ */
+void Mom::attachKid(short relay) {
+    if (kids.size() >= MAXSESSIONS || kids[relay].via >= 0) {
+        message = static_cast<short>(messageCodes::NACK);
+        linkOf(relay).queue(&message, sizeof(short));
+        return;
+    }
+    if (!kids[relay].relay) {
+        kids[relay].relay = true;
+        renameSession(relay, "Relay" + to_string(relay));
+    }
+    short session = sessionIds.acquire();
+    Session& joined = kids[session];
+    joined.name = kidName(joins++);
+    if (cluster) joined.name += "@" + to_string(port);
+    joined.via = relay;
+    short reply[2] = {static_cast<short>(messageCodes::ACK), session};
+    linkOf(relay).queue(reply, sizeof(reply));
+    if (capture) capture->join(session);
+    ss << joined.name << " has connected to Mom through " << kids[relay].name << " with ID: " << session << endl;
+    Printer::write(ss, cout);
+    if (tracer) {
+        tracer->label(TRACE_MOM_PID, 1 + session, "session " + to_string(session));
+        tracer->instant("join", "session", TRACE_MOM_PID, 1 + session, Tracer::arg("kid", joined.name));
+    }
+}
+
+/**
+ * Encodes the job table for transmission.
+ * -------------------------------------------------------
+ * - Packs job attributes into seven shorts per slot in a fixed order:
+ *   jobNumber, slow, dirty, heavy, value, status, generation.
+ * - Kept until the table next changes, so a burst of NEED_JOBs encodes once.
+ * -------------------------------------------------------
+ */
+const vector<short>& Mom::tableRows() {
+    if (!rowsFresh) TableCodec::encodeRows(table, rows);
+    rowsFresh = true;
+    return rows;
+}
+
+const string& Mom::packedTable() {
+    if (!packedFresh) TableCodec::encodePacked(table, packed);
+    packedFresh = true;
+    return packed;
+}
+
+/**
+ * Cuts the slots of some queues out of the table. <br>
+ * -------------------------------------------------------
+ * - Queues follow one another in queue order, and their jobs are numbered
+ *   by where they sit in the cut, which is how the kid names them back.
+ * -------------------------------------------------------
+ */
+JobTable Mom::viewTable(uint64_t subscribed) const {
+    JobTable part(0);
+    for (size_t q = 0; q < queues.size(); q++)
+        if (subscribed >> q & 1)
+            part.jobs.insert(part.jobs.end(), table.jobs.begin() + queues[q].first,
+                             table.jobs.begin() + queues[q].first + queues[q].slots);
+    for (short i = 0; i < part.size(); i++) part.jobs[i].jobNumber = i;
+    return part;
+}
+
+/**
+ * Encodes the slots of some queues on their own. <br>
+ * -------------------------------------------------------
+ * - Kids subscribed to the same queues share one encoding of each kind,
+ *   kept with the version it was made at; a queue's version only ever
+ *   moves on, so an unchanged sum means none of them changed.
+ * -------------------------------------------------------
+ */
+const vector<short>& Mom::viewRows(uint64_t subscribed) {
+    View& view = views[subscribed];
+    uint32_t current = versionOf(subscribed);
+    if (view.rowsVersion != current) TableCodec::encodeRows(viewTable(subscribed), view.rows);
+    view.rowsVersion = current;
+    return view.rows;
+}
+
+const string& Mom::packedView(uint64_t subscribed) {
+    View& view = views[subscribed];
+    uint32_t current = versionOf(subscribed);
+    if (view.packedVersion != current) TableCodec::encodePacked(viewTable(subscribed), view.packed);
+    view.packedVersion = current;
+    return view.packed;
+}
+
+uint32_t Mom::versionOf(uint64_t subscribed) const {
+    if (subscribed == 0) return tableVersion;
+    uint32_t sum = 0;
+    for (size_t q = 0; q < queues.size(); q++)
+        if (subscribed >> q & 1) sum += queues[q].version;
+    return sum != 0 ? sum : 1;
+}
+
+/**
+ * Queues the job table for a specific kid client.
+ * -------------------------------------------------------
+ * - Queues an ACK (the Kid checks it for QUIT), the 32-bit table version
+ *   if the kid asked with NEED_JOB_SINCE, and then the table.
+ * - A kid that subscribed to queues gets only their slots, numbered from 0
+ *   (see viewTable()), and the version of just those queues (see versionOf()).
+ * - SHORTS: the slot count, then the rows.
+ * - PACKED: the payload length as a 32-bit count, then the payload.
+ * - Both go out together on the connection's next flush.
+ * -------------------------------------------------------
+ * @param session Session ID of the kid.
+ * @param versioned Whether the kid asked with NEED_JOB_SINCE.
+ */
+void Mom::sendJobTable(short session, bool versioned) {
+    const Session& who = kids[session];
+    Connection& kid = linkOf(session);
+    message = static_cast<short>(messageCodes::ACK);
+    kid.queue(&message, sizeof(short));
+    size_t before = kid.backlog();
+    if (versioned) {
+        uint32_t version = versionOf(who.queues);
+        kid.queue(&version, sizeof(version));
+    }
+    if (who.format == TableFormat::PACKED) {
+        const string& payload = who.queues ? packedView(who.queues) : packedTable();
+        uint32_t length = payload.size();
+        kid.queue(&length, sizeof(length));
+        kid.queue(payload.data(), payload.size());
     }
+    else {
+        const vector<short>& rows = who.queues ? viewRows(who.queues) : tableRows();
+        short slots = rows.size() / ROW_SHORTS;
+        kid.queue(&slots, sizeof(slots));
+        kid.queue(rows.data(), rows.size() * sizeof(short));
+    }
+    tablesSent++;
+    tableBytes += sizeof(short) + kid.backlog() - before;
 }
 
 /**
- * Sends the entire job table to a specific kid client over the given socket.
+ * Publishes the job table to co-located kids.
  * -------------------------------------------------------
- * - Iterates through all 10 jobs.
- * - Packs job attributes into a short array (entireJT) in a fixed order:
- *   jobNumber, slow, dirty, heavy, value, status.
- * - Sends the full array to the kid using write().
+ * - Called after every change to the table: the version moves on, cached
+ *   encodings are dropped, and the snapshot is rewritten so it stays authoritative.
+ * - With queues, the rows are compared with those last published and each
+ *   queue whose slots differ moves on its own version, so a kid subscribed
+ *   to other queues keeps getting NOT_MODIFIED.
+ * - Carries the quit flag, so snapshot readers learn the run is over.
  * -------------------------------------------------------
- * @param fd The socket file descriptor of the kid client.
  */
-void Mom::sendJobTable(int fd) {
-    short index = 0;
-    for (short i = 0; i < 10; i++) {
-        Job job = table.jobs[i];
-        entireJT[index++] = job.jobNumber;
-        entireJT[index++] = job.slow;
-        entireJT[index++] = job.dirty;
-        entireJT[index++] = job.heavy;
-        entireJT[index++] = job.value;
-        entireJT[index++] = static_cast<short>(job.status);
+void Mom::publishTable() {
+    if (++tableVersion == 0) tableVersion = 1;
+    rowsFresh = packedFresh = false;
+    if (!queues.empty()) {
+        const vector<short>& now = tableRows();
+        seenRows.resize(now.size(), -1);
+        for (Queue& queue : queues) {
+            auto from = now.begin() + queue.first * ROW_SHORTS, to = from + queue.slots * ROW_SHORTS;
+            auto seen = seenRows.begin() + queue.first * ROW_SHORTS;
+            if (equal(from, to, seen)) continue;
+            copy(from, to, seen);
+            if (++queue.version == 0) queue.version = 1;
+        }
     }
-    write(fd, entireJT, sizeof(entireJT));
+    if (!snapshot) return;
+    snapshot->publish(tableRows().data(), !table.quitFlag);
+}
+
+/**
+ * Gives job `index` to a kid if it is still free. <br>
+ * -------------------------------------------------------
+ * - A NOT_STARTED job becomes WORKING for `session`; the caller republishes the table.
+ * - A kid already holding 1 + `reservationLimit` jobs is refused, so a
+ *   kid reserving ahead can't hoard the table.
+ * - A taken job is refused; an out-of-range index is refused silently.
+ * -------------------------------------------------------
+ * @param session Session ID of the kid making the claim.
+ * @param index Index of the job the kid wants.
+ * @return true if the job is now the kid's.
+ */
+bool Mom::grantJob(short session, int index) {
+    if (index < 0 || index >= table.size()) return false;
+    if (kids[session].holding > reservationLimit) {
+        claimsOverLimit++;
+        if (tracer) tracer->instant("over limit", "claim", TRACE_MOM_PID, 1 + session, Tracer::arg("slot", index));
+        return false;
+    }
+    if (table.jobs[index].status != JobStatus::NOT_STARTED) {
+        claimsTaken++;
+        if (tracer) tracer->instant("refused", "claim", TRACE_MOM_PID, 1 + session, Tracer::arg("slot", index));
+        return false;
+    }
+    table.jobs[index].status = JobStatus::WORKING;
+    table.jobs[index].kidID = session;
+    kids[session].holding++;
+    claimsGranted++;
+    if (tracer) {
+        tracer->end("waiting", "job", TRACE_MOM_PID, jobSerial[index]);
+        tracer->begin("working", "job", TRACE_MOM_PID, jobSerial[index], Tracer::arg("kid", kids[session].name));
+    }
+    return true;
 }
 
 /**
  * Handles a job request from a kid and sends an appropriate response. <br>
  * -------------------------------------------------------
+ * - If the slot has been refilled since the kid saw it (its generation
+ *   moved on), the job asked for is gone: counted as stale and refused
+ *   with NACK, never granted as the job that replaced it.
  * - If the requested job is NOT_STARTED:
- *     - Updates the job's status to WORKING and assigns it to the requesting kid.
- *     - Sends an ACK message to confirm assignment.
- * - If the job is already taken:
- *     - Sends a NACK message.
- *     - Resends the current state of the job table to help the kid choose again.
+ *     - Updates the job's status to WORKING, assigns it to the requesting kid, and republishes the table.
+ *     - Queues an ACK message to confirm assignment.
+ * - If the job is already taken (or doesn't exist):
+ *     - Queues a NACK message.
  * -------------------------------------------------------
- * @param kidIndex Index of the kid making the request.
+ * @param session Session ID of the kid making the request.
  * @param jobChoiceIndex Index of the job the kid wants to perform.
+ * @param generation Generation the kid saw in that slot.
  */
-void Mom::jobRequest(short kidIndex, short jobChoiceIndex) {
-   if (table.jobs[jobChoiceIndex].status == JobStatus::NOT_STARTED) {
-       table.jobs[jobChoiceIndex].status = JobStatus::WORKING;
-       table.jobs[jobChoiceIndex].kidID = kidIndex;
-       message = static_cast<short>(messageCodes::ACK);
-       write(worker[kidIndex].fd, &message, sizeof(short));
-   }
-   else {
-        message = static_cast<short>(messageCodes::NACK);
-        write(worker[kidIndex].fd, &message, sizeof(short));
-        // write(worker[kidIndex].fd, entireJT, sizeof(entireJT));
+void Mom::jobRequest(short session, int jobChoiceIndex, uint16_t generation) {
+    bool stale = jobChoiceIndex >= 0 && jobChoiceIndex < table.size() && table.jobs[jobChoiceIndex].generation != generation;
+    if (stale) {
+        claimsStale++;
+        if (tracer) tracer->instant("stale", "claim", TRACE_MOM_PID, 1 + session, Tracer::arg("slot", jobChoiceIndex));
     }
+    bool granted = !stale && grantJob(session, jobChoiceIndex);
+    if (granted) publishTable();
+    message = static_cast<short>(granted ? messageCodes::ACK : messageCodes::NACK);
+    linkOf(session).queue(&message, sizeof(short));
+}
+
+/**
+ * Handles a batched claim (WANT_JOBS, or the second half of DONE_AND_NEXT). <br>
+ * -------------------------------------------------------
+ * - Tries the candidates in the kid's order and stops after `wanted` grants,
+ *   so a kid asking for one job never holds two. With deadlines, the
+ *   candidate due first is tried first; ties keep the kid's order.
+ * - A candidate whose generation differs from the slot's is refused without
+ *   looking further: the kid chose it from a table in which the slot still
+ *   held an earlier job, and granting it would hand over a job it never saw.
+ * - Queues ACK and two 16-bit masks: bit k of the first set means candidate
+ *   k is now the kid's, bit k of the second that candidate k was stale.
+ *   Nothing else is sent; the kid decides whether to fetch a new table.
+ * - The table is republished once for the whole batch.
+ * -------------------------------------------------------
+ * @param session Session ID of the kid making the claim.
+ * @param request The claim as parsed by the Connection.
+ */
+void Mom::claimJobs(short session, const Message& request) {
+    uint16_t granted = 0, stale = 0;
+    short grants = 0;
+    short order[MAX_CLAIMS];
+    iota(order, order + request.count, 0);
+    if (deadlines)
+        stable_sort(order, order + request.count, [&](short a, short b) { return dueOf(request.slots[a]) < dueOf(request.slots[b]); });
+    for (short n = 0; n < request.count && grants < request.wanted; n++) {
+        short k = order[n];
+        short index = request.slots[k];
+        if (index >= 0 && index < table.size() && table.jobs[index].generation != request.generations[k]) {
+            stale |= 1 << k;
+            claimsStale++;
+            if (tracer) tracer->instant("stale", "claim", TRACE_MOM_PID, 1 + session, Tracer::arg("slot", index));
+            continue;
+        }
+        if (!grantJob(session, index)) continue;
+        granted |= 1 << k;
+        grants++;
+    }
+    if (grants > 0) publishTable();
+    short reply[3] = {static_cast<short>(messageCodes::ACK), static_cast<short>(granted), static_cast<short>(stale)};
+    linkOf(session).queue(reply, sizeof(reply));
+}
+
+/**
+ * Records a finished job and puts a fresh one in its slot.<br>
+ * @param session Session ID of the kid reporting.
+ * @param index Index of the finished job; ignored unless it is in range
+ *        and the job is WORKING for this kid, so a late or mistaken report
+ *        can't complete a job that is open or another kid's.
+ */
+void Mom::jobDone(short session, int index) {
+    if (index < 0 || index >= table.size()) return;
+    if (table.jobs[index].status != JobStatus::WORKING || table.jobs[index].kidID != session) return;
+    kids[session].holding--;
+    if (tracer) tracer->end("working", "job", TRACE_MOM_PID, jobSerial[index]);
+    table.jobs[index].status = JobStatus::COMPLETE;
+    table.jobs[index].kidID = session;
+    scanJobTable();
+}
+
+/**
+ * Hands open jobs to a Mom whose own share has run out (STEAL_JOBS). <br>
+ * -------------------------------------------------------
+ * - Gives at most half of the NOT_STARTED jobs (pieces of split jobs stay),
+ *   taken from the end of the table, so this Mom's own kids are never left with nothing; none at all
+ *   once the run is over.
+ * - Queues ACK, the count, and (slow, dirty, heavy) for each job given.
+ * - The slots are retired without being recorded as done and refilled
+ *   from this Mom's supply, so a Mom with a long share left passes it on.
+ * -------------------------------------------------------
+ * @param session Session of the asking Mom.
+ * @param count Most jobs she wants.
+ */
+void Mom::giveJobs(short session, short count) {
+    vector<short> open;
+    for (short i = table.size() - 1; i >= 0 && table.quitFlag; i--)
+        if (table.jobs[i].status == JobStatus::NOT_STARTED && pieceOf[i] < 0) open.push_back(i);
+    short given = min<size_t>(max<short>(count, 0), open.size() / 2);
+    vector<short> reply = {static_cast<short>(messageCodes::ACK), given};
+    for (short k = 0; k < given; k++) {
+        Job& job = table.jobs[open[k]];
+        reply.insert(reply.end(), {job.slow, job.dirty, job.heavy});
+        job.status = JobStatus::COMPLETE;
+        vacant[open[k]] = true;
+        if (tracer) {
+            tracer->end("waiting", "job", TRACE_MOM_PID, jobSerial[open[k]]);
+            tracer->end("job", "job", TRACE_MOM_PID, jobSerial[open[k]], Tracer::arg("given to", kids[session].peer));
+        }
+    }
+    linkOf(session).queue(reply.data(), reply.size() * sizeof(short));
+    jobsGiven += given;
+    if (given == 0) return;
+    publishTable();
+    scanJobTable();
+}
+
+/**
+ * Trades per-kid totals with the other Moms at the end of the run. <br>
+ * -------------------------------------------------------
+ * - Sends this Mom's totals, then services only the other Moms' sessions
+ *   until each has sent all of hers or CLUSTER_REPORT_WAIT seconds pass.
+ *   A Mom that finishes later than this one answers within the wait; one
+ *   that finished earlier has already sent hers.
+ * - Kids have been told to quit and are no longer read.
+ * -------------------------------------------------------
+ */
+void Mom::collectEarnings(const unordered_map<string, long>& totals) {
+    cluster->shareEarnings(totals, *engine);
+    double start = clock->now();
+    vector<Transport*> ready;
+    while (peersReported < short(cluster->peerCount()) && clock->now() - start < CLUSTER_REPORT_WAIT) {
+        engine->wait(100, ready);
+        for (Transport* link : ready) {
+            auto found = sessionOf.find(link);
+            if (found != sessionOf.end() && kids[found->second].peer) serviceKid(found->second);
+            else if (cluster->owns(link)) cluster->service(link, *engine, clock->now());
+        }
+    }
+    cluster->disconnect(*engine);
+}
+
+void Mom::joinCluster(const vector<int>& ports, unique_ptr<JobSource> source) {
+    cluster = make_unique<Cluster>(transport, port, ports);
+    const HashRing& ring = cluster->hashRing();
+    setJobSource(make_unique<ShardedJobSource>(std::move(source), ring, ring.indexOf(port)));
+}
+
+void Mom::addQueue(const string& name, short slots, unique_ptr<JobSource> source) {
+    short first = queues.empty() ? 0 : queues.back().first + queues.back().slots;
+    if (queues.size() == MAX_QUEUES) fatal("Mom serves at most " + to_string(MAX_QUEUES) + " queues");
+    if (name.empty() || name.size() > MAX_NAME) fatal("Queue names are 1.." + to_string(MAX_NAME) + " characters");
+    if (slots < 1 || first + slots > MAX_JOB_SLOTS) fatal("Queues need 1.." + to_string(MAX_JOB_SLOTS) + " slots in all");
+    for (const Queue& queue : queues)
+        if (queue.name == name) fatal("There are two queues named " + name);
+    queues.push_back(Queue{name, first, slots, source ? make_unique<JobProducer>(std::move(source)) : nullptr});
+    table.resize(first + slots);
+}
+
+/**
+ * Subscribes a kid to a queue (SUBSCRIBE). <br>
+ * -------------------------------------------------------
+ * - The kid's table becomes the slots of every queue it has subscribed
+ *   to, in queue order, and its job indices count slots of that table.
+ *   A kid that never subscribes goes on seeing the whole table.
+ * - Refused (NACK) if there is no such queue, or for another Mom, whose
+ *   STEAL_JOBS works on the whole table. Subscribing twice is harmless.
+ * - A kid normally subscribes before it first asks for the table; one
+ *   that does so later is sent the new view on its next NEED_JOB_SINCE,
+ *   since the version it holds belongs to the old one.
+ * -------------------------------------------------------
+ */
+void Mom::subscribe(short session, const string& name) {
+    Session& kid = kids[session];
+    size_t q = 0;
+    while (q < queues.size() && queues[q].name != name) q++;
+    bool known = q < queues.size() && !kid.peer;
+    if (known && !(kid.queues >> q & 1)) {
+        kid.queues |= uint64_t(1) << q;
+        queues[q].subscribers++;
+        kid.view.clear();
+        for (size_t other = 0; other < queues.size(); other++)
+            if (kid.queues >> other & 1)
+                for (short i = 0; i < queues[other].slots; i++) kid.view.push_back(queues[other].first + i);
+        ss << kid.name << " has subscribed to queue " << name << endl;
+        Printer::write(ss, cout);
+    }
+    message = static_cast<short>(known ? messageCodes::ACK : messageCodes::NACK);
+    linkOf(session).queue(&message, sizeof(short));
 }
 
 /**
  * Processes a message received from a kid client. <br>
  * -------------------------------------------------------
- * - Reads a message code from the kid’s socket.
- * - If the connection is closed or error occurs, closes the socket and removes the kid.
+ * - The Connection has already reassembled the whole message, so nothing here reads.
+ * - An out-of-range job index is refused (NACK) or ignored rather than trusted.
  * - If the message is:
- *   - NEED_JOB: Sends the full job table.
- *   - WANT_JOB: Reads the requested job index and processes the job request.
- *   - JOB_DONE: Reads the completed job index, updates status to COMPLETE, and logs it.
- * -------------------------------------------------------
- * @param kidIndex The index of the kid in the worker socket array.
- */
-void Mom::processMessage(short kidIndex) {
-    long nBytes = read(worker[kidIndex].fd, &message, sizeof(short));
-    if (nBytes <= 0) {
-        close(worker[kidIndex].fd);
-        worker[kidIndex] = worker[--nCli];
-    }
-    if (message == static_cast<short>(messageCodes::NEED_JOB)) {sendJobTable(worker[kidIndex].fd);}
-    if (message == static_cast<short>(messageCodes::WANT_JOB)) {
-        short jobChoiceIndex;
-        read(worker[kidIndex].fd, &jobChoiceIndex, sizeof(short));
-        jobRequest(kidIndex,jobChoiceIndex);
-    }
-    if (message == static_cast<short>(messageCodes::JOB_DONE)) {
-        short jobIndex;
-        read(worker[kidIndex].fd, &jobIndex,sizeof(short));
-        table.jobs[jobIndex].status = JobStatus::COMPLETE;
-        table.jobs[jobIndex].kidID = kidIndex;
-        scanJobTable();
+ *   - NEED_JOB: Queues the full job table.
+ *   - NEED_JOB_SINCE: Queues NOT_MODIFIED if the kid's version `arg` is
+ *     still current, otherwise the version and the full table.
+ *   - WANT_JOB: Processes the request for job index `arg`, refused if its generation is stale.
+ *   - WANT_JOBS: Grants up to `wanted` of the candidates and answers with a bitmask.
+ *   - JOB_DONE: Updates job `arg` to COMPLETE and refreshes the table.
+ *   - DONE_AND_NEXT: JOB_DONE for `arg`, then WANT_JOBS, in one exchange.
+ *   - With a claim window, the claims above are held for solveClaims() instead.
+ *   - USE_FORMAT: Switches this kid's table replies to TableFormat `arg` (ACK), or refuses an unknown one (NACK).
+ *   - SUBSCRIBE: Narrows this kid's table to the queues it has named (see subscribe()).
+ * - From another Mom:
+ *   - PEER_HELLO: Marks the session as the Mom on port `arg`; if nobody
+ *     has joined since her, the kid name she was given goes to the next kid.
+ *   - STEAL_JOBS: Hands her up to `arg` open jobs.
+ *   - EARNINGS: Adds her total `arg` for kid `name`; an empty name means she is done.
+ * - From a relay:
+ *   - ATTACH: Opens a session for a kid behind it.
+ *   - DETACH: Closes session `arg`, if that kid is behind this relay.
+ *   - (VIA is handled by serviceKid().)
+ * -------------------------------------------------------
+ * @param session The session ID of the kid.
+ * @param request The message.
+ */
+void Mom::processMessage(short session, const Message& request) {
+    messages++;
+    short code = request.code;
+    int arg = request.arg;
+    Connection& kid = linkOf(session);
+    bool since = code == static_cast<short>(messageCodes::NEED_JOB_SINCE);
+    if (since && static_cast<uint32_t>(arg) == versionOf(kids[session].queues)) {
+        message = static_cast<short>(messageCodes::NOT_MODIFIED);
+        kid.queue(&message, sizeof(short));
+        notModified++;
+        if (tracer) tracer->instant("not modified", "table", TRACE_MOM_PID, 1 + session);
+    }
+    else if (since || code == static_cast<short>(messageCodes::NEED_JOB)) {
+        sendJobTable(session, since);
+        if (tracer) {
+            long open = 0;
+            for (const Job& job : table.jobs) open += job.status == JobStatus::NOT_STARTED;
+            tracer->instant("offer", "table", TRACE_MOM_PID, 1 + session, Tracer::arg("open", open));
+        }
+    }
+    bool batching = claimWindow > 0;
+    if (code == static_cast<short>(messageCodes::WANT_JOB)) {
+        if (batching) holdClaim(session, request);
+        else jobRequest(session, arg, request.generations[0]);
+    }
+    if (code == static_cast<short>(messageCodes::JOB_DONE)) jobDone(session, arg);
+    if (code == static_cast<short>(messageCodes::DONE_AND_NEXT)) jobDone(session, arg);
+    if (code == static_cast<short>(messageCodes::WANT_JOBS) || code == static_cast<short>(messageCodes::DONE_AND_NEXT)) {
+        if (batching) holdClaim(session, request);
+        else claimJobs(session, request);
+    }
+    if (code == static_cast<short>(messageCodes::USE_FORMAT)) {
+        bool known = arg == static_cast<short>(TableFormat::SHORTS) || arg == static_cast<short>(TableFormat::PACKED);
+        if (known) kids[session].format = static_cast<TableFormat>(arg);
+        message = static_cast<short>(known ? messageCodes::ACK : messageCodes::NACK);
+        kid.queue(&message, sizeof(short));
     }
+    if (code == static_cast<short>(messageCodes::SUBSCRIBE)) subscribe(session, request.name);
+    if (code == static_cast<short>(messageCodes::PEER_HELLO)) {
+        kids[session].peer = static_cast<uint16_t>(arg);
+        renameSession(session, "Mom@" + to_string(kids[session].peer));
+        ss << "The Mom on port " << kids[session].peer << " has joined as session " << session << endl;
+        Printer::write(ss, cout);
+    }
+    if (code == static_cast<short>(messageCodes::STEAL_JOBS) && kids[session].peer) giveJobs(session, arg);
+    if (code == static_cast<short>(messageCodes::EARNINGS) && kids[session].peer) {
+        if (request.name.empty()) peersReported++;
+        else peerEarnings[request.name] += arg;
+    }
+    if (code == static_cast<short>(messageCodes::ATTACH)) attachKid(session);
+    if (code == static_cast<short>(messageCodes::DETACH)) {
+        auto rider = kids.find(arg);
+        if (rider != kids.end() && rider->second.via == session) dropKid(arg);
+    }
+}
+
+/**
+ * Services one kid reported by the I/O engine. <br>
+ * -------------------------------------------------------
+ * - Flushes output left over from earlier turns, then reads whatever has arrived.
+ * - Handles the complete messages (see handleMessages()).
+ * - Flushes the replies and tells the engine whether to watch for input
+ *   (not while throttled) and for writability (while output is queued).
+ * - A kid that hung up is dropped; nobody else is renumbered.
+ * -------------------------------------------------------
+ * @param session The session ID of the kid.
+ * @return false if the kid disconnected and was removed.
+ */
+bool Mom::serviceKid(short session) {
+    double start = tracer ? tracer->now() : 0;
+    Connection& kid = *kids[session].link;
+    bool open = kid.flush() && kid.fill();
+    handleMessages(session);
+    if (open) open = !kid.isClosed() && kid.flush();
+    if (!open) {
+        dropKid(session);
+        return false;
+    }
+    engine->watch(kid.transport(), !kid.throttled(), kid.backlog() > 0);
+    if (tracer) tracer->span("service", "dispatch", TRACE_MOM_PID, 1 + session, start);
+    return true;
+}
+
+/**
+ * @return true if the next message in `kid`'s input, after any VIA, may be
+ * handled while its link is held: a claim, or JOB_DONE, which has no reply.
+ */
+static bool passesHold(const Connection& kid) {
+    short head[3];
+    if (!kid.peek(head, sizeof(short))) return false;
+    short code = head[0];
+    if (code == static_cast<short>(messageCodes::VIA)) {
+        if (!kid.peek(head, sizeof(head))) return false;
+        code = head[2];
+    }
+    return code == static_cast<short>(messageCodes::WANT_JOB) || code == static_cast<short>(messageCodes::WANT_JOBS)
+        || code == static_cast<short>(messageCodes::DONE_AND_NEXT) || code == static_cast<short>(messageCodes::JOB_DONE);
+}
+
+/**
+ * Turns the job indices in a subscribed kid's message, which count slots of
+ * its own table, into slots of Mom's; an index beyond its table becomes -1
+ * and is refused like any other out-of-range index.
+ */
+static void toTableSlots(const vector<short>& view, Message& request) {
+    auto slot = [&](int index) { return index >= 0 && index < int(view.size()) ? view[index] : short(-1); };
+    short code = request.code;
+    if (code == static_cast<short>(messageCodes::WANT_JOB) || code == static_cast<short>(messageCodes::JOB_DONE)
+        || code == static_cast<short>(messageCodes::DONE_AND_NEXT)) request.arg = slot(request.arg);
+    if (code == static_cast<short>(messageCodes::WANT_JOBS) || code == static_cast<short>(messageCodes::DONE_AND_NEXT))
+        for (short k = 0; k < request.count; k++) request.slots[k] = slot(request.slots[k]);
 }
 
 /**
- * Initializes the job table with 10 random jobs. <br>
+ * Handles the complete messages in a connection's input. <br>
  * -------------------------------------------------------
- * - Creates 10 Job objects using their index as jobNumber.
+ * - A partial message stays buffered for next time.
+ * - A relay's VIA makes its next message count as the named kid's. A VIA
+ *   naming a kid not behind this relay is ignored and the message handled
+ *   as the relay's own, so the relay still gets its reply.
+ * - While a claim from this link is held in the batch, only more claims
+ *   and JOB_DONE are taken; anything else would be answered ahead of the
+ *   claim, so it waits in the buffer until solveClaims() releases the link.
+ * - A subscribed kid's job indices are mapped to table slots first, so
+ *   nothing past this point knows about views.
+ * -------------------------------------------------------
+ * @param session Session that owns the connection.
+ */
+void Mom::handleMessages(short session) {
+    Connection& kid = *kids[session].link;
+    Message request;
+    while ((!kids[session].held || passesHold(kid)) && kid.nextMessage(request)) dispatch(session, request);
+}
+
+void Mom::dispatch(short session, Message& request) {
+    if (request.code == static_cast<short>(messageCodes::VIA)) {
+        kids[session].next = request.arg;
+        return;
+    }
+    short from = kids[session].next;
+    kids[session].next = -1;
+    auto rider = kids.find(from);
+    short who = rider != kids.end() && rider->second.via == session ? from : session;
+    if (capture && !kids[who].peer) capture->message(who, request);
+    if (kids[who].queues) toTableSlots(kids[who].view, request);
+    processMessage(who, request);
+}
+
+void Mom::startLanes() {
+    unique_ptr<Doorbell> doorbell = make_unique<Doorbell>();
+    bell = doorbell.get();
+    bellLink = engine->add(std::move(doorbell));
+    requests = make_unique<MpmcRing<IoLane::Request>>(LANE_RING);
+    for (int k = 0; k < laneCount; k++) lanes.push_back(make_unique<IoLane>(io, *requests, *bell));
+    piped.reserve(MAXCLIENTS);
+}
+
+/**
+ * Handles what the lanes have decoded. <br>
+ * -------------------------------------------------------
+ * - Each request goes through dispatch() as if Mom had read it herself;
+ *   one lane's requests arrive in the order it pushed them, so a kid's
+ *   messages, and its hang-up after them, keep their order.
+ * - Takes at most a queue's worth per turn, so busy lanes can't keep Mom
+ *   from the rest of her loop.
+ * -------------------------------------------------------
+ */
+void Mom::takeRequests() {
+    IoLane::Request request;
+    for (size_t n = 0; n < requests->capacity() && requests->pop(request); n++) {
+        requestsTaken++;
+        if (kids.find(request.session) == kids.end()) continue;
+        if (request.hungUp) dropKid(request.session);
+        else dispatch(request.session, request.message);
+    }
+}
+
+void Mom::postReplies() {
+    for (short session : piped) {
+        Connection& kid = *kids[session].link;
+        if (kid.backlog() == 0) continue;
+        reply.session = session;
+        kid.takeOutput(reply.bytes);
+        lanes[kids[session].lane]->post(reply);
+        repliesPosted++;
+    }
+}
+
+void Mom::holdClaim(short session, const Message& request) {
+    if (batch.empty()) batchDue = clock->now() + claimWindow;
+    batch.push_back(HeldClaim{session, request});
+    short via = kids[session].via;
+    kids[via >= 0 ? via : session].held = true;
+}
+
+/**
+ * Assigns every claim held in the batch at once. <br>
+ * -------------------------------------------------------
+ * - A kid's candidates are the jobs its mood let it pick, so they are its
+ *   constraints: each candidate in range, of the generation the kid saw,
+ *   and still NOT_STARTED is an option worth the job's value. When
+ *   maximising jobs, every option is also worth a bonus bigger than any
+ *   batch's total value, so more grants always win.
+ * - A claim for `wanted` jobs bids that many times, capped by what the kid
+ *   may still hold; a kid already at its limit is refused as before.
+ * - AssignmentSolver picks the grants, which then go through grantJob().
+ *   Replies are queued claim by claim in arrival order, so every link gets
+ *   its answers in the order it asked.
+ * - Stale candidates are flagged as stale. A claim left short counts each
+ *   candidate someone else holds as taken.
+ * - The solver's real time is recorded per batch for the report.
+ * - Held links are then released and the messages waiting in them handled.
+ * -------------------------------------------------------
+ */
+void Mom::solveClaims() {
+    if (batch.empty()) return;
+    double start = Clock::wall().now();
+    double traceStart = tracer ? tracer->now() : 0;
+    vector<HeldClaim>& claims = solving;
+    claims.clear();
+    claims.swap(batch);
+    vector<vector<pair<int, long>>>& options = claimOptions;
+    if (options.size() < claims.size()) options.resize(claims.size());
+    for (size_t c = 0; c < claims.size(); c++) options[c].clear();
+    vector<short>& capacity = claimRoom;
+    capacity.assign(claims.size(), 0);
+    vector<uint16_t>& stale = claimStale;
+    stale.assign(claims.size(), 0);
+    size_t bids = 0;
+    for (size_t c = 0; c < claims.size(); c++) {
+        const Message& request = claims[c].request;
+        bool single = request.code == static_cast<short>(messageCodes::WANT_JOB);
+        short room = reservationLimit + 1 - kids[claims[c].session].holding;
+        capacity[c] = min<short>(single ? 1 : request.wanted, room);
+        if (room <= 0) {
+            claimsOverLimit++;
+            if (tracer) tracer->instant("over limit", "claim", TRACE_MOM_PID, 1 + claims[c].session);
+            continue;
+        }
+        for (short k = 0; k < (single ? 1 : request.count); k++) {
+            int index = single ? request.arg : request.slots[k];
+            if (index < 0 || index >= table.size()) continue;
+            if (table.jobs[index].generation != request.generations[k]) {
+                stale[c] |= 1 << k;
+                claimsStale++;
+                if (tracer) tracer->instant("stale", "claim", TRACE_MOM_PID, 1 + claims[c].session, Tracer::arg("slot", index));
+                continue;
+            }
+            if (table.jobs[index].status == JobStatus::NOT_STARTED) options[c].emplace_back(index, table.jobs[index].value);
+        }
+        if (!options[c].empty()) bids += max<short>(capacity[c], 0);
+    }
+
+    long bonus = claimForJobs ? 51L * (bids + 1) : 0;
+    solver.clear();
+    vector<size_t>& firstBid = claimFirstBid;
+    firstBid.assign(claims.size() + 1, 0);
+    for (size_t c = 0; c < claims.size(); c++) {
+        for (auto& option : options[c]) option.second += bonus;
+        for (short n = 0; n < capacity[c] && !options[c].empty(); n++) solver.addBidder(options[c]);
+        firstBid[c + 1] = solver.bidders();
+    }
+    const vector<int>& won = solver.solve();
+    double took = Clock::wall().now() - start;
+
+    bool changed = false;
+    for (size_t c = 0; c < claims.size(); c++) {
+        short session = claims[c].session;
+        const Message& request = claims[c].request;
+        bool single = request.code == static_cast<short>(messageCodes::WANT_JOB);
+        uint16_t granted = 0;
+        short grants = 0;
+        for (size_t b = firstBid[c]; b < firstBid[c + 1]; b++) {
+            if (won[b] < 0 || !grantJob(session, won[b])) continue;
+            grants++;
+            for (short k = 0; k < request.count; k++) {
+                if (request.slots[k] != won[b] || (granted | stale[c]) & (1 << k)) continue;
+                granted |= 1 << k;
+                break;
+            }
+        }
+        changed |= grants > 0;
+        for (short k = 0; grants < capacity[c] && k < (single ? 1 : request.count); k++) {
+            int index = single ? request.arg : request.slots[k];
+            if (index < 0 || index >= table.size() || stale[c] & (1 << k)) continue;
+            if (table.jobs[index].status != JobStatus::NOT_STARTED && table.jobs[index].kidID != session) claimsTaken++;
+        }
+        if (single) {
+            message = static_cast<short>(grants > 0 ? messageCodes::ACK : messageCodes::NACK);
+            linkOf(session).queue(&message, sizeof(short));
+            continue;
+        }
+        short reply[3] = {static_cast<short>(messageCodes::ACK), static_cast<short>(granted), static_cast<short>(stale[c])};
+        linkOf(session).queue(reply, sizeof(reply));
+    }
+    if (changed) publishTable();
+    batchesSolved++;
+    claimsBatched += claims.size();
+    solveSeconds += took;
+    slowestSolve = max(slowestSolve, took);
+    if (tracer) tracer->span("solve", "dispatch", TRACE_MOM_PID, 0, traceStart, Tracer::arg("claims", claims.size()));
+
+    vector<short>& owners = heldOwners;
+    owners.clear();
+    for (const HeldClaim& claim : claims) {
+        short via = kids[claim.session].via;
+        short owner = via >= 0 ? via : claim.session;
+        if (!kids[owner].held) continue;
+        kids[owner].held = false;
+        owners.push_back(owner);
+    }
+    for (short owner : owners) {
+        Connection& link = *kids[owner].link;
+        handleMessages(owner);
+        link.flush();
+        engine->watch(link.transport(), !link.throttled(), link.backlog() > 0);
+    }
+}
+
+/**
+ * Jobs are traced as async spans keyed by a serial number: "job" runs
+ * from creation until Mom retires it, with "waiting" (on the table) and
+ * "working" (claimed) nested inside. <br>
+ */
+void Mom::traceNewJob(short slot) {
+    if (!tracer) return;
+    jobSerial[slot] = jobsCreated;
+    tracer->begin("job", "job", TRACE_MOM_PID, jobSerial[slot], Tracer::arg("slot", slot) + "," + Tracer::arg("value", table.jobs[slot].value));
+    tracer->begin("waiting", "job", TRACE_MOM_PID, jobSerial[slot]);
+}
+
+void Mom::traceTo(Tracer& tracer) {
+    this->tracer = &tracer;
+    tracer.label(TRACE_MOM_PID, -1, "Mom");
+    tracer.label(TRACE_MOM_PID, 0, "dispatch loop");
+}
+
+/**
+ * Pushes out the final QUIT messages without blocking on any one kid.<br>
+ */
+void Mom::finishOutput(int seconds) {
+    double start = clock->now();
+    vector<Transport*> ready;
+    for (;;) {
+        bool waiting = false;
+        for (auto& [session, kid] : kids) {
+            if (!kid.link || kid.lane >= 0 || !kid.link->flush() || kid.link->backlog() == 0) continue;
+            engine->watch(kid.link->transport(), false, true);
+            waiting = true;
+        }
+        if (!waiting || clock->now() - start >= seconds) break;
+        engine->wait(100, ready);
+    }
+    engine->drain();
+}
+
+bool Mom::refillSlot(short slot) {
+    auto piece = find_if(pieces.begin(), pieces.end(), [&](const pair<long, Job>& waiting) {
+        return splits[waiting.first].queue == queueAt[slot];
+    });
+    if (piece != pieces.end()) {
+        long split = piece->first;
+        placeJob(slot, piece->second, split, splits[split].due);
+        pieces.erase(piece);
+        return true;
+    }
+    Job job(1, 1, 1);
+    uint32_t node = 0;
+    double due = INFINITY;
+    if (!(deadlines ? takeEarliest(job, node, due) : takeJob(job, node, queueAt[slot]))) {
+        table.jobs[slot].jobNumber = slot;
+        table.jobs[slot].kidID = -1;
+        table.jobs[slot].status = JobStatus::COMPLETE;
+        vacant[slot] = true;
+        return false;
+    }
+    nodeOf[slot] = node;
+    placeJob(slot, job, -1, due);
+    return true;
+}
+
+bool Mom::takeJob(Job& job, uint32_t& node, short queue) {
+    if (graph) return graph->takeReady(node, job);
+    if (!queues.empty() && queues[queue].supply) return queues[queue].supply->next(job) && ++queues[queue].taken;
+    return supply->next(job) || (cluster && cluster->takeStolen(job));
+}
+
+/**
+ * Picks the job due first among those taken in. <br>
+ * -------------------------------------------------------
+ * - `early` and `hopeless` together are kept topped up to EDF_LOOKAHEAD
+ *   jobs, so an urgent job arriving behind a lax one goes on the table first.
+ * - A job's deadline runs from the moment it is taken in: its own, or its
+ *   `slow` plus the slack, so it could be done in time if a kid took it at once.
+ * - A job that could not finish in time even if taken now moves to
+ *   `hopeless` and waits behind every job that still can. Under overload,
+ *   plain EDF would keep serving jobs already lost and make the next ones
+ *   late too; this way the misses stay with the jobs that were lost anyway.
+ *   Hopeless jobs are still done, oldest first, whenever nothing else is waiting.
+ * - One lookahead serves the whole table, so deadlines don't go with queues.
+ * -------------------------------------------------------
+ */
+bool Mom::takeEarliest(Job& job, uint32_t& node, double& due) {
+    double now = clock->now();
+    while (early.size() + hopeless.size() < EDF_LOOKAHEAD && takeJob(job, node, 0)) {
+        double allowed = job.deadline > 0 ? job.deadline : job.slow + deadlineSlack;
+        early.push(Arrival{now + allowed, arrivals++, job, node});
+    }
+    while (!early.empty() && early.top().due < now + early.top().job.slow) {
+        hopeless.push_back(early.top());
+        early.pop();
+    }
+    if (early.empty() && hopeless.empty()) return false;
+    const Arrival& next = !early.empty() ? early.top() : hopeless.front();
+    job = next.job;
+    node = next.node;
+    due = next.due;
+    if (!early.empty()) early.pop();
+    else hopeless.pop_front();
+    return true;
+}
+
+void Mom::checkDeadline(double due) {
+    double late = clock->now() - due;
+    if (late <= 0) {
+        deadlinesMet++;
+        return;
+    }
+    deadlinesMissed++;
+    lateSeconds += late;
+    if (tracer) tracer->instant("missed deadline", "job", TRACE_MOM_PID, 0, Tracer::arg("late ms", long(late * 1000)));
+}
+
+void Mom::placeJob(short slot, Job job, long piece, double due) {
+    job.jobNumber = slot;
+    job.generation = table.jobs[slot].generation + 1;
+    table.jobs[slot] = job;
+    vacant[slot] = false;
+    pieceOf[slot] = piece;
+    postedAt[slot] = clock->now();
+    dueAt[slot] = due;
+    jobsCreated++;
+    traceNewJob(slot);
+}
+
+/**
+ * Splits a slow job nobody is taking. <br>
+ * -------------------------------------------------------
+ * - Only worth it while at least two kids hold no job: one idle kid could
+ *   take the whole job, and with none idle the pieces would only wait.
+ * - Takes the NOT_STARTED job with `slow` of SPLIT_MIN_SLOW or more that
+ *   has waited longest, once it has waited `splitAfter` seconds. Pieces
+ *   are never split again.
+ * - Each piece keeps the job's dirty and heavy and has at most
+ *   SPLIT_PIECE_SLOW of its slow. Value is slow × (dirty + heavy), so the
+ *   pieces' values add up to the job's and each kid is credited for its
+ *   share. Short pieces also suit kids too tired for the whole job.
+ * - The first piece takes the job's slot, one generation on, so a claim
+ *   on the whole job is refused as stale. The rest go to vacant slots of
+ *   the same queue, or wait in `pieces` and take the next slots that free
+ *   up there, ahead of the supply.
+ * - At most one job is split per turn of the loop.
+ * -------------------------------------------------------
+ */
+void Mom::splitJobs() {
+    if (splitAfter <= 0) return;
+    short idle = 0;
+    for (auto& [session, kid] : kids) idle += !kid.peer && !kid.relay && kid.holding == 0;
+    if (idle < 2) return;
+    double now = clock->now();
+    short oldest = -1;
+    for (short i = 0; i < table.size(); i++) {
+        const Job& job = table.jobs[i];
+        if (vacant[i] || pieceOf[i] >= 0 || job.status != JobStatus::NOT_STARTED || job.slow < SPLIT_MIN_SLOW) continue;
+        if (now - postedAt[i] >= splitAfter && (oldest < 0 || postedAt[i] < postedAt[oldest])) oldest = i;
+    }
+    if (oldest < 0) return;
+    Job whole = table.jobs[oldest];
+    long id = nextSplit++;
+    short count = (whole.slow + SPLIT_PIECE_SLOW - 1) / SPLIT_PIECE_SLOW;
+    splits[id] = Split{whole, nodeOf[oldest], count, now, dueAt[oldest], queueAt[oldest]};
+    if (tracer) {
+        tracer->end("waiting", "job", TRACE_MOM_PID, jobSerial[oldest]);
+        tracer->end("job", "job", TRACE_MOM_PID, jobSerial[oldest], Tracer::arg("split into", count));
+    }
+    short slot = oldest;
+    for (short left = whole.slow; left > 0; left -= SPLIT_PIECE_SLOW) {
+        Job piece(min<short>(left, SPLIT_PIECE_SLOW), whole.dirty, whole.heavy);
+        for (short i = 0; slot < 0 && i < table.size(); i++)
+            if (vacant[i] && queueAt[i] == queueAt[oldest]) slot = i;
+        if (slot >= 0) placeJob(slot, piece, id, dueAt[oldest]);
+        else pieces.emplace_back(id, piece);
+        slot = -1;
+    }
+    jobsSplit++;
+    piecesMade += count;
+    ss << "Split job " << oldest << " into " << count << " pieces" << endl;
+    Printer::write(ss, cout);
+    publishTable();
+}
+
+void Mom::finishPiece(short slot) {
+    auto found = splits.find(pieceOf[slot]);
+    pieceOf[slot] = -1;
+    if (found == splits.end() || --found->second.left > 0) return;
+    if (graph) graph->complete(found->second.node);
+    if (deadlines) checkDeadline(found->second.due);
+    splitsFinished++;
+    splitSeconds += clock->now() - found->second.since;
+    splits.erase(found);
+}
+
+/**
+ * Initializes the job table with random jobs. <br>
+ * -------------------------------------------------------
+ * - Starts the job supply unless setJobSource() or setJobGraph() did, or
+ *   every queue has its own: a JobProducer making random jobs on its own
+ *   thread, so refilling a slot later is a pop instead of a roll. A
+ *   simulated Mom rolls them herself: in virtual time a roll costs nothing
+ *   the run can see, and a sweep runs one simulation per core already, so
+ *   a producer thread each would only compete with them.
+ * - Takes one Job per slot (JOB_SLOTS unless setTableSize() said otherwise), using its index as jobNumber.
+ *   A slot the supply can't fill yet starts out vacant.
  * - Assigns each to the job table.
  * - Prints out job details to both the terminal and output file.
+ * - Publishes the first shared-memory snapshot.
  */
 void Mom::initializeJobTable() {
-    for (short i = 0; i < 10; i++) {
-        Job newJob(i);
-        table.jobs[i] = newJob;
+    jobSerial.assign(table.size(), 0);
+    vacant.assign(table.size(), false);
+    nodeOf.assign(table.size(), 0);
+    pieceOf.assign(table.size(), -1);
+    postedAt.assign(table.size(), 0);
+    dueAt.assign(table.size(), INFINITY);
+    queueAt.assign(table.size(), 0);
+    for (size_t q = 0; q < queues.size(); q++)
+        fill(queueAt.begin() + queues[q].first, queueAt.begin() + queues[q].first + queues[q].slots, q);
+    bool shared = queues.empty() || any_of(queues.begin(), queues.end(), [](const Queue& queue) { return !queue.supply; });
+    if (!supply && !graph && shared) {
+        if (simulated) supply = make_unique<RandomJobSource>();
+        else supply = make_unique<JobProducer>(make_unique<RandomJobSource>());
+    }
+    for (short i = 0; i < table.size(); i++) {
         ss << "Job" << i << endl;
         Printer::write(ss, cout);
-        ss << newJob << endl;
+        if (refillSlot(i)) ss << table.jobs[i] << endl;
+        else ss << "Waiting for the job supply" << endl;
         Printer::write(ss, cout);
     }
+    publishTable();
 }
 
 /**
@@ -190,20 +1131,42 @@ void Mom::initializeJobTable() {
  * -------------------------------------------------------
  * - Iterates through all jobs in the job table.
  * - If a job has a status of COMPLETE:
- *     - Adds it to the `completedJobs` vector for end-of-session tracking.
- *     - Replaces the completed job with a new one at the same index.
- *     - Logs the replacement action using the Printer utility.
+ *     - Adds it and the name of the kid who did it to `completedJobs` for end-of-session tracking.
+ *     - With a job graph, marks it complete there, which may make its children ready.
+ *     - A piece of a split job counts towards the split (see finishPiece()); the
+ *       split job is complete in the graph once its last piece is.
+ *     - With deadlines, counts the job (or split job) as on time or late.
+ * - Then, once every completion is in, replaces each completed job with the
+ *   next one from `supply` at the same index, one generation on, and logs it.
+ * - Tries again to fill slots left vacant because the supply had nothing
+ *   (a stream that has gone quiet, a file that has run out, a graph whose
+ *   ready jobs are all out).
+ * - Republishes the table if anything changed.
  * -------------------------------------------------------
  */
 void Mom::scanJobTable() {
-    for (short i = 0; i < 10; i++) {
-        if (table.jobs[i].status == JobStatus::COMPLETE) {
-            completedJobs.push_back(table.jobs[i]);
-            table.jobs[i] = Job(i);
-            ss<<"Adding new job at index: "<< i <<endl;
-            Printer::write(ss, cout);
+    bool changed = false;
+    for (short i = 0; i < table.size(); i++) {
+        if (table.jobs[i].status != JobStatus::COMPLETE) continue;
+        if (vacant[i]) continue;
+        completedJobs.emplace_back(table.jobs[i], nameOf(table.jobs[i].kidID));
+        if (tracer) tracer->end("job", "job", TRACE_MOM_PID, jobSerial[i]);
+        if (pieceOf[i] >= 0) finishPiece(i);
+        else {
+            if (graph) graph->complete(nodeOf[i]);
+            if (deadlines) checkDeadline(dueAt[i]);
         }
+        if (!queues.empty()) queues[queueAt[i]].done++;
+        vacant[i] = true;
+        changed = true;
     }
+    for (short i = 0; i < table.size(); i++) {
+        if (!vacant[i] || !refillSlot(i)) continue;
+        changed = true;
+        ss<<"Adding new job at index: "<< i <<endl;
+        Printer::write(ss, cout);
+    }
+    if (changed) publishTable();
 }
 
 
@@ -220,57 +1183,147 @@ ostream& Mom::print(ostream& os) const{
     return os;
 }
 
+/**
+ * Hands Mom the pieces a simulation supplies. <br>
+ * -------------------------------------------------------
+ * - run() then skips the banner, the shared-memory snapshot, and the real
+ *   listener, and reads all time from `clock`.
+ * - Everything else (admission, dispatch, job table, report) is unchanged.
+ * -------------------------------------------------------
+ */
+void Mom::attach(Clock& clock, unique_ptr<Listener> welcome, unique_ptr<IoEngine> engine) {
+    this->clock = &clock;
+    welcomeSock = std::move(welcome);
+    this->engine = std::move(engine);
+    simulated = true;
+}
+
 /**
  * Controls the main polling loop for Mom’s server process.
  * -------------------------------------------------------
- * - Displays a startup banner and initializes the job table.
- * - Accepts client (Kid) connections via sockets.
- * - Starts a timed loop (21 seconds) that:
- *     - Uses `poll` to monitor socket activity.
+ * - Displays a startup banner, creates the shared-memory snapshot, and initializes the job table.
+ * - Opens the welcome listener and starts the clock right away; nobody waits for a full house.
+ * - With I/O threads (setIoThreads()), starts the lanes; Mom's thread then
+ *   only accepts, schedules and answers, and the lanes do the reading and writing.
+ * - Starts a timed loop (21 seconds unless runFor() says otherwise, or until
+ *   every job of a job graph is done) on Mom's clock that:
+ *     - Waits on the I/O engine (poll or io_uring) for kid traffic or newcomers.
+ *     - Admits any kid that has just connected.
  *     - Scans the job table for completed tasks and refreshes it by replacing them with new jobs.
- *     - Processes incoming messages from kids.
+ *     - Services each reported kid: non-blocking reads into its input buffer,
+ *       complete messages handled, replies queued and flushed, so a slow kid
+ *       never holds up the others. A kid that leaves is dropped on the spot.
+ *     - With lanes, handles the requests they decoded instead and, at the
+ *       end of the turn, posts every piped kid's replies back to its lane.
+ *       The doorbell wakes the wait when a request comes in.
+ *     - In a cluster: services the links to the other Moms, reconnects lost
+ *       ones, and asks for jobs once no job is open and slots stand vacant.
+ *       A Mom that gives jobs away keeps half of hers open, so jobs never
+ *       bounce back. Waits are cut to 100 ms so back-offs and retries run on time.
+ *     - With splitting on, splits a slow job that is going unclaimed while kids stand idle.
+ *     - With a claim window, assigns the held claims once the oldest has
+ *       waited that long; the wait is cut so that happens on time.
  * - After the timer ends:
- *     - Sends the QUIT message to all connected kids.
- *     - Closes all sockets.
+ *     - Assigns any claims still held.
+ *     - Publishes the quit flag, queues QUIT for all connected kids, and flushes for up to 2 seconds;
+ *       lanes flush their own kids meanwhile and are stopped.
  *     - Performs a final scan of completed jobs.
  *     - Tallies total earnings for each kid.
+ *     - In a cluster, trades those totals with the other Moms.
+ *     - Closes all sockets.
  *     - Awards a bonus to the top earner.
  *     - Prints a summary report with total values and the winner.
+ *     - Reports I/O system calls per handled message, what went through the lanes' queues, and the heap
+ *       allocations made while dispatching: with records, session nodes
+ *       and connections in Mom's arena, that is close to none once every
+ *       kid has joined.
+ *     - In a cluster, prints the merged earnings and the cluster's winner.
  * -------------------------------------------------------
  */
 void Mom::run() {
-    banner();
+    if (!simulated) banner();
     ss <<*this;
     Printer::write(ss,cout);
+    if (!simulated) {
+        engine = IoEngine::create(io);
+        snapshot = SharedTable::create(port, table.size());
+        if (!snapshot) Printer::write("Shared-memory table snapshot unavailable\n", cerr);
+    }
+    kids.reserve(MAXSESSIONS);
+    sessionOf.reserve(MAXSESSIONS);
     initializeJobTable();
     ss << "Job Table Initialized" << endl;
     Printer::write(ss, cout);
-    addClient();
-    time(&startTime);
-    while (difftime(time(&currentTime), startTime) < 21) {
-        status = poll(ufds, 1 + nCli, 1000);
+    if (!simulated) listen(port);
+    engine->listen(*welcomeSock);
+    if (laneCount > 0 && !simulated) startLanes();
+    long allocations = Heap::allocations(), frees = Heap::frees();
+    startTime = clock->now();
+    vector<Transport*> ready;
+    while ((currentTime = clock->now()) - startTime < runSeconds && !(graph && graph->finished())) {
+        double waitStart = tracer ? tracer->now() : 0;
+        int waitMs = cluster ? 100 : 1000;
+        if (!batch.empty()) waitMs = max(0, int(ceil((batchDue - clock->now()) * 1000)));
+        if (bell) {
+            bell->nap();
+            if (!requests->empty()) waitMs = 0;
+        }
+        engine->wait(waitMs, ready);
+        if (bell) bell->wake();
+        if (tracer) tracer->span("wait", "dispatch", TRACE_MOM_PID, 0, waitStart, Tracer::arg("ready", ready.size()));
+        admitKids();
         scanJobTable();
-        for (short i = 0; i < nCli; i++) {
-            if (worker[i].revents & POLLIN) {
-                processMessage(i);
-            }
+        if (!lanes.empty()) takeRequests();
+        for (Transport* kid : ready) {
+            auto found = sessionOf.find(kid);
+            if (found != sessionOf.end()) serviceKid(found->second);
+            else if (cluster && cluster->owns(kid) && cluster->service(kid, *engine, clock->now())) scanJobTable();
         }
+        if (!batch.empty() && clock->now() >= batchDue) solveClaims();
+        splitJobs();
+        if (!lanes.empty()) postReplies();
+        if (!cluster) continue;
+        cluster->connect(*engine, currentTime);
+        bool open = any_of(table.jobs.begin(), table.jobs.end(), [](const Job& job) { return job.status == JobStatus::NOT_STARTED; });
+        short idle = count(vacant.begin(), vacant.end(), true);
+        if (!open && idle > 0) cluster->askForJobs(idle, currentTime);
     }
+    allocations = Heap::allocations() - allocations;
+    frees = Heap::frees() - frees;
 
-    for (short i = 0; i < nCli; i++) {
+    solveClaims();
+    table.quitFlag = false;
+    publishTable();
+    for (auto& [session, kid] : kids) {
+        if (kid.peer || !kid.link) continue;
         message = static_cast<short>(messageCodes::QUIT);
-        write(worker[i].fd, &message, sizeof(short));
+        kid.link->queue(&message, sizeof(short));
     }
-    close(welcomeFd);
+    if (!lanes.empty()) postReplies();
+    for (auto& lane : lanes) lane->stop(2);
+    finishOutput(2);
+    for (auto& lane : lanes) lane->join();
     scanJobTable();
-    unordered_map<string, short> totalEarnings;
+    for (short i = 0; tracer && i < table.size(); i++) {
+        if (vacant[i]) continue;
+        tracer->end(table.jobs[i].status == JobStatus::WORKING ? "working" : "waiting", "job", TRACE_MOM_PID, jobSerial[i]);
+        tracer->end("job", "job", TRACE_MOM_PID, jobSerial[i], Tracer::arg("unfinished", 1));
+    }
+    unordered_map<string, long> totalEarnings;
 
-    for (Job& job : completedJobs) {
-        totalEarnings[kidNames[job.kidID]] += job.value;
+    for (auto& [job, name] : completedJobs) {
+        totalEarnings[name] += job.value;
+    }
+    unordered_map<string, long> clusterEarnings;
+    if (cluster) {
+        collectEarnings(totalEarnings);
+        clusterEarnings = peerEarnings;
+        for (auto& [name, value] : totalEarnings) clusterEarnings[name] += value;
     }
+    welcomeSock.reset();
 
     string winner;
-    short maxEarnings = -1;
+    long maxEarnings = -1;
     for (auto& [name, value] : totalEarnings) {
         if (value > maxEarnings) {
             maxEarnings = value;
@@ -282,11 +1335,93 @@ void Mom::run() {
     ss << "--------------------Mama-----------------------------" << endl;
     Printer::write(ss, cout);
 
-    for (Job& job : completedJobs) {
-        ss << "Child " << kidNames[job.kidID] << " has earned a total value of " << job.value << " on this job " << job.jobNumber << endl;
+    for (auto& [job, name] : completedJobs) {
+        ss << "Child " << name << " has earned a total value of " << job.value << " on this job " << job.jobNumber << endl;
         Printer::write(ss, cout);
     }
 
     ss << "The winner for today is " << winner << ", who had a total of " << totalEarnings[winner] << endl;
     Printer::write(ss, cout);
+
+    ss << "I/O (" << engine->name() << "): " << messages << " messages, "
+       << Transport::syscalls << " system calls, " << fixed << setprecision(2)
+       << (messages > 0 ? double(Transport::syscalls) / messages : 0.0) << " per message" << endl;
+    ss << "Tables (" << table.size() << " slots): " << tablesSent << " sent, "
+       << (tablesSent > 0 ? double(tableBytes) / tablesSent : 0.0) << " bytes each, "
+       << notModified << " not modified" << endl;
+    if (!lanes.empty()) {
+        long forwarded = 0, delivered = 0, stalls = 0, wakeups = 0;
+        for (auto& lane : lanes) {
+            forwarded += lane->requestsForwarded();
+            delivered += lane->repliesDelivered();
+            stalls += lane->stallCount();
+            wakeups += lane->wakeups();
+        }
+        ss << "Lanes (" << lanes.size() << " I/O threads, " << lanes[0]->engineName() << "): " << requestsTaken
+           << " requests taken of " << forwarded << " forwarded, " << repliesPosted << " replies posted, " << delivered
+           << " delivered, " << stalls << " stalls on a full queue, " << wakeups << " lane and " << bell->rings()
+           << " scheduler wakeups" << endl;
+    }
+    ss << "Memory: " << allocations << " heap allocations and " << frees
+       << " frees while dispatching, arena " << memory.bytesUsed() / 1024
+       << " KB used of " << memory.bytesMapped() / 1024 << " KB in " << memory.blockCount() << " blocks ("
+       << memory.hugeBlockCount() << " huge), " << memory.reuses() << " pieces reused, "
+       << links.size() << " connections pooled" << endl;
+    ss << "Claims: " << claimsGranted << " granted, " << claimsTaken << " taken, "
+       << claimsStale << " stale, " << claimsOverLimit << " over the reservation limit" << endl;
+    long elsewhere = piecesMade - pieces.size();
+    for (const Queue& queue : queues) elsewhere += queue.taken;
+    if (supply) ss << "Jobs (" << supply->name() << "): " << jobsCreated - elsewhere << " used, "
+       << supply->waits() << " waits for the producer, " << supply->rejected() << " rejected" << endl;
+    if (claimWindow > 0) ss << "Batches (" << claimWindow * 1000 << " ms window, most " << (claimForJobs ? "jobs" : "value") << "): "
+       << batchesSolved << " solved, " << (batchesSolved > 0 ? double(claimsBatched) / batchesSolved : 0.0) << " claims each, "
+       << (batchesSolved > 0 ? solveSeconds / batchesSolved * 1e6 : 0.0) << " us to solve on average, "
+       << slowestSolve * 1e6 << " us at most" << endl;
+    if (splitAfter > 0) ss << "Splits (after " << splitAfter << " s unclaimed): " << jobsSplit << " jobs into "
+       << piecesMade << " pieces, " << splitsFinished << " finished, "
+       << (splitsFinished > 0 ? splitSeconds / splitsFinished : 0.0) << " s from split to last piece on average" << endl;
+    if (deadlines) {
+        double now = clock->now();
+        long overdue = 0;
+        for (short i = 0; i < table.size(); i++) overdue += !vacant[i] && pieceOf[i] < 0 && dueAt[i] < now;
+        for (auto& [id, split] : splits) overdue += split.due < now;
+        for (auto waiting = early; !waiting.empty(); waiting.pop()) overdue += waiting.top().due < now;
+        for (const Arrival& lost : hopeless) overdue += lost.due < now;
+        ss << "Deadlines (slow + " << deadlineSlack << " s unless set): " << deadlinesMet << " met, " << deadlinesMissed
+           << " missed (" << (deadlinesMissed > 0 ? lateSeconds / deadlinesMissed : 0.0) << " s late on average), "
+           << overdue << " unfinished and overdue" << endl;
+    }
+    for (const Queue& queue : queues) {
+        const JobSource& source = queue.supply ? *queue.supply : *supply;
+        ss << "Queue " << queue.name << " (slots " << queue.first << "-" << queue.first + queue.slots - 1 << ", "
+           << source.name() << "): " << queue.done << " jobs done, " << queue.subscribers << " kids subscribed, version "
+           << queue.version;
+        if (queue.supply) ss << ", " << queue.taken << " taken, " << source.waits() << " waits for the producer, "
+           << source.rejected() << " rejected";
+        ss << endl;
+    }
+    if (graph) ss << "Jobs (" << graph->name() << "): " << graph->completed() << " of " << graph->size() << " done, "
+       << graph->edges() << " prerequisites, " << graph->waiting() << " ready and waiting, at most "
+       << graph->longestQueue() << " ready at once" << endl;
+    Printer::write(ss, cout);
+    if (!cluster) return;
+
+    ss << "--------------------Cluster--------------------------" << endl;
+    vector<pair<string, long>> merged(clusterEarnings.begin(), clusterEarnings.end());
+    sort(merged.begin(), merged.end());
+    string clusterWinner;
+    long clusterBest = -1;
+    for (auto& [name, value] : merged) {
+        ss << "Child " << name << " has earned a total value of " << value << " across the cluster" << endl;
+        if (value > clusterBest) {
+            clusterBest = value;
+            clusterWinner = name;
+        }
+    }
+    if (!clusterWinner.empty())
+        ss << "The cluster winner is " << clusterWinner << ", who had a total of " << clusterBest + 5 << endl;
+    ss << "Cluster (port " << port << "): " << peersReported << " of " << cluster->peerCount()
+       << " other Moms reported, " << cluster->jobsReceived() << " jobs stolen in "
+       << cluster->stealRequests() << " requests, " << jobsGiven << " given away" << endl;
+    Printer::write(ss, cout);
 }
\ No newline at end of file
@@ -1,58 +1,438 @@
 #pragma once
 #include "tools.hpp"
 #include "JobTable.hpp"
+#include "TableCodec.hpp"
 #include "Kid.hpp"
+#include "Transport.hpp"
+#include "Connection.hpp"
+#include "SharedTable.hpp"
+#include "IoEngine.hpp"
+#include "SessionPool.hpp"
+#include "Clock.hpp"
+#include "Tracer.hpp"
+#include "Capture.hpp"
+#include "JobSource.hpp"
+#include "JobGraph.hpp"
+#include "Cluster.hpp"
+#include "AssignmentSolver.hpp"
+#include "Arena.hpp"
+#include "IoLane.hpp"
+#include <deque>
+#include <queue>
+#include <numeric>
 
-#define MAXCLIENTS 4
-typedef struct pollfd toPoll;
+#define MAXCLIENTS 64   ///< Connections (kids, relays, other Moms) at the same time; later arrivals are turned away<br>
+#define MAXSESSIONS 4096 ///< Sessions in all, counting kids behind relays<br>
+#define SPLIT_MIN_SLOW 4 ///< Slowest jobs, from this `slow` up, are the ones Mom may split<br>
+#define SPLIT_PIECE_SLOW 2 ///< Most `slow` in one piece of a split job<br>
+#define EDF_LOOKAHEAD 16 ///< Jobs Mom takes in ahead of the table when deadlines are on, to pick the most urgent<br>
+#define MAX_QUEUES 64    ///< Named job queues; a kid's subscriptions are one bit each<br>
 
 /**
  * @class Mom<br>
  * Controller class for the server (Mom) in the client-server simulation.<br>
  * Handles job table management, socket communication, client processing, and job assignment.<br>
+ * In a cluster (joinCluster()), also trades jobs and earnings with the other Moms.<br>
  */
 class Mom {
 private:
+    /**
+     * @struct Session<br>
+     * A connected kid (or relay, or Mom): its buffered connection and the name it was given on joining.<br>
+     * A kid behind a relay has no link of its own; everything for it goes through the relay's.<br>
+     */
+    struct Session {
+        Pool<Connection>::Ptr link;   ///< Null for a kid behind a relay<br>
+        string name;
+        TableFormat format = TableFormat::SHORTS;
+        short holding = 0;   ///< Jobs WORKING for this kid, the current one and any reserved<br>
+        int peer = 0;        ///< Port of the Mom on the other end (PEER_HELLO), or 0 for a kid<br>
+        short via = -1;      ///< Session of the relay this kid is behind, or -1<br>
+        short next = -1;     ///< For a relay: the session named by its last VIA, waiting for its message<br>
+        bool relay = false;  ///< Has attached kids (ATTACH)<br>
+        bool held = false;   ///< A claim that came over this link waits in the batch, so its later replies must too<br>
+        uint64_t queues = 0; ///< Job queues subscribed to, one bit each; none sees the whole table<br>
+        short lane = -1;     ///< I/O lane that owns the kid's transport, or -1 if Mom's own loop does (see setIoThreads())<br>
+        vector<short> view;  ///< Table slot behind each slot of the kid's table, when it has subscribed<br>
+    };
+
+    /**
+     * @struct Queue<br>
+     * A named run of table slots with its own job supply (see addQueue()).<br>
+     */
+    struct Queue {
+        string name;
+        short first;         ///< First slot of the run<br>
+        short slots;         ///< Slots in the run<br>
+        unique_ptr<JobSource> supply; ///< Where its jobs come from, or null for Mom's `supply`<br>
+        uint32_t version = 1; ///< Bumped whenever one of its slots changes<br>
+        short subscribers = 0; ///< Kids subscribed now<br>
+        long taken = 0;      ///< Jobs taken from its own supply<br>
+        long done = 0;       ///< Jobs completed in it<br>
+    };
+
+    /**
+     * @struct View<br>
+     * The table as kids subscribed to one set of queues see it, in each encoding, with the version it was made at.<br>
+     */
+    struct View {
+        vector<short> rows;
+        uint32_t rowsVersion = 0;
+        string packed;
+        uint32_t packedVersion = 0;
+    };
+
+    /**
+     * @struct Split<br>
+     * A job Mom divided into pieces, some still out.<br>
+     */
+    struct Split {
+        Job whole;           ///< The job as it was before splitting<br>
+        uint32_t node;       ///< Its job in `graph`, if there is one<br>
+        short left;          ///< Pieces not yet complete<br>
+        double since;        ///< When it was split<br>
+        double due;          ///< The job's deadline, or INFINITY<br>
+        short queue;         ///< Queue of the job's slot; its pieces stay in it<br>
+    };
+
+    /**
+     * @struct Arrival<br>
+     * A job taken in from the supply and waiting for a slot, earliest deadline first.<br>
+     */
+    struct Arrival {
+        double due;          ///< Deadline on Mom's clock, or INFINITY<br>
+        long order;          ///< Arrival number; breaks ties first come, first served<br>
+        Job job;
+        uint32_t node;       ///< Its job in `graph`, if there is one<br>
+        bool operator>(const Arrival& other) const { return due != other.due ? due > other.due : order > other.order; }
+    };
+
+    /**
+     * @struct HeldClaim<br>
+     * A claim waiting for the batch to be solved.<br>
+     */
+    struct HeldClaim {
+        short session;
+        Message request;     ///< WANT_JOB, WANT_JOBS, or DONE_AND_NEXT (already marked done)<br>
+    };
+
+    Arena memory;                          ///< Where Mom's records, session nodes and connections live<br>
     JobTable table;                        ///< Shared table containing the list of jobs<br>
-    const string kidNames[4] = {"Ali", "Cory", "Lee", "Pat"}; ///< Names of connected kids<br>
-    vector<Job> completedJobs;            ///< Stores completed jobs for post-run analysis<br>
-    time_t startTime;                     ///< Start time of simulation<br>
-    time_t currentTime;                   ///< Current time during simulation<br>
-    int fd = -1;                          ///< File descriptor for Mom's main socket<br>
-    sockaddr_in info;                     ///< Socket address info<br>
-    short entireJT[60];                   ///< Encoded job table array for transmission<br>
+    const string kidNames[4] = {"Ali", "Cory", "Lee", "Pat"}; ///< Base names; later kids get numbered repeats<br>
+    ArenaList<pair<Job, string>> completedJobs{memory}; ///< Completed jobs and who did them, for post-run analysis<br>
+    Clock* clock = &Clock::wall();        ///< Wall clock, or virtual time when simulated<br>
+    bool simulated = false;               ///< Clock, listener, and engine were supplied by attach()<br>
+    double runSeconds = 21;               ///< Length of the run<br>
+    double startTime;                     ///< Start time of simulation<br>
+    double currentTime;                   ///< Current time during simulation<br>
+    TransportKind transport;              ///< How kids connect to Mom<br>
+    IoEngineKind io;                      ///< How Mom waits for kid traffic<br>
+    unique_ptr<IoEngine> engine;          ///< Poll or io_uring engine behind the dispatch loop<br>
+    unique_ptr<Listener> welcomeSock;     ///< Mom's welcome point for new kids<br>
+    Pool<Connection> links{memory};       ///< Connections of kids that left, buffers kept, for the next to join<br>
+    ArenaMap<short, Session> kids;        ///< Connected kids by session ID<br>
+    ArenaMap<Transport*, short> sessionOf; ///< Session ID behind each watched transport<br>
+    int laneCount = 0;                    ///< I/O threads to run; 0 keeps all I/O on Mom's own thread<br>
+    Doorbell* bell = nullptr;             ///< Rung by the lanes when they push a request<br>
+    unique_ptr<Transport> bellLink;       ///< The bell as Mom's engine watches it<br>
+    unique_ptr<MpmcRing<IoLane::Request>> requests; ///< Decoded messages from every lane, in arrival order per kid<br>
+    vector<unique_ptr<IoLane>> lanes;     ///< The I/O threads<br>
+    vector<short> piped;                  ///< Sessions whose link belongs to a lane<br>
+    size_t nextLane = 0;                  ///< Lane the next kid is handed to, round-robin<br>
+    IoLane::Reply reply;                  ///< Scratch for posting replies<br>
+    long requestsTaken = 0;               ///< Requests popped from `requests`<br>
+    long repliesPosted = 0;               ///< Replies posted to the lanes<br>
+    SessionPool sessionIds;               ///< Recycled session IDs<br>
+    long joins = 0;                       ///< Kids admitted so far, for naming<br>
+    vector<short> rows;                   ///< Table as seven shorts per slot, for SHORTS and the snapshot<br>
+    string packed;                        ///< Table in the PACKED encoding<br>
+    bool rowsFresh = false;               ///< `rows` matches the table<br>
+    bool packedFresh = false;             ///< `packed` matches the table<br>
+    long tablesSent = 0;                  ///< NEED_JOB replies, for the report<br>
+    long tableBytes = 0;                  ///< Bytes in those replies<br>
+    uint32_t tableVersion = 1;            ///< Bumped on every table change; never 0<br>
+    long notModified = 0;                 ///< NEED_JOB_SINCE requests answered NOT_MODIFIED<br>
+    long claimsGranted = 0;               ///< Claimed jobs handed out, for the report<br>
+    long claimsTaken = 0;                 ///< Claims refused because someone had the job<br>
+    long claimsStale = 0;                 ///< Claims refused because the slot had moved on to a newer job<br>
+    long claimsOverLimit = 0;             ///< Claims refused because the kid already held its limit<br>
+    short reservationLimit = 1;           ///< Jobs a kid may hold beyond the one it is working on<br>
+    unique_ptr<SharedTable> snapshot;     ///< Shared-memory copy of the table for local kids<br>
     short message;                        ///< Message buffer for socket communication<br>
-    short kidID;                          ///< ID assigned to each connected kid<br>
-    short nCli;                           ///< Number of currently active client connections<br>
-    int welcomeFd;                        ///< File descriptor for the welcome socket<br>
-    int status;                           ///< Return value from system calls (poll, read, write)<br>
-    toPoll ufds[MAXCLIENTS + 1];          ///< Poll file descriptors array (1 welcome + MAXCLIENTS)<br>
-    toPoll* const welcome = &ufds[0];     ///< Pointer to the welcome socket entry<br>
-    toPoll* const worker = &ufds[1];      ///< Pointer to the array of worker socket entries<br>
+    long messages = 0;                    ///< Kid messages handled, for the I/O report<br>
+    Tracer* tracer = nullptr;             ///< Span recorder, when the run is traced<br>
+    Capture* capture = nullptr;           ///< Kid traffic recorder, when the run is captured<br>
+    vector<long> jobSerial;               ///< Trace id of the job in each slot<br>
+    long jobsCreated = 0;                 ///< Jobs taken from `supply` so far; the newest one's trace id<br>
+    unique_ptr<JobSource> supply;         ///< Where new jobs come from; random jobs made ahead by default (rolled in place when simulated)<br>
+    vector<char> vacant;                  ///< Slots whose job is done and that `supply` has not refilled yet<br>
+    unique_ptr<JobGraph> graph;           ///< Jobs with prerequisites, used instead of `supply` when set<br>
+    vector<uint32_t> nodeOf;              ///< Job in `graph` each slot holds<br>
+    int port = PORT;                      ///< Where kids (and other Moms) connect<br>
+    unique_ptr<Cluster> cluster;          ///< Links to the other Moms, when there are any<br>
+    long jobsGiven = 0;                   ///< Jobs handed to other Moms that asked with STEAL_JOBS<br>
+    unordered_map<string, long> peerEarnings; ///< Per-kid totals the other Moms reported<br>
+    double claimWindow = 0;               ///< Seconds claims are held and then assigned together; 0 answers each at once<br>
+    bool claimForJobs = false;            ///< Batches maximise jobs handed out, then value, rather than value alone<br>
+    vector<HeldClaim> batch;              ///< Claims held until `batchDue`<br>
+    double batchDue = 0;                  ///< When the batch is assigned: its first claim's arrival plus the window;
+                                          ///< the wait and the solve test both use it, so they can't disagree<br>
+    vector<HeldClaim> solving;            ///< The batch solveClaims() is assigning; it and what follows are
+                                          ///< kept between batches so a solve reuses their memory<br>
+    vector<vector<pair<int, long>>> claimOptions; ///< Open candidates of each claim, with their worth<br>
+    vector<short> claimRoom;              ///< Jobs each claim may still be granted<br>
+    vector<uint16_t> claimStale;          ///< Stale-candidate mask of each claim<br>
+    vector<size_t> claimFirstBid;         ///< Each claim's first bidder in `solver`; one extra entry at the end<br>
+    vector<short> heldOwners;             ///< Links to release after a solve<br>
+    AssignmentSolver solver;              ///< Assigns each batch<br>
+    long batchesSolved = 0;               ///< Batches assigned, for the report<br>
+    long claimsBatched = 0;               ///< Claims in those batches<br>
+    double solveSeconds = 0;              ///< Real time spent solving them<br>
+    double slowestSolve = 0;              ///< Longest single solve<br>
+    double splitAfter = 0;                ///< Seconds a slow job may wait unclaimed before it is split; 0 never splits<br>
+    ArenaMap<long, Split> splits;         ///< Split jobs with pieces still out, by split number<br>
+    long nextSplit = 0;                   ///< Number of the next split<br>
+    vector<long> pieceOf;                 ///< Split each slot's job is a piece of, or -1<br>
+    vector<double> postedAt;              ///< When each slot's job went on the table<br>
+    deque<pair<long, Job>, ArenaAllocator<pair<long, Job>>> pieces{memory}; ///< Pieces waiting for a slot, ahead of `supply`<br>
+    long jobsSplit = 0;                   ///< Jobs split, for the report<br>
+    long piecesMade = 0;                  ///< Pieces they were split into<br>
+    long splitsFinished = 0;              ///< Split jobs whose pieces are all complete<br>
+    double splitSeconds = 0;              ///< Time from split to last piece, summed over those<br>
+    bool deadlines = false;               ///< Jobs have deadlines and slots are filled earliest deadline first<br>
+    double deadlineSlack = 0;             ///< Seconds beyond its `slow` a job without its own deadline is given<br>
+    priority_queue<Arrival, vector<Arrival>, greater<Arrival>> early; ///< Jobs taken in and not yet on the table<br>
+    deque<Arrival> hopeless;              ///< Jobs taken in that can no longer make their deadline, oldest first<br>
+    long arrivals = 0;                    ///< Jobs taken in so far<br>
+    vector<double> dueAt;                 ///< Deadline of each slot's job, or INFINITY<br>
+    long deadlinesMet = 0;                ///< Jobs done by their deadline<br>
+    long deadlinesMissed = 0;             ///< Jobs done after it<br>
+    double lateSeconds = 0;               ///< How late those were, summed<br>
+    short peersReported = 0;              ///< Other Moms whose EARNINGS have all arrived<br>
+    vector<Queue> queues;                 ///< Named job queues, in slot order; none means one unnamed table<br>
+    vector<short> queueAt;                ///< Queue each slot belongs to<br>
+    vector<short> seenRows;               ///< Rows as of the last publish, to tell which queues changed<br>
+    unordered_map<uint64_t, View> views;  ///< Encoded tables per set of queues subscribed to<br>
+
+    /**
+     * Accepts every kid waiting on the welcome listener and gives each a session.<br>
+     */
+    void admitKids();
+
+    /**
+     * Closes a kid's session and puts the jobs it was working on back in the table.<br>
+     * @param session Session ID of the kid<br>
+     */
+    void dropKid(short session);
 
     /**
-     * Accepts new connections from kids and sets up poll descriptors.<br>
+     * @return Name of the kid holding `session`, or a placeholder if it has left<br>
      */
-    void addClient();
+    string nameOf(short session) const;
+
+    /**
+     * Renames a session that turned out not to be a kid, handing its kid name back if nobody joined since.<br>
+     */
+    void renameSession(short session, const string& name);
+
+    /**
+     * @return The connection replies for `session` go on: its own, or its relay's<br>
+     */
+    Connection& linkOf(short session);
+
+    /**
+     * Opens a session for a kid behind the relay on `relay` (ATTACH) and queues ACK and its ID.<br>
+     */
+    void attachKid(short relay);
+
+    /**
+     * Marks job `index` WORKING for the kid if it is free; does not republish.<br>
+     * @return true if the job was granted<br>
+     */
+    bool grantJob(short session, int index);
 
     /**
      * Handles job assignment logic for a given kid.<br>
-     * @param kidIndex Index of the kid in the poll array<br>
+     * @param session Session ID of the kid<br>
      * @param jobChoiceIndex Index of the selected job in the job table<br>
+     * @param generation Generation the kid saw in that slot<br>
+     */
+    void jobRequest(short session, int jobChoiceIndex, uint16_t generation);
+
+    /**
+     * Grants up to `request.wanted` of the candidates and queues ACK plus
+     * bitmasks of the grants and of the candidates whose generation was stale.<br>
+     */
+    void claimJobs(short session, const Message& request);
+
+    /**
+     * Adds a claim to the batch and holds the link it came over.<br>
+     */
+    void holdClaim(short session, const Message& request);
+
+    /**
+     * Assigns every held claim at once, queues the replies in arrival order, and releases the held links.<br>
+     */
+    void solveClaims();
+
+    /**
+     * Marks job `index` COMPLETE and replaces it, if `session` is working on it.<br>
      */
-    void jobRequest(short kidIndex, short jobChoiceIndex);
+    void jobDone(short session, int index);
 
     /**
-     * Processes incoming messages from a specific kid.<br>
-     * @param kidIndex Index of the kid in the poll array<br>
+     * Hands up to `count` open jobs to the Mom on `session` and queues them as the reply.<br>
      */
-    void processMessage(short kidIndex);
+    void giveJobs(short session, short count);
+
+    /**
+     * Sends this Mom's per-kid totals to the other Moms and waits a while for theirs.<br>
+     */
+    void collectEarnings(const unordered_map<string, long>& totals);
+
+    /**
+     * Subscribes a kid to queue `name` and queues ACK, or NACK if there is no such queue.<br>
+     */
+    void subscribe(short session, const string& name);
+
+    /**
+     * @return Version of the table seen by a kid subscribed to `subscribed`: the sum of its queues' versions, or `tableVersion` for none<br>
+     */
+    uint32_t versionOf(uint64_t subscribed) const;
+
+    /**
+     * @return The slots of the queues in `subscribed` as a table of their own, numbered from 0<br>
+     */
+    JobTable viewTable(uint64_t subscribed) const;
+
+    /**
+     * @return The slots of the queues in `subscribed` as rows, re-encoded only after one of them changes<br>
+     */
+    const vector<short>& viewRows(uint64_t subscribed);
+
+    /**
+     * @return The slots of the queues in `subscribed` in the PACKED encoding, re-encoded only after one of them changes<br>
+     */
+    const string& packedView(uint64_t subscribed);
+
+    /**
+     * @return The table as rows of seven shorts, re-encoded only after a change<br>
+     */
+    const vector<short>& tableRows();
+
+    /**
+     * @return The table in the PACKED encoding, re-encoded only after a change<br>
+     */
+    const string& packedTable();
+
+    /**
+     * Marks the encodings stale, moves on the version of every queue whose
+     * slots changed, and republishes the shared-memory snapshot, if there is one.<br>
+     */
+    void publishTable();
+
+    /**
+     * Acts on one complete message from a kid.<br>
+     * @param session Session ID of the kid<br>
+     * @param request The message, as reassembled by the kid's Connection<br>
+     */
+    void processMessage(short session, const Message& request);
+
+    /**
+     * Moves a kid's queued output, reads its input, and handles every complete message.<br>
+     * @param session Session ID of the kid<br>
+     * @return false if the kid disconnected and was removed<br>
+     */
+    bool serviceKid(short session);
+
+    /**
+     * Handles the complete messages in a connection's input, stopping at a
+     * reply that must wait for the batch.<br>
+     */
+    void handleMessages(short session);
+
+    /**
+     * Handles one message that came in over `session`'s link: follows VIA,
+     * maps a subscribed kid's job indices, and processes it.<br>
+     */
+    void dispatch(short session, Message& request);
+
+    /**
+     * Starts the I/O lanes and watches the doorbell they ring.<br>
+     */
+    void startLanes();
+
+    /**
+     * Handles the requests the lanes have pushed; a hung-up kid is dropped.<br>
+     */
+    void takeRequests();
+
+    /**
+     * Posts each piped kid's queued replies to its lane.<br>
+     */
+    void postReplies();
+
+    /**
+     * Keeps flushing queued output until it is all sent or `seconds` pass.<br>
+     */
+    void finishOutput(int seconds);
+
+    /**
+     * Puts the next job from the slot's queue's supply (or the next ready one from `graph`) in `slot`, one generation on.<br>
+     * @return false if the supply had none; the slot is left vacant: COMPLETE, numbered, held by nobody (-1)<br>
+     */
+    bool refillSlot(short slot);
+
+    /**
+     * Puts `job` in `slot`, one generation on, as a piece of split `piece` (or -1).<br>
+     */
+    void placeJob(short slot, Job job, long piece, double due);
+
+    /**
+     * Takes the next job from the graph, the supply of `queue`, or what was stolen, in that order of preference.<br>
+     * @return false if none has one<br>
+     */
+    bool takeJob(Job& job, uint32_t& node, short queue);
+
+    /**
+     * Tops the jobs taken in up to EDF_LOOKAHEAD and takes the one due first that can still make it.<br>
+     * @return false if there is none<br>
+     */
+    bool takeEarliest(Job& job, uint32_t& node, double& due);
+
+    /**
+     * @return Deadline on Mom's clock of the job in slot `index`, or INFINITY<br>
+     */
+    double dueOf(int index) const { return index >= 0 && index < table.size() ? dueAt[index] : INFINITY; }
+
+    /**
+     * Counts a job finished now as meeting or missing deadline `due`.<br>
+     */
+    void checkDeadline(double due);
+
+    /**
+     * Splits one slow, long-unclaimed job into pieces if kids stand idle.<br>
+     */
+    void splitJobs();
+
+    /**
+     * Records a piece as complete, and its split job once every piece is.<br>
+     */
+    void finishPiece(short slot);
+
+    /**
+     * Gives the job now in `slot` a trace id and opens its "job" and "waiting" spans.<br>
+     */
+    void traceNewJob(short slot);
 
 public:
     /**
-     * Default constructor<br>
+     * Constructor<br>
+     * @param transport How kids will connect (TCP by default)<br>
+     * @param io I/O engine for the dispatch loop (poll by default)<br>
      */
-    Mom() = default;
+    explicit Mom(TransportKind transport = TransportKind::TCP, IoEngineKind io = IoEngineKind::POLL)
+        : transport(transport), io(io), kids(memory), sessionOf(memory), splits(memory) {}
 
     /**
      * Default destructor<br>
@@ -60,7 +440,119 @@ public:
     ~Mom() = default;
 
     /**
-     * Initializes the job table with 10 new jobs.<br>
+     * Runs Mom on a supplied clock, listener, and engine instead of real
+     * sockets and time; no shared-memory snapshot is published.<br>
+     */
+    void attach(Clock& clock, unique_ptr<Listener> welcome, unique_ptr<IoEngine> engine);
+
+    /**
+     * Sets how long run() keeps dispatching (21 seconds by default).<br>
+     */
+    void runFor(double seconds) { runSeconds = seconds; }
+
+    /**
+     * Takes new jobs from `source` instead of rolling them; it runs on a producer thread.<br>
+     */
+    void setJobSource(unique_ptr<JobSource> source) { supply = make_unique<JobProducer>(std::move(source)); }
+
+    /**
+     * Takes jobs from `graph`, each once its prerequisites are done, and
+     * ends the run early once all of them are; not for a cluster.<br>
+     */
+    void setJobGraph(unique_ptr<JobGraph> graph) { this->graph = std::move(graph); }
+
+    /**
+     * Sets the port kids connect to (PORT by default); call before run() and joinCluster().<br>
+     */
+    void setPort(int port) { this->port = port; }
+
+    /**
+     * Joins the Moms on `ports` (TCP or UNIX transport) and takes this Mom's
+     * share of `source`; every Mom should be given the same ports and source.<br>
+     */
+    void joinCluster(const vector<int>& ports, unique_ptr<JobSource> source);
+
+    /**
+     * Sets how many jobs a kid may reserve beyond the one it is working on (1 by default).<br>
+     */
+    void setReservationLimit(short limit) { reservationLimit = limit; }
+
+    /**
+     * Holds claims for `seconds` and assigns them together (see solveClaims()),
+     * for the most jobs handed out if `forJobs`, else the most value; 0 turns batching off.<br>
+     */
+    void setClaimWindow(double seconds, bool forJobs) { claimWindow = seconds; claimForJobs = forJobs; }
+
+    /**
+     * Lets Mom split a slow job that has waited `seconds` unclaimed while kids
+     * stand idle (see splitJobs()); 0 (the default) never splits.<br>
+     */
+    void setSplitAfter(double seconds) { splitAfter = seconds; }
+
+    /**
+     * Gives every job a deadline: its own (from a job file), or `slack`
+     * seconds beyond its `slow`, counted from when Mom takes it in. Slots are
+     * then filled, and claims granted, earliest deadline first.<br>
+     */
+    void setDeadlines(double slack) { deadlines = true; deadlineSlack = slack; }
+
+    /**
+     * Moves reading, decoding and writing to `count` I/O threads, leaving
+     * Mom's thread to schedule; 0 (the default) does everything on Mom's
+     * thread. Not with a claim window or a cluster; call before run().<br>
+     */
+    void setIoThreads(int count) { laneCount = count; }
+
+    /**
+     * Maps Mom's arena in huge pages where the system allows it; call before run().<br>
+     */
+    void useHugePages() { memory.useHugePages(true); }
+
+    /**
+     * Sets the number of job slots (JOB_SLOTS by default); call before run().<br>
+     */
+    void setTableSize(short slots) { table.resize(slots); }
+
+    /**
+     * Adds a named queue of `slots` slots after the ones already added, fed
+     * from `source`, or from Mom's own supply if null. With queues the table
+     * is exactly their slots; kids that subscribe see only theirs.<br>
+     * @throws Terminates the program if the name is taken or there are too many queues or slots.<br>
+     */
+    void addQueue(const string& name, short slots, unique_ptr<JobSource> source);
+
+    /**
+     * Records job lifecycles, waits, and per-kid servicing into `tracer`.<br>
+     */
+    void traceTo(Tracer& tracer);
+
+    /**
+     * Records every kid's joining, messages and leaving into `capture`, for replay.<br>
+     */
+    void captureTo(Capture& capture) { this->capture = &capture; }
+
+    /**
+     * Names the `serial`-th kid to join: Ali, Cory, Lee, Pat, then Ali2, Cory2, ...<br>
+     */
+    string kidName(long serial) const;
+
+    /**
+     * @return Every job completed so far and the name of the kid who did it<br>
+     */
+    const ArenaList<pair<Job, string>>& results() const { return completedJobs; }
+
+    /**
+     * @return Kid messages handled so far<br>
+     */
+    long messageCount() const { return messages; }
+
+    /**
+     * @return The job table as it stands<br>
+     */
+    const JobTable& jobTable() const { return table; }
+
+    /**
+     * Fills every slot of the job table with a new job.<br>
      */
     void initializeJobTable();
 
@@ -71,7 +563,7 @@ public:
 
     /**
      * Main run loop for the Mom server.<br>
-     * Starts server, accepts connections, polls for messages, and manages job flow.<br>
+     * Starts server, admits and drops kids as they come and go, polls for messages, and manages job flow.<br>
      */
     void run();
 
@@ -83,21 +575,17 @@ public:
     ostream& print(ostream& os) const;
 
     /**
-     * Updates Mom's socket information using getsockname.<br>
-     */
-    void refresh();
-
-    /**
-     * Creates, binds, and listens on a socket at a given port.<br>
-     * @param port Port number to bind and listen on<br>
+     * Opens the welcome listener for the chosen transport.<br>
+     * @param port Port number (TCP) or socket-file suffix (UNIX, SHM)<br>
      */
     void listen(int port);
 
     /**
-     * Sends the current job table to a connected kid.<br>
-     * @param fd File descriptor of the kid's socket<br>
+     * Queues the current job table, or the kid's queues of it, for a connected kid.<br>
+     * @param session Session ID of the kid<br>
+     * @param versioned Put the table version ahead of the table (reply to NEED_JOB_SINCE)<br>
      */
-    void sendJobTable(int fd);
+    void sendJobTable(short session, bool versioned);
 };
 
 /**
@@ -0,0 +1,99 @@
+#pragma once
+#include "tools.hpp"
+#include <atomic>
+
+/**
+ * @class MpmcRing<br>
+ * Bounded lock-free queue any number of threads may push to and pop from.<br>
+ * -------------------------------------------------------<br>
+ * - Dmitry Vyukov's design: every cell carries a sequence number that says
+ *   whose turn it is. A producer claims a position by moving `tail` on with
+ *   a compare-and-swap, fills the cell, then publishes it by setting its
+ *   sequence; consumers do the same with `head`. Nobody ever waits on a
+ *   lock, and a full or empty ring is reported rather than waited out.<br>
+ * - Items are swapped in and out rather than copied: push() leaves the
+ *   caller holding what the cell held before, and pop() leaves the cell
+ *   holding what the caller held. Strings and vectors in the items keep
+ *   circulating with their capacity, so a warmed-up ring allocates nothing.<br>
+ * - Capacity is rounded up to a power of two so positions wrap with a mask.<br>
+ * -------------------------------------------------------<br>
+ */
+template <typename T>
+class MpmcRing {
+private:
+    /**
+     * @struct Cell<br>
+     * One slot: its turn number and the item.<br>
+     */
+    struct Cell {
+        atomic<size_t> sequence{0};   ///< Position it can next be pushed at, or that position + 1 once full<br>
+        T item{};
+    };
+
+    vector<Cell> cells;               ///< Ring storage<br>
+    size_t mask;                      ///< Capacity - 1<br>
+    alignas(64) atomic<size_t> head{0}; ///< Next position to pop<br>
+    alignas(64) atomic<size_t> tail{0}; ///< Next position to push<br>
+
+    static size_t roundUp(size_t n) {
+        size_t size = 1;
+        while (size < n) size <<= 1;
+        return size;
+    }
+
+public:
+    /**
+     * @param capacity Smallest number of items the ring must hold<br>
+     */
+    explicit MpmcRing(size_t capacity) : cells(roundUp(capacity)), mask(roundUp(capacity) - 1) {
+        for (size_t i = 0; i <= mask; i++) cells[i].sequence.store(i, memory_order_relaxed);
+    }
+
+    /**
+     * Swaps `item` into the ring; `item` is left with a spent item to reuse or drop.<br>
+     * @return false, leaving `item` alone, if the ring is full<br>
+     */
+    bool push(T& item) {
+        size_t at = tail.load(memory_order_relaxed);
+        Cell* cell;
+        for (;;) {
+            cell = &cells[at & mask];
+            size_t sequence = cell->sequence.load(memory_order_acquire);
+            long lag = long(sequence) - long(at);
+            if (lag == 0 && tail.compare_exchange_weak(at, at + 1, memory_order_relaxed)) break;
+            if (lag < 0) return false;
+            if (lag > 0) at = tail.load(memory_order_relaxed);
+        }
+        swap(cell->item, item);
+        cell->sequence.store(at + 1, memory_order_release);
+        return true;
+    }
+
+    /**
+     * Swaps the oldest item out of the ring into `item`.<br>
+     * @return false if the ring is empty<br>
+     */
+    bool pop(T& item) {
+        size_t at = head.load(memory_order_relaxed);
+        Cell* cell;
+        for (;;) {
+            cell = &cells[at & mask];
+            size_t sequence = cell->sequence.load(memory_order_acquire);
+            long lag = long(sequence) - long(at + 1);
+            if (lag == 0 && head.compare_exchange_weak(at, at + 1, memory_order_relaxed)) break;
+            if (lag < 0) return false;
+            if (lag > 0) at = head.load(memory_order_relaxed);
+        }
+        swap(item, cell->item);
+        cell->sequence.store(at + mask + 1, memory_order_release);
+        return true;
+    }
+
+    /**
+     * @return true if nothing has been pushed that hasn't been popped; a push
+     * still being filled in counts, so pop() may briefly fail after false<br>
+     */
+    bool empty() const { return head.load(memory_order_seq_cst) == tail.load(memory_order_seq_cst); }
+
+    size_t capacity() const { return mask + 1; }
+};
@@ -28,7 +28,8 @@ Printer::Printer() {
  * @param out Reference to the output stream (e.g., std::cout).<br>
  * -------------------------------------------------------<br>
  */
-void Printer::write(const string& message , ostream& out) {
+void Printer::write(string_view message , ostream& out) {
+    if (muted) return;
     out<<message;
     instance.file << message;
 }
@@ -39,14 +40,19 @@ void Printer::write(const string& message , ostream& out) {
  * -------------------------------------------------------
  * - Outputs the contents of the stream to the given `ostream` (e.g., `cout`).
  * - Also writes the same content to an internal log file.
+ * - Both are copied straight out of the stream's buffer rather than
+ *   through str(), which would build a string for every line.
  * - Clears the stringstream after writing to avoid duplication.
  * -------------------------------------------------------
  * @param stream Reference to the stringstream holding the content.<br>
  * @param out Output stream to write to (e.g., `cout`, `cerr`).<br>
  */
 void Printer::write(stringstream& stream , ostream& out) {
-    out<<stream.str();
-    instance.file << stream.str();
+    if (!muted && stream.rdbuf()->in_avail() > 0) {
+        out<<stream.rdbuf();
+        stream.seekg(0);
+        instance.file << stream.rdbuf();
+    }
     stream.str("");
     stream.clear();
 }
@@ -61,7 +67,8 @@ void Printer::write(stringstream& stream , ostream& out) {
  * @param message The message string to be written.
  * @param out Output stream to write to (e.g., `cout`, `cerr`).
  */
-void Printer::writeln(const string& message , ostream& out) {
+void Printer::writeln(string_view message , ostream& out) {
+    if (muted) return;
     out<<message<<'\n';
     instance.file << message<<'\n';
 }
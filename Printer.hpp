@@ -18,6 +18,7 @@ private:
     ~Printer();                   ///< Destructor that closes the file stream<br>
     ofstream file;               ///< Output file stream<br>
     static Printer instance;     ///< Singleton instance of the Printer class<br>
+    static inline bool muted = false; ///< Drop all output (batch simulations)<br>
 
 public:
     /**
@@ -26,12 +27,19 @@ public:
      */
     static void getControl(ofstream&& out);
 
+    /**
+     * Turns all output off or back on; stringstreams are still cleared while muted.<br>
+     * @param on true to drop everything written from now on<br>
+     */
+    static void mute(bool on) { muted = on; }
+
     /**
      * Writes a plain string to both the file and the provided ostream.<br>
+     * Takes a view, so a literal is written without building a string.<br>
      * @param message Message to be printed<br>
      * @param out Output stream (e.g., std::cout)<br>
      */
-    static void write(const string& message, ostream& out);
+    static void write(string_view message, ostream& out);
 
     /**
      * Writes a stringstream's content to both the file and provided ostream.<br>
@@ -46,5 +54,5 @@ public:
      * @param message The message to be written<br>
      * @param out Output stream (e.g., std::cout)<br>
      */
-    static void writeln(const string& message, ostream& out);
+    static void writeln(string_view message, ostream& out);
 };
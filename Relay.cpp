@@ -0,0 +1,385 @@
+#include "Relay.hpp"
+#include "Printer.hpp"
+#include "Clock.hpp"
+
+/**
+ * Admits every kid waiting on the welcome listener. <br>
+ * -------------------------------------------------------
+ * - Kids are spread over the upstream links in turn.
+ * - Nothing is sent to the kid yet: its greeting is Mom's answer to ATTACH.
+ * -------------------------------------------------------
+ */
+void Relay::admitKids() {
+    while (unique_ptr<Transport> link = engine->accept(*welcomeSock)) {
+        long key = joins++;
+        Downstream& kid = kids[key];
+        kid.link = kidLinks.take();
+        kid.link->open(engine->add(std::move(link)));
+        kid.upstream = key % upstream.size();
+        kidOf[&kid.link->transport()] = key;
+        Message attach;
+        attach.code = static_cast<short>(messageCodes::ATTACH);
+        ask(kid.upstream, key, attach);
+        served++;
+    }
+}
+
+/**
+ * Forgets a kid that hung up. <br>
+ * -------------------------------------------------------
+ * - Mom is told with DETACH so its jobs go back on her table, as are the
+ *   kids of a relay below it; replies still owed to it are thrown away
+ *   when they arrive.
+ * -------------------------------------------------------
+ */
+void Relay::dropKid(long key) {
+    Downstream& kid = kids[key];
+    engine->remove(kid.link->transport());
+    kidOf.erase(&kid.link->transport());
+    Message detach;
+    detach.code = static_cast<short>(messageCodes::DETACH);
+    for (short rider : kid.riders) {
+        detach.arg = rider;
+        ask(kid.upstream, -1, detach);
+    }
+    if (kid.session >= 0) {
+        detach.arg = kid.session;
+        ask(kid.upstream, -1, detach);
+    }
+    kids.erase(key);
+}
+
+void Relay::flushKid(Downstream& kid) {
+    kid.link->flush();
+    engine->watch(kid.link->transport(), !kid.link->throttled(), kid.link->backlog() > 0);
+}
+
+/**
+ * Handles every complete message from a kid. <br>
+ * -------------------------------------------------------
+ * - USE_FORMAT is answered here; NEED_JOB and NEED_JOB_SINCE from the cache.
+ * - SUBSCRIBE is refused (NACK): the cache is the whole table, so a kid
+ *   wanting only some queues must connect to Mom herself.
+ * - Claims and completions go to Mom for the kid's session, and the cache
+ *   is marked out of date, since the table is about to change.
+ * - From a relay below: ATTACH and DETACH go up as they are, and a VIA
+ *   makes its next message go up for the session it names.
+ * - Anything else is ignored, as Mom would.
+ * -------------------------------------------------------
+ */
+void Relay::serviceKid(long key) {
+    Downstream& kid = kids[key];
+    bool open = kid.link->flush() && kid.link->fill();
+    Message request;
+    while (kid.link->nextMessage(request)) {
+        short code = request.code;
+        if (code == static_cast<short>(messageCodes::USE_FORMAT)) {
+            bool known = request.arg == static_cast<short>(TableFormat::SHORTS) || request.arg == static_cast<short>(TableFormat::PACKED);
+            if (known) kid.format = static_cast<TableFormat>(request.arg);
+            short reply = static_cast<short>(known ? messageCodes::ACK : messageCodes::NACK);
+            kid.link->queue(&reply, sizeof(short));
+        }
+        else if (code == static_cast<short>(messageCodes::SUBSCRIBE)) {
+            short reply = static_cast<short>(messageCodes::NACK);
+            kid.link->queue(&reply, sizeof(short));
+        }
+        else if (code == static_cast<short>(messageCodes::NEED_JOB)) requestTable(key, false, 0);
+        else if (code == static_cast<short>(messageCodes::NEED_JOB_SINCE)) requestTable(key, true, request.arg);
+        else if (kid.session >= 0 && (code == static_cast<short>(messageCodes::WANT_JOB)
+                 || code == static_cast<short>(messageCodes::WANT_JOBS) || code == static_cast<short>(messageCodes::JOB_DONE)
+                 || code == static_cast<short>(messageCodes::DONE_AND_NEXT))) {
+            ask(kid.upstream, key, request, kid.next >= 0 ? kid.next : kid.session);
+            forwarded++;
+            dirty = true;
+        }
+        else if (kid.session >= 0 && code == static_cast<short>(messageCodes::VIA)) {
+            kid.next = request.arg;
+            continue;
+        }
+        else if (kid.session >= 0 && (code == static_cast<short>(messageCodes::ATTACH)
+                 || code == static_cast<short>(messageCodes::DETACH))) {
+            if (code == static_cast<short>(messageCodes::DETACH))
+                kid.riders.erase(remove(kid.riders.begin(), kid.riders.end(), request.arg), kid.riders.end());
+            ask(kid.upstream, key, request, -1, true);
+            forwarded++;
+        }
+        kid.next = -1;
+    }
+    if (open) open = !kid.link->isClosed() && kid.link->flush();
+    if (!open) {
+        dropKid(key);
+        return;
+    }
+    engine->watch(kid.link->transport(), !kid.link->throttled(), kid.link->backlog() > 0);
+}
+
+/**
+ * Queues `message` on a link to Mom. <br>
+ * -------------------------------------------------------
+ * - A kid's message goes behind a VIA with its session, so Mom treats it
+ *   as the kid's; ATTACH, DETACH and the relay's own fetches go bare.
+ * - Nothing is written here: the loop flushes every link once per turn.
+ * -------------------------------------------------------
+ */
+void Relay::ask(size_t link, long kid, const Message& message, short via, bool passOn) {
+    Upstream& mom = upstream[link];
+    short code = message.code;
+    if (via >= 0) {
+        short prefix[2] = {static_cast<short>(messageCodes::VIA), via};
+        mom.link->queue(prefix, sizeof(prefix));
+    }
+    mom.link->queueMessage(message);
+    if (code == static_cast<short>(messageCodes::ATTACH) || code == static_cast<short>(messageCodes::WANT_JOB)
+        || code == static_cast<short>(messageCodes::WANT_JOBS) || code == static_cast<short>(messageCodes::DONE_AND_NEXT)
+        || code == static_cast<short>(messageCodes::NEED_JOB_SINCE))
+        mom.owed.push_back(Pending{kid, code, passOn});
+}
+
+/**
+ * Sizes the reply at the front of Mom's input. <br>
+ * -------------------------------------------------------
+ * - Greeting and ATTACH: ACK and a session ID, or a lone NACK.
+ * - WANT_JOB: ACK or NACK. WANT_JOBS and DONE_AND_NEXT: ACK and two masks.
+ * - NEED_JOB_SINCE: NOT_MODIFIED, or ACK, the version, the slot count and
+ *   ROW_SHORTS shorts per slot (the relay never asks for packed tables).
+ * -------------------------------------------------------
+ */
+size_t Relay::replyBytes(const Pending& owed, const Connection& mom) {
+    short first;
+    if (!mom.peek(&first, sizeof(short))) return 0;
+    bool ack = first == static_cast<short>(messageCodes::ACK);
+    size_t size = sizeof(short);
+    if (owed.code == static_cast<short>(messageCodes::ACK) || owed.code == static_cast<short>(messageCodes::ATTACH))
+        size += ack ? sizeof(short) : 0;
+    else if (owed.code == static_cast<short>(messageCodes::WANT_JOBS) || owed.code == static_cast<short>(messageCodes::DONE_AND_NEXT))
+        size += 2 * sizeof(short);
+    else if (owed.code == static_cast<short>(messageCodes::NEED_JOB_SINCE) && ack) {
+        char head[sizeof(short) + sizeof(uint32_t) + sizeof(short)];
+        if (!mom.peek(head, sizeof(head))) return 0;
+        short slots;
+        memcpy(&slots, head + sizeof(short) + sizeof(uint32_t), sizeof(short));
+        size = sizeof(head) + max<short>(slots, 0) * ROW_SHORTS * sizeof(short);
+    }
+    return mom.buffered() >= size ? size : 0;
+}
+
+/**
+ * Hands out one reply from Mom. <br>
+ * -------------------------------------------------------
+ * - A table refreshes the cache and answers every kid waiting for it.
+ * - An ATTACH answer becomes the kid's greeting; if the kid left in the
+ *   meantime, its new session is given straight back with DETACH.
+ * - Claim answers, and answers to a relay below, go on as they are; a
+ *   relay below that has gone gives back sessions the same way.
+ * -------------------------------------------------------
+ */
+void Relay::deliver(size_t link, const Pending& owed, const string& reply) {
+    short code;
+    memcpy(&code, reply.data(), sizeof(short));
+    if (owed.code == static_cast<short>(messageCodes::ACK)) return;
+    if (owed.code == static_cast<short>(messageCodes::NEED_JOB_SINCE)) {
+        fetching = dirty = false;
+        fetchedAt = Clock::wall().now();
+        if (code == static_cast<short>(messageCodes::NOT_MODIFIED)) unchanged++;
+        else {
+            short slots;
+            memcpy(&cacheVersion, reply.data() + sizeof(short), sizeof(uint32_t));
+            memcpy(&slots, reply.data() + sizeof(short) + sizeof(uint32_t), sizeof(short));
+            vector<short> table(slots * ROW_SHORTS);
+            memcpy(table.data(), reply.data() + 2 * sizeof(short) + sizeof(uint32_t), table.size() * sizeof(short));
+            if (!TableCodec::decodeRows(table.data(), slots, cache)) fatal("Malformed job table from Mom");
+            rowsFresh = packedFresh = false;
+        }
+        for (const TableRequest& request : waiting) {
+            auto found = kids.find(request.kid);
+            if (found == kids.end()) continue;
+            sendTable(found->second, request.since, request.version);
+            flushKid(found->second);
+        }
+        waiting.clear();
+        return;
+    }
+    auto found = kids.find(owed.kid);
+    if (owed.code == static_cast<short>(messageCodes::ATTACH) && (!owed.passOn || found == kids.end())) {
+        short session;
+        if (code == static_cast<short>(messageCodes::ACK)) memcpy(&session, reply.data() + sizeof(short), sizeof(short));
+        if (found == kids.end()) {
+            if (code != static_cast<short>(messageCodes::ACK)) return;
+            Message detach;
+            detach.code = static_cast<short>(messageCodes::DETACH);
+            detach.arg = session;
+            ask(link, -1, detach);
+            return;
+        }
+        if (code == static_cast<short>(messageCodes::ACK)) {
+            found->second.session = session;
+            found->second.link->queue(reply.data(), reply.size());
+            ss << "Kid " << session << " has joined Mom through the relay" << endl;
+            Printer::write(ss, cout);
+        }
+        else {
+            short quit = static_cast<short>(messageCodes::QUIT);
+            found->second.link->queue(&quit, sizeof(short));
+        }
+        flushKid(found->second);
+        return;
+    }
+    dirty = true;
+    if (found == kids.end()) return;
+    if (owed.passOn && code == static_cast<short>(messageCodes::ACK)) {
+        short session;
+        memcpy(&session, reply.data() + sizeof(short), sizeof(short));
+        found->second.riders.push_back(session);
+    }
+    found->second.link->queue(reply.data(), reply.size());
+    flushKid(found->second);
+}
+
+/**
+ * Reads Mom's replies on one link. <br>
+ * -------------------------------------------------------
+ * - Replies are taken whole, in the order they are owed.
+ * - QUIT (or anything arriving when nothing is owed, or Mom hanging up)
+ *   ends the relay's run.
+ * -------------------------------------------------------
+ */
+void Relay::serviceMom(size_t link) {
+    Upstream& mom = upstream[link];
+    bool open = mom.link->flush() && mom.link->fill();
+    short first;
+    while (!quitting && mom.link->peek(&first, sizeof(short))) {
+        if (first == static_cast<short>(messageCodes::QUIT) || mom.owed.empty()) {
+            quitting = true;
+            break;
+        }
+        size_t size = replyBytes(mom.owed.front(), *mom.link);
+        if (size == 0) break;
+        string reply(size, '\0');
+        mom.link->take(reply.data(), size);
+        Pending owed = mom.owed.front();
+        mom.owed.pop_front();
+        deliver(link, owed, reply);
+    }
+    if (!open || mom.link->isClosed()) quitting = true;
+}
+
+/**
+ * Answers a table request. <br>
+ * -------------------------------------------------------
+ * - From the cache if Mom confirmed it less than RELAY_TABLE_AGE ago and
+ *   no claim or completion has gone by since.
+ * - Otherwise the kid waits for a fetch; only one is ever on its way, and
+ *   it asks with the cached version so an unchanged table costs Mom one short.
+ * -------------------------------------------------------
+ */
+void Relay::requestTable(long key, bool since, uint32_t version) {
+    if (cacheVersion != 0 && !dirty && Clock::wall().now() - fetchedAt < RELAY_TABLE_AGE) {
+        sendTable(kids[key], since, version);
+        fromCache++;
+        return;
+    }
+    waiting.push_back(TableRequest{key, since, version});
+    if (fetching) return;
+    Message fetch;
+    fetch.code = static_cast<short>(messageCodes::NEED_JOB_SINCE);
+    fetch.arg = static_cast<int>(cacheVersion);
+    ask(kids[key].upstream, -1, fetch);
+    fetching = true;
+    fetches++;
+}
+
+/**
+ * Queues the cache for a kid the way Mom would: NOT_MODIFIED if the kid
+ * already has this version, otherwise ACK, the version if asked with
+ * NEED_JOB_SINCE, and the table in the kid's encoding.<br>
+ */
+void Relay::sendTable(Downstream& kid, bool since, uint32_t version) {
+    Connection& link = *kid.link;
+    short code = static_cast<short>(since && version == cacheVersion ? messageCodes::NOT_MODIFIED : messageCodes::ACK);
+    link.queue(&code, sizeof(short));
+    if (code == static_cast<short>(messageCodes::NOT_MODIFIED)) return;
+    if (since) link.queue(&cacheVersion, sizeof(cacheVersion));
+    if (kid.format == TableFormat::PACKED) {
+        if (!packedFresh) TableCodec::encodePacked(cache, packed);
+        packedFresh = true;
+        uint32_t length = packed.size();
+        link.queue(&length, sizeof(length));
+        link.queue(packed.data(), packed.size());
+    }
+    else {
+        if (!rowsFresh) TableCodec::encodeRows(cache, rows);
+        rowsFresh = true;
+        short slots = cache.size();
+        link.queue(&slots, sizeof(slots));
+        link.queue(rows.data(), rows.size() * sizeof(short));
+    }
+}
+
+/**
+ * Runs the relay. <br>
+ * -------------------------------------------------------
+ * - Opens `links` connections to Mom, then the welcome listener.
+ * - Each turn: waits on the engine, admits kids, services kids and Mom,
+ *   then flushes every upstream link once, so whatever the kids sent this
+ *   turn reaches Mom in one write per link.
+ * - When Mom says QUIT or goes away, tells every kid to QUIT, flushes for
+ *   up to 2 seconds, and reports, counting the heap allocations made
+ *   while relaying.
+ * -------------------------------------------------------
+ */
+void Relay::run() {
+    engine = IoEngine::create(io);
+    for (size_t i = 0; i < links; i++) {
+        Upstream mom(memory);
+        mom.link = make_unique<Connection>(engine->add(Transport::connect(transport, momPort)));
+        mom.owed.push_back(Pending{-1, static_cast<short>(messageCodes::ACK)});
+        upstream.push_back(std::move(mom));
+    }
+    welcomeSock = Listener::open(transport, port);
+    engine->listen(*welcomeSock);
+    ss << "Relay for the Mom on port " << momPort << " listening on port " << port
+       << " with " << links << " links to her" << endl;
+    Printer::write(ss, cout);
+
+    vector<Transport*> ready;
+    long allocations = Heap::allocations();
+    while (!quitting) {
+        engine->wait(1000, ready);
+        admitKids();
+        for (Transport* link : ready) {
+            auto found = kidOf.find(link);
+            if (found != kidOf.end()) {
+                serviceKid(found->second);
+                continue;
+            }
+            for (size_t k = 0; k < upstream.size(); k++)
+                if (&upstream[k].link->transport() == link) serviceMom(k);
+        }
+        for (Upstream& mom : upstream) {
+            if (!mom.link->flush()) quitting = true;
+            engine->watch(mom.link->transport(), true, mom.link->backlog() > 0);
+        }
+    }
+
+    allocations = Heap::allocations() - allocations;
+
+    short quit = static_cast<short>(messageCodes::QUIT);
+    for (auto& [key, kid] : kids) kid.link->queue(&quit, sizeof(short));
+    double start = Clock::wall().now();
+    for (;;) {
+        bool pending = false;
+        for (auto& [key, kid] : kids) {
+            if (!kid.link->flush() || kid.link->backlog() == 0) continue;
+            engine->watch(kid.link->transport(), false, true);
+            pending = true;
+        }
+        if (!pending || Clock::wall().now() - start >= 2) break;
+        engine->wait(100, ready);
+    }
+    engine->drain();
+
+    ss << "Relay: " << served << " kids over " << links << " links to Mom, " << forwarded << " messages forwarded, "
+       << fromCache << " tables from cache, " << fetches << " fetched (" << unchanged << " not modified), "
+       << Transport::syscalls << " system calls, " << allocations << " heap allocations while relaying" << endl;
+    Printer::write(ss, cout);
+}
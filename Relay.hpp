@@ -0,0 +1,190 @@
+#pragma once
+#include "tools.hpp"
+#include "JobTable.hpp"
+#include "TableCodec.hpp"
+#include "Transport.hpp"
+#include "Connection.hpp"
+#include "IoEngine.hpp"
+#include "Arena.hpp"
+#include <deque>
+
+#define RELAY_PORT 2099         ///< Where kids find a relay unless told otherwise<br>
+#define RELAY_LINKS 2           ///< Connections to Mom unless told otherwise<br>
+#define RELAY_MAX_LINKS 16      ///< Most connections a relay may open to Mom<br>
+#define RELAY_TABLE_AGE 0.05    ///< Seconds a cached table is handed out before Mom is asked again<br>
+
+/**
+ * @class Relay<br>
+ * Fan-in tier between many kids and Mom.<br>
+ * -------------------------------------------------------<br>
+ * - Kids connect to the relay exactly as they would to Mom and never know
+ *   the difference. Mom sees only the relay's few connections, however
+ *   many kids are behind it.<br>
+ * - Each kid is given to one of the upstream links. The relay asks Mom for
+ *   a session for it (ATTACH) and passes Mom's ACK and session ID on as
+ *   the kid's greeting, so kid IDs and names are Mom's own.<br>
+ * - Claims and completions (WANT_JOB, WANT_JOBS, JOB_DONE, DONE_AND_NEXT)
+ *   go upstream behind a VIA naming the kid's session. Everything queued
+ *   for a link during one turn of the loop goes out in one write, and
+ *   Mom's answers come back the same way.<br>
+ * - Mom answers each link's requests in order, so the relay keeps a queue
+ *   of what it is owed on each link and hands every reply to the kid at
+ *   the front. Mom's QUIT, which answers nothing, ends the run.<br>
+ * - Tables are served from a cache the relay fetches with NEED_JOB_SINCE
+ *   on its own session. A cached table is good for RELAY_TABLE_AGE seconds,
+ *   or until a claim or completion passes through; after that the next
+ *   request triggers a fetch, and every kid asking meanwhile waits for the
+ *   same answer. A kid that claims from a table Mom has moved past is
+ *   refused as stale, exactly as it would be talking to Mom.<br>
+ * - USE_FORMAT is answered by the relay; each kid gets the cache in its
+ *   own encoding, re-encoded only when the cache changes.<br>
+ * - Relays stack into a tree: a relay connects to another relay as if it
+ *   were Mom. Session IDs are always Mom's, so the relay in the middle
+ *   passes ATTACH, DETACH and VIA through untouched, on the link it gave
+ *   the relay below, and Mom sees every kid as behind that link.<br>
+ * -------------------------------------------------------<br>
+ */
+class Relay {
+private:
+    /**
+     * @struct Downstream<br>
+     * A kid connected to the relay.<br>
+     */
+    struct Downstream {
+        Pool<Connection>::Ptr link;
+        short session = -1;       ///< Mom's session ID for the kid, once ATTACH is answered<br>
+        size_t upstream = 0;      ///< Index of the link to Mom carrying its traffic<br>
+        TableFormat format = TableFormat::SHORTS;
+        short next = -1;          ///< For a relay below this one: the session named by its last VIA<br>
+        vector<short> riders;     ///< For a relay below this one: sessions attached through it<br>
+    };
+
+    /**
+     * @struct Pending<br>
+     * A reply Mom owes on an upstream link, and who it is for.<br>
+     */
+    struct Pending {
+        long kid;                 ///< Key in `kids`, or -1 for the relay itself<br>
+        short code;               ///< What was asked: ATTACH, WANT_JOB, WANT_JOBS, DONE_AND_NEXT, NEED_JOB_SINCE, or ACK for Mom's greeting<br>
+        bool passOn = false;      ///< An ATTACH from a relay below; its answer goes to it untouched<br>
+    };
+
+    /**
+     * @struct Upstream<br>
+     * One connection to Mom and the replies still owed on it.<br>
+     */
+    struct Upstream {
+        unique_ptr<Connection> link;
+        deque<Pending, ArenaAllocator<Pending>> owed; ///< Nodes from the relay's arena, reused as replies come and go<br>
+        explicit Upstream(Arena& memory) : owed(memory) {}
+    };
+
+    /**
+     * @struct TableRequest<br>
+     * A kid waiting for the cache to be refreshed.<br>
+     */
+    struct TableRequest {
+        long kid;
+        bool since;               ///< Asked with NEED_JOB_SINCE<br>
+        uint32_t version;         ///< Version the kid holds<br>
+    };
+
+    TransportKind transport;              ///< How kids reach the relay and the relay reaches Mom<br>
+    IoEngineKind io;                      ///< How the relay waits for traffic<br>
+    int port;                             ///< Where kids connect<br>
+    int momPort;                          ///< Where Mom listens<br>
+    size_t links;                         ///< Connections to open to Mom<br>
+    unique_ptr<IoEngine> engine;          ///< Watches both kids and Mom<br>
+    unique_ptr<Listener> welcomeSock;     ///< The relay's welcome point for kids<br>
+    Arena memory;                         ///< Where kid connections, map nodes and owed replies live<br>
+    Pool<Connection> kidLinks{memory};    ///< Connections of kids that left, buffers kept, for the next to join<br>
+    vector<Upstream> upstream;            ///< Connections to Mom<br>
+    ArenaMap<long, Downstream> kids;      ///< Connected kids, by join serial<br>
+    ArenaMap<Transport*, long> kidOf;     ///< Kid behind each watched transport<br>
+    long joins = 0;                       ///< Kids admitted so far; the next one's key<br>
+    bool quitting = false;                ///< Mom said QUIT or hung up<br>
+
+    JobTable cache;                       ///< Mom's table as last fetched<br>
+    uint32_t cacheVersion = 0;            ///< Mom's version of `cache`; 0 until the first fetch<br>
+    double fetchedAt = 0;                 ///< When Mom last confirmed `cache`<br>
+    bool dirty = true;                    ///< A claim or completion went by since then<br>
+    bool fetching = false;                ///< A NEED_JOB_SINCE is on its way<br>
+    vector<TableRequest> waiting;         ///< Kids waiting for that fetch<br>
+    vector<short> rows;                   ///< `cache` as rows, for SHORTS<br>
+    string packed;                        ///< `cache` in the PACKED encoding<br>
+    bool rowsFresh = false;               ///< `rows` matches the cache<br>
+    bool packedFresh = false;             ///< `packed` matches the cache<br>
+
+    long forwarded = 0;                   ///< Kid messages passed on to Mom<br>
+    long fromCache = 0;                   ///< Table requests answered without asking Mom<br>
+    long fetches = 0;                     ///< NEED_JOB_SINCE sent to Mom<br>
+    long unchanged = 0;                   ///< Fetches Mom answered NOT_MODIFIED<br>
+    long served = 0;                      ///< Kids that joined through the relay<br>
+
+    /**
+     * Accepts every waiting kid and asks Mom for a session for each.<br>
+     */
+    void admitKids();
+
+    /**
+     * Tells Mom a kid has gone and forgets it.<br>
+     */
+    void dropKid(long kid);
+
+    /**
+     * Reads a kid's messages and answers or forwards each one.<br>
+     */
+    void serviceKid(long kid);
+
+    /**
+     * Reads Mom's replies on one link and hands each to whoever it is owed to.<br>
+     */
+    void serviceMom(size_t link);
+
+    /**
+     * @return Bytes of the reply at the front of `mom`'s input owed for `owed`, or 0 if it has not all arrived<br>
+     */
+    static size_t replyBytes(const Pending& owed, const Connection& mom);
+
+    /**
+     * Acts on one whole reply from Mom on `upstream[link]`.<br>
+     */
+    void deliver(size_t link, const Pending& owed, const string& reply);
+
+    /**
+     * Flushes what is queued for a kid and updates what the engine watches for.<br>
+     */
+    void flushKid(Downstream& kid);
+
+    /**
+     * Answers a kid's table request from the cache, or waits for a fresh one.<br>
+     */
+    void requestTable(long kid, bool since, uint32_t version);
+
+    /**
+     * Queues the cached table, or NOT_MODIFIED, for a kid.<br>
+     */
+    void sendTable(Downstream& kid, bool since, uint32_t version);
+
+    /**
+     * Queues a message for Mom on `upstream[link]`, behind a VIA for session
+     * `via` unless it is -1, and records the reply owed to `kid`, if any.<br>
+     */
+    void ask(size_t link, long kid, const Message& message, short via = -1, bool passOn = false);
+
+public:
+    /**
+     * @param transport How kids connect and how the relay connects to Mom<br>
+     * @param io I/O engine for the relay's loop<br>
+     * @param port Where kids connect<br>
+     * @param momPort Where Mom listens<br>
+     * @param links Connections to open to Mom<br>
+     */
+    Relay(TransportKind transport, IoEngineKind io, int port, int momPort, size_t links)
+        : transport(transport), io(io), port(port), momPort(momPort), links(links), kids(memory), kidOf(memory) {}
+
+    /**
+     * Connects to Mom, opens the welcome listener, and relays until Mom says QUIT.<br>
+     */
+    void run();
+};
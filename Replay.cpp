@@ -0,0 +1,289 @@
+#include "Replay.hpp"
+#include "TableCodec.hpp"
+#include "Clock.hpp"
+
+static const char* tripNames[] = {"connect", "table", "claim", "setup"};
+
+/**
+ * Nearest-rank percentile of a sorted sample.<br>
+ */
+static double percentile(const vector<double>& sorted, double p) {
+    if (sorted.empty()) return 0;
+    size_t rank = size_t(ceil(p / 100 * sorted.size()));
+    return sorted[rank > 0 ? rank - 1 : 0];
+}
+
+/**
+ * Groups the capture's records into scripts. <br>
+ * -------------------------------------------------------
+ * - A JOIN opens a script for its session, a LEAVE closes it; Mom reuses
+ *   session IDs, so one ID can start several scripts over a capture.
+ * - A message for a session with no open script (the capture began
+ *   mid-session) has nothing to replay it on and is dropped.
+ * -------------------------------------------------------
+ */
+Replay::Replay(const string& path, TransportKind transport, int port, bool fast)
+    : transport(transport), port(port), fast(fast) {
+    vector<Capture::Record> records = Capture::load(path, seed, slots);
+    unordered_map<short, size_t> open;
+    for (Capture::Record& record : records) {
+        auto found = open.find(record.session);
+        if (record.kind == Capture::Kind::JOIN) {
+            open[record.session] = scripts.size();
+            scripts.emplace_back();
+            scripts.back().joined = record.at;
+        }
+        else if (found == open.end()) continue;
+        else if (record.kind == Capture::Kind::MESSAGE) scripts[found->second].steps.push_back(Step{record.at, record.message});
+        else {
+            scripts[found->second].left = record.at;
+            open.erase(found);
+        }
+    }
+    vector<double> leaves;
+    for (const Script& script : scripts)
+        if (script.left >= 0) leaves.push_back(script.left);
+    sort(leaves.begin(), leaves.end());
+    for (Script& script : scripts)
+        script.leftBefore = upper_bound(leaves.begin(), leaves.end(), script.joined) - leaves.begin();
+}
+
+/**
+ * Finds the job this run got for the claim a captured done report answers. <br>
+ * -------------------------------------------------------
+ * - Mom may grant a replay a different candidate than she granted the kid,
+ *   so the captured index can name a job this run never held. The report
+ *   belongs to the latest claim still held that offered that index.
+ * - That claim is no longer held afterwards.
+ * -------------------------------------------------------
+ * @return The slot granted for that claim, or -1 if there is none.
+ */
+short Replay::release(const Script& script, vector<pair<size_t, short>>& held, short done) {
+    for (size_t k = held.size(); k-- > 0;) {
+        const Message& claim = script.steps[held[k].first].message;
+        bool offered = claim.code == static_cast<short>(messageCodes::WANT_JOB) && claim.arg == done;
+        for (short c = 0; c < claim.count && !offered; c++) offered = claim.slots[c] == done;
+        if (!offered) continue;
+        short slot = held[k].second;
+        held.erase(held.begin() + k);
+        return slot;
+    }
+    return -1;
+}
+
+void Replay::run() {
+    Clock& clock = Clock::wall();
+    start = clock.now();
+    vector<thread> players;
+    players.reserve(scripts.size());
+    for (Script& script : scripts) players.emplace_back([this, &script] { play(script); });
+    for (thread& player : players) player.join();
+    elapsed = clock.now() - start;
+}
+
+/**
+ * Plays one script the way its kid would have. <br>
+ * -------------------------------------------------------
+ * - Waits for its turn: its captured join time, or flat out, until enough
+ *   sessions have finished.
+ * - Connects and reads the greeting; QUIT there means Mom is full.
+ * - For each message: waits for its time if paced, brings its table
+ *   version or generations up to date, sends it, and reads the whole
+ *   answer, decoding tables so later claims can name their generations.
+ *   A done report names the job this run was granted for that claim;
+ *   with none, JOB_DONE is dropped and DONE_AND_NEXT goes as WANT_JOBS.
+ *   USE_FORMAT's ACK switches the table encoding it expects.
+ * - Ends early on QUIT or a lost link. Paced, it then holds the link
+ *   until its captured leave time, as the kid did.
+ * - Its timings go into the shared tallies once, at the end.
+ * -------------------------------------------------------
+ */
+void Replay::play(Script& script) {
+    Clock& clock = Clock::wall();
+    auto waitUntil = [&](double at) {
+        double left = start + at - clock.now();
+        if (!fast && left > 0) clock.sleepFor(left);
+    };
+    if (fast) {
+        unique_lock<mutex> hold(lock);
+        progress.wait(hold, [&] { return finished >= script.leftBefore; });
+    }
+    waitUntil(script.joined);
+    vector<double> times[TRIPS];
+    long messages = 0;
+    bool quit = false;
+    size_t step = 0;
+    double began = clock.now();
+    unique_ptr<Transport> link = Transport::connect(transport, port, false);
+    short reply = static_cast<short>(messageCodes::QUIT), id;
+    bool refused = !link || !link->recvAll(&reply, sizeof(short)) || reply == static_cast<short>(messageCodes::QUIT)
+        || !link->recvAll(&id, sizeof(short));
+    if (!refused) {
+        times[CONNECT].push_back(clock.now() - began);
+        TableFormat format = TableFormat::SHORTS;
+        JobTable table(0);
+        uint32_t version = 0;
+        string payload, bytes;
+        vector<short> rows;
+        vector<pair<size_t, short>> held;
+        Connection encoder;
+        for (; step < script.steps.size() && !quit; step++) {
+            Message& message = script.steps[step].message;
+            if (message.code == static_cast<short>(messageCodes::JOB_DONE)
+                || message.code == static_cast<short>(messageCodes::DONE_AND_NEXT)) {
+                short slot = release(script, held, message.arg);
+                if (slot >= 0) message.arg = slot;
+                else if (message.code == static_cast<short>(messageCodes::JOB_DONE)) continue;
+                else message.code = static_cast<short>(messageCodes::WANT_JOBS);
+            }
+            short code = message.code;
+            bool since = code == static_cast<short>(messageCodes::NEED_JOB_SINCE);
+            bool claim = code == static_cast<short>(messageCodes::WANT_JOBS) || code == static_cast<short>(messageCodes::DONE_AND_NEXT);
+            Trip trip = since || code == static_cast<short>(messageCodes::NEED_JOB) ? TABLE
+                : claim || code == static_cast<short>(messageCodes::WANT_JOB) ? CLAIM
+                : code == static_cast<short>(messageCodes::USE_FORMAT) || code == static_cast<short>(messageCodes::SUBSCRIBE) ? SETUP
+                : TRIPS;
+            if (since) message.arg = version;
+            for (short k = 0; k < message.count; k++)
+                if (message.slots[k] >= 0 && message.slots[k] < table.size()) message.generations[k] = table.jobs[message.slots[k]].generation;
+            if (code == static_cast<short>(messageCodes::WANT_JOB) && message.arg >= 0 && message.arg < table.size())
+                message.generations[0] = table.jobs[message.arg].generation;
+            encoder.queueMessage(message);
+            encoder.takeOutput(bytes);
+            waitUntil(script.steps[step].at);
+            began = clock.now();
+            if (link->send(bytes.data(), bytes.size()) < 0) {
+                quit = true;
+                break;
+            }
+            messages++;
+            if (trip == TRIPS) continue;
+            if (!link->recvAll(&reply, sizeof(short)) || reply == static_cast<short>(messageCodes::QUIT)) {
+                quit = true;
+                break;
+            }
+            bool whole = true;
+            if (trip == TABLE && reply != static_cast<short>(messageCodes::NOT_MODIFIED)) {
+                if (since) whole = link->recvAll(&version, sizeof(version));
+                if (format == TableFormat::PACKED) {
+                    uint32_t length = 0;
+                    whole = whole && link->recvAll(&length, sizeof(length));
+                    payload.resize(length);
+                    whole = whole && link->recvAll(payload.data(), length) && TableCodec::decodePacked(payload, table);
+                }
+                else {
+                    short count = 0;
+                    whole = whole && link->recvAll(&count, sizeof(count)) && count >= 0 && count <= MAX_JOB_SLOTS;
+                    rows.resize(max<short>(count, 0) * ROW_SHORTS);
+                    whole = whole && link->recvAll(rows.data(), rows.size() * sizeof(short))
+                        && TableCodec::decodeRows(rows.data(), count, table);
+                }
+            }
+            if (claim) {
+                uint16_t masks[2];
+                whole = link->recvAll(masks, sizeof(masks));
+                for (short k = 0; whole && k < message.count; k++)
+                    if (masks[0] & (1 << k)) {
+                        held.emplace_back(step, message.slots[k]);
+                        break;
+                    }
+            }
+            if (code == static_cast<short>(messageCodes::WANT_JOB) && reply == static_cast<short>(messageCodes::ACK))
+                held.emplace_back(step, message.arg);
+            if (code == static_cast<short>(messageCodes::USE_FORMAT) && reply == static_cast<short>(messageCodes::ACK))
+                format = static_cast<TableFormat>(message.arg);
+            if (!whole) {
+                quit = true;
+                break;
+            }
+            times[trip].push_back(clock.now() - began);
+        }
+        if (!quit && script.left >= 0) waitUntil(script.left);
+    }
+    link.reset();
+    lock_guard<mutex> hold(lock);
+    for (int trip = 0; trip < TRIPS; trip++) latencies[trip].insert(latencies[trip].end(), times[trip].begin(), times[trip].end());
+    sent += messages;
+    turnedAway += refused;
+    cutShort += quit && step + 1 < script.steps.size();
+    finished++;
+    progress.notify_all();
+}
+
+vector<pair<string, double>> Replay::metrics() {
+    long replies = 0;
+    for (int trip = CONNECT + 1; trip < TRIPS; trip++) replies += latencies[trip].size();
+    vector<pair<string, double>> all = {
+        {"sessions", scripts.size()}, {"messages", sent}, {"replies", replies},
+        {"turned_away", turnedAway}, {"cut_short", cutShort}, {"seconds", elapsed},
+        {"replies_per_s", elapsed > 0 ? replies / elapsed : 0},
+    };
+    for (int trip = 0; trip < TRIPS; trip++) {
+        vector<double>& sample = latencies[trip];
+        sort(sample.begin(), sample.end());
+        double sum = 0;
+        for (double seconds : sample) sum += seconds;
+        string name = tripNames[trip];
+        all.emplace_back(name + "_count", sample.size());
+        all.emplace_back(name + "_mean_ms", sample.empty() ? 0 : sum / sample.size() * 1e3);
+        all.emplace_back(name + "_p50_ms", percentile(sample, 50) * 1e3);
+        all.emplace_back(name + "_p99_ms", percentile(sample, 99) * 1e3);
+    }
+    return all;
+}
+
+void Replay::report(ostream& out) {
+    map<string, double> results;
+    for (auto& [metric, value] : metrics()) results[metric] = value;
+    out << "Replayed " << scripts.size() << " sessions, " << sent << " messages, "
+        << (fast ? "as fast as possible" : "at the captured pace") << ", in " << fixed << setprecision(2)
+        << elapsed << " s (captured from mom -r " << seed << ", " << slots << " slots)" << endl;
+    out << "Throughput: " << long(results["replies"]) << " replies, " << results["replies_per_s"] << " per second; "
+        << turnedAway << " sessions turned away, " << cutShort << " cut short by QUIT" << endl;
+    out << "Latency (ms)     count      mean       p50       p99" << endl << setprecision(3);
+    for (int trip = 0; trip < TRIPS; trip++) {
+        string name = tripNames[trip];
+        out << "  " << left << setw(10) << name << right << setw(11) << long(results[name + "_count"])
+            << setw(10) << results[name + "_mean_ms"] << setw(10) << results[name + "_p50_ms"]
+            << setw(10) << results[name + "_p99_ms"] << endl;
+    }
+}
+
+void Replay::writeCsv(ostream& out) {
+    out << "metric,value\n" << setprecision(9);
+    for (auto& [metric, value] : metrics()) out << metric << ',' << value << '\n';
+}
+
+/**
+ * Compares with an earlier replay's CSV. <br>
+ * -------------------------------------------------------
+ * - Metrics are matched by name; any the baseline lacks show "-".
+ * - The change is relative to the baseline: for replies_per_s higher is
+ *   better, for the latencies lower is.
+ * -------------------------------------------------------
+ */
+void Replay::compare(const string& baselinePath, ostream& out) {
+    ifstream file(baselinePath);
+    if (!file) fatal("Can't read baseline " + baselinePath);
+    map<string, double> baseline;
+    string line;
+    while (getline(file, line)) {
+        size_t comma = line.find(',');
+        if (comma == string::npos || line.compare(0, comma, "metric") == 0) continue;
+        baseline[line.substr(0, comma)] = atof(line.c_str() + comma + 1);
+    }
+    out << "Against " << baselinePath << ":" << endl;
+    out << left << setw(18) << "metric" << right << setw(14) << "baseline" << setw(14) << "this run" << setw(10) << "change" << endl;
+    for (auto& [metric, value] : metrics()) {
+        auto found = baseline.find(metric);
+        out << left << setw(18) << metric << right << fixed << setprecision(3);
+        if (found == baseline.end()) {
+            out << setw(14) << "-" << setw(14) << value << endl;
+            continue;
+        }
+        out << setw(14) << found->second << setw(14) << value << setw(9) << setprecision(1);
+        if (found->second != 0) out << showpos << (value - found->second) / found->second * 100 << noshowpos << "%";
+        else out << "-" << " ";
+        out << endl;
+    }
+}
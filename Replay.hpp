@@ -0,0 +1,137 @@
+#pragma once
+#include "tools.hpp"
+#include "Enums.hpp"
+#include "Capture.hpp"
+#include "Transport.hpp"
+#include "JobTable.hpp"
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <thread>
+
+/**
+ * @class Replay<br>
+ * Plays a capture's kid sessions against a running Mom and measures her answers.<br>
+ * -------------------------------------------------------<br>
+ * - Each captured session becomes a script: its messages in order. Each
+ *   script runs on its own thread over its own link, and like a kid, it
+ *   waits for each answer before it sends the next message.<br>
+ * - Paced (the default), a session joins and each message goes out at
+ *   its captured time after the start, or as soon as the previous answer
+ *   arrives if that is later. Flat out, nothing waits on the clock. A
+ *   session still starts only once as many sessions have finished as
+ *   had left before it joined, so no more kids are connected at once
+ *   than during the capture.<br>
+ * - Messages are sent as captured except where the kid would have used
+ *   what Mom told it during this run: NEED_JOB_SINCE names the table
+ *   version the script last got, and claims name the generations in its
+ *   latest table. So a replay asks for the same jobs without being
+ *   refused for a stale generation. JOB_DONE and DONE_AND_NEXT report
+ *   the job this run was granted for the claim, not the captured one.<br>
+ * - Round trips are timed from just before the send to the last byte of
+ *   the answer, by kind: connect (up to the greeting), table fetch, claim,
+ *   and setup (USE_FORMAT, SUBSCRIBE). JOB_DONE has no answer, so it is only counted.<br>
+ * - Results are written as `metric,value` lines. Given the file from
+ *   another build's run, compare() prints both sides and the change.<br>
+ * -------------------------------------------------------<br>
+ */
+class Replay {
+private:
+    /**
+     * @enum Trip<br>
+     * Kinds of round trip timed separately.<br>
+     */
+    enum Trip { CONNECT, TABLE, CLAIM, SETUP, TRIPS };
+
+    /**
+     * @struct Step<br>
+     * One message to send.<br>
+     */
+    struct Step {
+        double at;                    ///< Captured time, seconds from the first record<br>
+        Message message;
+    };
+
+    /**
+     * @struct Script<br>
+     * One captured kid session.<br>
+     */
+    struct Script {
+        double joined = 0;            ///< Captured join time<br>
+        double left = -1;             ///< Captured leave time, or -1 if the capture ended first<br>
+        size_t leftBefore = 0;        ///< Sessions whose leave was captured before this one joined<br>
+        vector<Step> steps;
+    };
+
+    TransportKind transport;          ///< Link to Mom<br>
+    int port;                         ///< Mom's port<br>
+    bool fast = false;                ///< Ignore captured times<br>
+    unsigned seed = 0;                ///< Seed of the Mom that was captured<br>
+    int slots = 0;                    ///< Table slots of the Mom that was captured<br>
+    vector<Script> scripts;           ///< Every captured session, in order of joining<br>
+    double start = 0;                 ///< Wall-clock time the replay began<br>
+    double elapsed = 0;               ///< Seconds until the last script ended<br>
+
+    mutex lock;                       ///< Guards what follows<br>
+    condition_variable progress;      ///< Signalled as each script ends<br>
+    size_t finished = 0;              ///< Scripts that have ended<br>
+    vector<double> latencies[TRIPS];  ///< Round-trip times in seconds, by kind<br>
+    long sent = 0;                    ///< Messages sent<br>
+    long turnedAway = 0;              ///< Scripts Mom refused, or that could not connect<br>
+    long cutShort = 0;                ///< Scripts that got QUIT before their last message<br>
+
+    /**
+     * Runs one script (thread body).<br>
+     */
+    void play(Script& script);
+
+    /**
+     * Maps a captured done report to the job granted in this run (see Replay.cpp).<br>
+     * @param held (claim step, slot granted) for each claim the script still holds<br>
+     * @param done Job index the captured kid reported<br>
+     * @return The slot to report, or -1 to report nothing<br>
+     */
+    static short release(const Script& script, vector<pair<size_t, short>>& held, short done);
+
+    /**
+     * @return Every result as (metric, value), in report order<br>
+     */
+    vector<pair<string, double>> metrics();
+
+public:
+    /**
+     * Loads a capture and groups its records into scripts.<br>
+     * @param path Capture file (see Capture)<br>
+     * @param transport Link to Mom; must be the one she listens with<br>
+     * @param port Mom's port<br>
+     * @param fast Send every message as soon as the last one is answered<br>
+     * @throws Terminates the program if the capture can't be read.<br>
+     */
+    Replay(const string& path, TransportKind transport, int port, bool fast);
+
+    /**
+     * @return Number of captured sessions<br>
+     */
+    size_t sessions() const { return scripts.size(); }
+
+    /**
+     * Plays every script and waits for all of them.<br>
+     */
+    void run();
+
+    /**
+     * Prints throughput and each kind's latency (mean, p50, p99).<br>
+     */
+    void report(ostream& out);
+
+    /**
+     * Writes every metric as a `metric,value` line.<br>
+     */
+    void writeCsv(ostream& out);
+
+    /**
+     * Prints each metric of the replay written to `baselinePath` next to this one's, with the change.<br>
+     * @throws Terminates the program if the file can't be read.<br>
+     */
+    void compare(const string& baselinePath, ostream& out);
+};
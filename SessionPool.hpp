@@ -0,0 +1,35 @@
+#pragma once
+#include "tools.hpp"
+#include <queue>
+
+/**
+ * @class SessionPool<br>
+ * Hands out kid session IDs and takes them back when a kid leaves.<br>
+ * -------------------------------------------------------<br>
+ * - A released ID is reused before a new one is minted, lowest first,
+ *   so IDs stay small however often kids come and go.<br>
+ * - An ID belongs to one kid for that kid's whole session; nothing is
+ *   renumbered when somebody else leaves.<br>
+ * -------------------------------------------------------<br>
+ */
+class SessionPool {
+private:
+    priority_queue<short, vector<short>, greater<short>> released; ///< IDs free for reuse<br>
+    short next = 0;                                                ///< First never-issued ID<br>
+
+public:
+    /**
+     * @return The lowest free session ID<br>
+     */
+    short acquire() {
+        if (released.empty()) return next++;
+        short id = released.top();
+        released.pop();
+        return id;
+    }
+
+    /**
+     * Returns a session ID to the pool.<br>
+     */
+    void release(short id) { released.push(id); }
+};
@@ -0,0 +1,90 @@
+#include "SharedTable.hpp"
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include <fcntl.h>
+
+/**
+ * Builds the shm_open name of the snapshot for `port`.<br>
+ */
+static string snapshotName(int port) {
+    return "/socketsync." + to_string(port) + ".table";
+}
+
+/**
+ * Creates and sizes the region, starting with an empty, even sequence.<br>
+ */
+unique_ptr<SharedTable> SharedTable::create(int port, short slots) {
+    string name = snapshotName(port);
+    size_t bytes = sizeof(SnapshotRegion) + slots * ROW_SHORTS * sizeof(short);
+    int fd = shm_open(name.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0600);
+    if (fd < 0) return nullptr;
+    if (ftruncate(fd, bytes) < 0) { close(fd); shm_unlink(name.c_str()); return nullptr; }
+    void* map = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) { shm_unlink(name.c_str()); return nullptr; }
+    SnapshotRegion* region = static_cast<SnapshotRegion*>(map);
+    region->slots = slots;
+    return unique_ptr<SharedTable>(new SharedTable(region, bytes, name, true));
+}
+
+/**
+ * Maps an existing region read-write (the futex counters live in it).<br>
+ */
+unique_ptr<SharedTable> SharedTable::attach(int port) {
+    string name = snapshotName(port);
+    int fd = shm_open(name.c_str(), O_RDWR, 0);
+    if (fd < 0) return nullptr;
+    struct stat info;
+    if (fstat(fd, &info) < 0) { close(fd); return nullptr; }
+    void* map = mmap(nullptr, info.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return nullptr;
+    return unique_ptr<SharedTable>(new SharedTable(static_cast<SnapshotRegion*>(map), info.st_size, name, false));
+}
+
+SharedTable::~SharedTable() {
+    munmap(region, bytes);
+    if (owner) shm_unlink(name.c_str());
+}
+
+/**
+ * Seqlock write side. <br>
+ * -------------------------------------------------------
+ * - Bumps `seq` to odd, copies the rows, bumps `seq` back to even.
+ * - Only issues FUTEX_WAKE when a kid is actually sleeping.
+ * -------------------------------------------------------
+ */
+void SharedTable::publish(const short* rows, bool quit) {
+    uint32_t s = region->seq.load(memory_order_relaxed);
+    region->seq.store(s + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    memcpy(region->rows, rows, region->slots * ROW_SHORTS * sizeof(short));
+    region->quit = quit;
+    region->seq.store(s + 2, memory_order_seq_cst);
+    if (region->waiters.load(memory_order_seq_cst) > 0)
+        syscall(SYS_futex, &region->seq, FUTEX_WAKE, INT32_MAX, nullptr, nullptr, 0);
+}
+
+/**
+ * Seqlock read side: retries while Mom is mid-write or the sequence moved.<br>
+ */
+uint32_t SharedTable::read(short* rows, bool& quit) const {
+    for (;;) {
+        uint32_t before = region->seq.load(memory_order_acquire);
+        if (before & 1) continue;
+        memcpy(rows, region->rows, region->slots * ROW_SHORTS * sizeof(short));
+        quit = region->quit;
+        atomic_thread_fence(memory_order_acquire);
+        if (region->seq.load(memory_order_relaxed) == before) return before;
+    }
+}
+
+void SharedTable::waitForChange(uint32_t seen) const {
+    region->waiters.fetch_add(1, memory_order_seq_cst);
+    if (region->seq.load(memory_order_seq_cst) == seen) {
+        timespec limit{1, 0};
+        syscall(SYS_futex, &region->seq, FUTEX_WAIT, seen, &limit, nullptr, 0);
+    }
+    region->waiters.fetch_sub(1, memory_order_seq_cst);
+}
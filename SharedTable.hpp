@@ -0,0 +1,80 @@
+#pragma once
+#include "tools.hpp"
+#include "JobTable.hpp"
+#include <atomic>
+#include <memory>
+
+/**
+ * @struct SnapshotRegion<br>
+ * Layout of the shared job-table snapshot.<br>
+ * -------------------------------------------------------<br>
+ * - `seq` is a seqlock: odd while Mom is rewriting the rows.<br>
+ * - Rows use the same ROW_SHORTS encoding as the NEED_JOB reply.<br>
+ * -------------------------------------------------------<br>
+ */
+struct SnapshotRegion {
+    alignas(64) atomic<uint32_t> seq;      ///< Seqlock counter, also the futex word<br>
+    atomic<uint32_t> waiters;              ///< Kids sleeping in waitForChange()<br>
+    short slots;                           ///< Number of rows that follow<br>
+    bool quit;                             ///< Mom has ended the run<br>
+    alignas(64) short rows[];              ///< slots × ROW_SHORTS shorts<br>
+};
+
+/**
+ * @class SharedTable<br>
+ * Seqlock-guarded copy of Mom's JobTable for kids on the same host.<br>
+ * -------------------------------------------------------<br>
+ * - Mom publishes after every change to the table.<br>
+ * - Kids read a consistent copy without a system call and only fall back
+ *   to a futex wait when nothing has changed since their last look.<br>
+ * -------------------------------------------------------<br>
+ */
+class SharedTable {
+private:
+    SnapshotRegion* region;   ///< Mapped snapshot<br>
+    size_t bytes;             ///< Size of the mapping<br>
+    string name;              ///< shm_open name<br>
+    bool owner;               ///< Mom owns and unlinks the region<br>
+
+    SharedTable(SnapshotRegion* region, size_t bytes, string name, bool owner)
+        : region(region), bytes(bytes), name(std::move(name)), owner(owner) {}
+
+public:
+    ~SharedTable();
+
+    /**
+     * Creates the snapshot region for the Mom serving `port`.<br>
+     * @return nullptr if shared memory is unavailable<br>
+     */
+    static unique_ptr<SharedTable> create(int port, short slots);
+
+    /**
+     * Maps the snapshot region published by the Mom serving `port`.<br>
+     * @return nullptr if Mom has not published one<br>
+     */
+    static unique_ptr<SharedTable> attach(int port);
+
+    /**
+     * Rewrites the rows under the seqlock and wakes sleeping kids.<br>
+     * @param rows Encoded table, slots × ROW_SHORTS shorts<br>
+     * @param quit True once the run is over<br>
+     */
+    void publish(const short* rows, bool quit);
+
+    /**
+     * Copies a consistent snapshot into `rows`.<br>
+     * @param quit Set to Mom's quit flag<br>
+     * @return Sequence number of the copy<br>
+     */
+    uint32_t read(short* rows, bool& quit) const;
+
+    /**
+     * Sleeps until the snapshot differs from sequence `seen` (at most one second).<br>
+     */
+    void waitForChange(uint32_t seen) const;
+
+    /**
+     * @return Number of rows in the snapshot<br>
+     */
+    short slots() const { return region->slots; }
+};
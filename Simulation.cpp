@@ -0,0 +1,215 @@
+#include "Simulation.hpp"
+#include "Kid.hpp"
+#include <limits>
+
+/**
+ * Simulation whose fiber is starting on this thread (read by trampoline()).<br>
+ */
+static thread_local Simulation* starting = nullptr;
+
+// -------------------------------------------------------------------
+// VirtualClock
+// -------------------------------------------------------------------
+/**
+ * A kid's work: resume the fiber `seconds` from now.<br>
+ */
+void VirtualClock::sleepFor(double seconds) {
+    if (sim.current == nullptr) { sim.advanceTo(t + seconds); return; }
+    sim.timers.push(Simulation::Timer{t + seconds, sim.timerSeq++, sim.current});
+    sim.park();
+}
+
+// -------------------------------------------------------------------
+// SimTransport
+// -------------------------------------------------------------------
+/**
+ * Closes our direction and wakes a kid parked on it.<br>
+ */
+SimTransport::~SimTransport() {
+    out->closed = true;
+    if (out->reader != nullptr) sim.wake(out->reader);
+    out->reader = nullptr;
+}
+
+long SimTransport::send(const void* data, size_t len) {
+    if (sim.current != nullptr) sim.clock.sleepFor(sim.latency);
+    if (in->closed) return -1;
+    out->bytes.append(static_cast<const char*>(data), len);
+    if (out->reader != nullptr) {
+        sim.wake(out->reader);
+        out->reader = nullptr;
+    }
+    return len;
+}
+
+/**
+ * Blocking read for kid fibers: parks until Mom writes or hangs up.<br>
+ */
+long SimTransport::recv(void* data, size_t len) {
+    while (in->head == in->bytes.size() && !in->closed) {
+        if (sim.current == nullptr) return -1;
+        in->reader = sim.current;
+        sim.park();
+    }
+    return tryRecv(data, len);
+}
+
+long SimTransport::tryRecv(void* data, size_t len) {
+    size_t n = min(len, in->bytes.size() - in->head);
+    if (n == 0) return in->closed ? 0 : TRANSPORT_AGAIN;
+    memcpy(data, in->bytes.data() + in->head, n);
+    in->head += n;
+    if (in->head == in->bytes.size()) { in->bytes.clear(); in->head = 0; }
+    return n;
+}
+
+// -------------------------------------------------------------------
+// SimListener
+// -------------------------------------------------------------------
+unique_ptr<Transport> SimListener::accept() {
+    if (waiting.empty()) return nullptr;
+    unique_ptr<Transport> link = std::move(waiting.front());
+    waiting.pop_front();
+    return link;
+}
+
+// -------------------------------------------------------------------
+// SimEngine
+// -------------------------------------------------------------------
+unique_ptr<Transport> SimEngine::add(unique_ptr<Transport> link) {
+    links.push_back(link.get());
+    return link;
+}
+
+void SimEngine::remove(Transport& link) {
+    links.erase(std::remove(links.begin(), links.end(), &link), links.end());
+}
+
+/**
+ * Lets the kids run and simulated time pass until Mom has something to do. <br>
+ * -------------------------------------------------------
+ * - Equal-time events keep their order, so a run depends only on the seed.
+ * -------------------------------------------------------
+ */
+void SimEngine::wait(int timeoutMs, vector<Transport*>& ready) {
+    double deadline = sim.clock.now() + timeoutMs / 1000.0;
+    for (;;) {
+        sim.runFibers();
+        ready.clear();
+        for (Transport* link : links)
+            if (link->buffered()) ready.push_back(link);
+        if (!ready.empty() || welcome.pending()) return;
+        double next = sim.nextTimer();
+        if (next > deadline) { sim.advanceTo(deadline); return; }
+        sim.advanceTo(next);
+    }
+}
+
+// -------------------------------------------------------------------
+// Simulation
+// -------------------------------------------------------------------
+Simulation::Simulation() {
+    unique_ptr<SimListener> listener = make_unique<SimListener>();
+    welcome = listener.get();
+    unique_ptr<IoEngine> engine = make_unique<SimEngine>(*this, *listener);
+    mom.attach(clock, std::move(listener), std::move(engine));
+}
+
+/**
+ * Entry point of every fiber; returning resumes the scheduler through uc_link.<br>
+ */
+void Simulation::trampoline() {
+    Fiber* fiber = starting->current;
+    try { fiber->body(); }
+    catch (...) {}
+    fiber->done = true;
+}
+
+void Simulation::park() {
+    Fiber* fiber = current;
+    swapcontext(&fiber->context, &schedulerContext);
+}
+
+void Simulation::wake(Fiber* fiber) {
+    runnable.push_back(fiber);
+}
+
+/**
+ * Resumes fibers in the order they were woken. <br>
+ * -------------------------------------------------------
+ * - Fibers woken meanwhile are appended and run in the same pass. The
+ *   list is cleared, not freed, at the end, so after the first few turns
+ *   waking a fiber never allocates (a deque would, at every node boundary).
+ * -------------------------------------------------------
+ */
+void Simulation::runFibers() {
+    for (size_t next = 0; next < runnable.size(); next++) {
+        Fiber* fiber = runnable[next];
+        if (fiber->done) continue;
+        current = fiber;
+        starting = this;
+        swapcontext(&schedulerContext, &fiber->context);
+        current = nullptr;
+        if (fiber->done) vector<char>().swap(fiber->stack);
+    }
+    runnable.clear();
+}
+
+double Simulation::nextTimer() const {
+    return timers.empty() ? numeric_limits<double>::infinity() : timers.top().when;
+}
+
+void Simulation::advanceTo(double when) {
+    clock.t = max(clock.t, when);
+    while (!timers.empty() && timers.top().when <= clock.t) {
+        wake(timers.top().fiber);
+        timers.pop();
+    }
+}
+
+/**
+ * Creates the kid's fiber and sets a timer for its arrival. <br>
+ * -------------------------------------------------------
+ * - On arrival the kid leaves its Mom-side end at the listener, then
+ *   runs the unmodified Kid::run() over the other end.
+ * -------------------------------------------------------
+ */
+void Simulation::addKid(double joinAt, optional<Mood> mood) {
+    fibers.push_back(make_unique<Fiber>());
+    Fiber* fiber = fibers.back().get();
+    fiber->stack.resize(FIBER_STACK_BYTES);
+    fiber->body = [this, mood, format = format, prefetch = prefetch] {
+        shared_ptr<SimPipe> toKid = make_shared<SimPipe>();
+        shared_ptr<SimPipe> toMom = make_shared<SimPipe>();
+        welcome->knock(make_unique<SimTransport>(*this, toMom, toKid));
+        Kid kid(make_unique<SimTransport>(*this, toKid, toMom), clock);
+        if (mood) kid.setMood(*mood);
+        if (tracer) kid.traceTo(*tracer);
+        kid.askFormat(format);
+        kid.setPrefetch(prefetch);
+        kid.run();
+    };
+    getcontext(&fiber->context);
+    fiber->context.uc_stack.ss_sp = fiber->stack.data();
+    fiber->context.uc_stack.ss_size = fiber->stack.size();
+    fiber->context.uc_link = &schedulerContext;
+    makecontext(&fiber->context, &Simulation::trampoline, 0);
+    timers.push(Timer{joinAt, timerSeq++, fiber});
+}
+
+/**
+ * Runs Mom's own run() loop on simulated time. <br>
+ * -------------------------------------------------------
+ * - When Mom is done, keeps resuming kids (and advancing time for those
+ *   still mid-job) until every one has read its QUIT and returned.
+ * -------------------------------------------------------
+ */
+void Simulation::run(double seconds) {
+    mom.runFor(seconds);
+    mom.run();
+    for (;;) {
+        runFibers();
+        if (timers.empty()) break;
+        advanceTo(nextTimer());
+    }
+}
@@ -0,0 +1,269 @@
+#pragma once
+#include "tools.hpp"
+#include "Clock.hpp"
+#include "Transport.hpp"
+#include "IoEngine.hpp"
+#include "Mom.hpp"
+#include <ucontext.h>
+#include <deque>
+#include <queue>
+#include <functional>
+#include <optional>
+
+#define FIBER_STACK_BYTES (256 * 1024)
+#define SIM_LATENCY 0.001    ///< Default simulated seconds for a kid's message to reach Mom<br>
+
+class Simulation;
+
+/**
+ * @struct Fiber<br>
+ * A kid running on its own stack inside the simulation's thread.<br>
+ * -------------------------------------------------------<br>
+ * - Kid code blocks exactly as it does over a socket; blocking parks the
+ *   fiber and hands control back to the scheduler.<br>
+ * -------------------------------------------------------<br>
+ */
+struct Fiber {
+    ucontext_t context;               ///< Saved registers and stack of the fiber<br>
+    vector<char> stack;               ///< The fiber's stack<br>
+    function<void()> body;            ///< What the fiber runs<br>
+    bool done = false;                ///< `body` has returned<br>
+};
+
+/**
+ * @struct SimPipe<br>
+ * One direction of an in-memory link.<br>
+ */
+struct SimPipe {
+    string bytes;                     ///< Bytes written and not yet read<br>
+    size_t head = 0;                  ///< Read position in `bytes`<br>
+    bool closed = false;              ///< The writer has gone<br>
+    Fiber* reader = nullptr;          ///< Kid fiber parked waiting for bytes<br>
+};
+
+/**
+ * @class VirtualClock<br>
+ * Simulated time: now() only moves when the scheduler advances it.<br>
+ * -------------------------------------------------------<br>
+ * - sleepFor() from a kid fiber sets a timer and parks the fiber.<br>
+ * -------------------------------------------------------<br>
+ */
+class VirtualClock : public Clock {
+private:
+    Simulation& sim;                  ///< Scheduler owning the timers<br>
+    double t = 0;                     ///< Current simulated time<br>
+
+    friend class Simulation;
+
+public:
+    explicit VirtualClock(Simulation& sim) : sim(sim) {}
+    double now() override { return t; }
+    void sleepFor(double seconds) override;
+};
+
+/**
+ * @class SimTransport<br>
+ * In-memory Transport: a pair of SimPipes shared with the other end.<br>
+ * -------------------------------------------------------<br>
+ * - recv() on an empty pipe parks the calling kid fiber until Mom writes.<br>
+ * - A kid's send() first sleeps for the simulation's latency, so a kid
+ *   polling Mom in a loop still moves the clock.<br>
+ * - Mom only uses the non-blocking calls; her writes always fit and arrive at once.<br>
+ * -------------------------------------------------------<br>
+ */
+class SimTransport : public Transport {
+private:
+    Simulation& sim;                  ///< Scheduler to park and wake fibers<br>
+    shared_ptr<SimPipe> in;           ///< Pipe we read from<br>
+    shared_ptr<SimPipe> out;          ///< Pipe we write to<br>
+
+public:
+    SimTransport(Simulation& sim, shared_ptr<SimPipe> in, shared_ptr<SimPipe> out)
+        : sim(sim), in(std::move(in)), out(std::move(out)) {}
+    ~SimTransport() override;
+    long send(const void* data, size_t len) override;
+    long recv(void* data, size_t len) override;
+    long tryRecv(void* data, size_t len) override;
+    long trySend(const void* data, size_t len) override { return send(data, len); }
+    int pollFd() const override { return -1; }
+    bool buffered() const override { return in->head < in->bytes.size() || in->closed; }
+};
+
+/**
+ * @class SimListener<br>
+ * Mom's welcome point in a simulation: kids queue their Mom-side ends here.<br>
+ */
+class SimListener : public Listener {
+private:
+    deque<unique_ptr<Transport>> waiting;  ///< Mom-side ends of kids not yet accepted<br>
+
+public:
+    void knock(unique_ptr<Transport> link) { waiting.push_back(std::move(link)); }
+    bool pending() const { return !waiting.empty(); }
+    unique_ptr<Transport> accept() override;
+    unique_ptr<Transport> adopt(int sock) override { return nullptr; }
+    int pollFd() const override { return -1; }
+};
+
+/**
+ * @class SimEngine<br>
+ * Mom's I/O engine in a simulation; wait() is where simulated time passes.<br>
+ * -------------------------------------------------------<br>
+ * - Runs every runnable kid fiber until each one blocks.<br>
+ * - Returns at once if a kid wrote to Mom or is waiting to join.<br>
+ * - Otherwise jumps the clock to the next kid timer, or to the end of
+ *   the timeout if that comes first.<br>
+ * -------------------------------------------------------<br>
+ */
+class SimEngine : public IoEngine {
+private:
+    Simulation& sim;                  ///< Scheduler of the kid fibers<br>
+    SimListener& welcome;             ///< Where joining kids wait<br>
+    vector<Transport*> links;         ///< Mom-side ends being watched<br>
+
+public:
+    SimEngine(Simulation& sim, SimListener& welcome) : sim(sim), welcome(welcome) {}
+    string name() const override { return "sim"; }
+    void listen(Listener& welcome) override {}
+    unique_ptr<Transport> accept(Listener& welcome) override { return welcome.accept(); }
+    unique_ptr<Transport> add(unique_ptr<Transport> link) override;
+    void remove(Transport& link) override;
+    void wait(int timeoutMs, vector<Transport*>& ready) override;
+};
+
+/**
+ * @class Simulation<br>
+ * Discrete-event run of the real Mom and Kid code in one thread.<br>
+ * -------------------------------------------------------<br>
+ * - Mom runs on the thread's own stack; each kid runs Kid::run() in a Fiber.<br>
+ * - Messages travel through SimTransports; each kid message costs
+ *   `latency`, and Kid work (sleepFor) and Mom's poll timeouts move the clock too.<br>
+ * - Nothing waits for real time; a run costs only the CPU its messages take.<br>
+ * -------------------------------------------------------<br>
+ */
+class Simulation {
+private:
+    /**
+     * @struct Timer<br>
+     * A fiber to resume at a simulated time; `seq` keeps equal times in FIFO order.<br>
+     */
+    struct Timer {
+        double when;
+        long seq;
+        Fiber* fiber;
+        bool operator>(const Timer& other) const {
+            return when != other.when ? when > other.when : seq > other.seq;
+        }
+    };
+
+    VirtualClock clock{*this};                ///< Simulated time<br>
+    vector<unique_ptr<Fiber>> fibers;         ///< All kid fibers, finished or not<br>
+    vector<Fiber*> runnable;                  ///< Fibers ready to resume, in order; emptied once all have run<br>
+    priority_queue<Timer, vector<Timer>, greater<Timer>> timers; ///< Sleeping fibers<br>
+    long timerSeq = 0;                        ///< Tie-breaker for `timers`<br>
+    double latency = SIM_LATENCY;             ///< Simulated delay of each kid message<br>
+    Tracer* tracer = nullptr;                 ///< Shared by Mom and every kid, when tracing<br>
+    TableFormat format = TableFormat::PACKED; ///< Table encoding every kid asks for<br>
+    bool prefetch = false;                    ///< Kids reserve their next job while working<br>
+    Fiber* current = nullptr;                 ///< Fiber running now (nullptr = Mom)<br>
+    ucontext_t schedulerContext;              ///< Where parked fibers return to<br>
+    SimListener* welcome = nullptr;           ///< Mom's listener (owned by Mom)<br>
+    Mom mom;                                  ///< The real dispatcher; declared last so its links close while the scheduler still exists<br>
+
+    static void trampoline();
+
+    friend class VirtualClock;
+    friend class SimTransport;
+    friend class SimEngine;
+
+    /**
+     * Suspends the running fiber until something wakes it.<br>
+     */
+    void park();
+
+    /**
+     * Makes a parked fiber runnable.<br>
+     */
+    void wake(Fiber* fiber);
+
+    /**
+     * Resumes runnable fibers until none is left.<br>
+     */
+    void runFibers();
+
+    /**
+     * @return Time of the earliest timer (infinity if none)<br>
+     */
+    double nextTimer() const;
+
+    /**
+     * Moves the clock to `when` and makes every timer due by then runnable.<br>
+     */
+    void advanceTo(double when);
+
+public:
+    Simulation();
+
+    /**
+     * Sets the simulated delay of each kid-to-Mom message.<br>
+     */
+    void setLatency(double seconds) { latency = seconds; }
+
+    /**
+     * @return The simulation's clock, for a Tracer that records in simulated time<br>
+     */
+    Clock& simClock() { return clock; }
+
+    /**
+     * Records Mom and every kid added afterwards into one trace.<br>
+     */
+    void traceTo(Tracer& tracer) { this->tracer = &tracer; mom.traceTo(tracer); }
+
+    /**
+     * Records the kids' traffic to Mom, in simulated time, for replay against a real Mom.<br>
+     */
+    void captureTo(Capture& capture) { mom.captureTo(capture); }
+
+    /**
+     * Sets Mom's table size and the encoding kids added afterwards ask for.<br>
+     */
+    void setTable(short slots, TableFormat format) { mom.setTableSize(slots); this->format = format; }
+
+    /**
+     * Puts kids added afterwards in pipelined mode.<br>
+     */
+    void setPrefetch(bool on) { prefetch = on; }
+
+    /**
+     * Has Mom assign claims in batches (see Mom::setClaimWindow()).<br>
+     */
+    void setClaimWindow(double seconds, bool forJobs) { mom.setClaimWindow(seconds, forJobs); }
+
+    /**
+     * Lets Mom split slow jobs left unclaimed (see Mom::setSplitAfter()).<br>
+     */
+    void setSplitAfter(double seconds) { mom.setSplitAfter(seconds); }
+
+    /**
+     * Gives Mom's jobs deadlines (see Mom::setDeadlines()).<br>
+     */
+    void setDeadlines(double slack) { mom.setDeadlines(slack); }
+
+    /**
+     * Adds a kid that connects to Mom at simulated time `joinAt`.<br>
+     * Kids joining at the same time are admitted in the order they were
+     * added, so the n-th of them is Mom's kidName(n).<br>
+     * @param mood Fixed mood for the kid; rolled at random if empty<br>
+     */
+    void addKid(double joinAt = 0, optional<Mood> mood = nullopt);
+
+    /**
+     * Runs Mom for `seconds` of simulated time, then lets every kid finish.<br>
+     */
+    void run(double seconds);
+
+    /**
+     * @return The simulated Mom, for reading results after run()<br>
+     */
+    const Mom& mother() const { return mom; }
+};
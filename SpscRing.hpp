@@ -0,0 +1,67 @@
+#pragma once
+#include "tools.hpp"
+#include <atomic>
+
+/**
+ * @class SpscRing<br>
+ * Bounded lock-free queue for exactly one producer thread and one consumer thread.<br>
+ * -------------------------------------------------------<br>
+ * - Capacity is rounded up to a power of two so positions wrap with a mask.<br>
+ * - `head` and `tail` only ever grow; each side writes its own and reads
+ *   the other's, and they sit on separate cache lines.<br>
+ * - push() and pop() never block: they report full or empty and let the
+ *   caller decide whether to wait.<br>
+ * -------------------------------------------------------<br>
+ */
+template <typename T>
+class SpscRing {
+private:
+    vector<T> items;                  ///< Ring storage<br>
+    size_t mask;                      ///< Capacity - 1<br>
+    alignas(64) atomic<size_t> head{0}; ///< Next position to pop (consumer)<br>
+    alignas(64) atomic<size_t> tail{0}; ///< Next position to push (producer)<br>
+
+    static size_t roundUp(size_t n) {
+        size_t size = 1;
+        while (size < n) size <<= 1;
+        return size;
+    }
+
+public:
+    /**
+     * @param capacity Smallest number of items the ring must hold<br>
+     * @param fill Value the storage starts out holding<br>
+     */
+    explicit SpscRing(size_t capacity, const T& fill = T()) : items(roundUp(capacity), fill), mask(roundUp(capacity) - 1) {}
+
+    /**
+     * Producer side.<br>
+     * @return false if the ring is full<br>
+     */
+    bool push(const T& item) {
+        size_t at = tail.load(memory_order_relaxed);
+        if (at - head.load(memory_order_acquire) > mask) return false;
+        items[at & mask] = item;
+        tail.store(at + 1, memory_order_seq_cst);
+        return true;
+    }
+
+    /**
+     * Consumer side.<br>
+     * @return false if the ring is empty<br>
+     */
+    bool pop(T& item) {
+        size_t at = head.load(memory_order_relaxed);
+        if (at == tail.load(memory_order_acquire)) return false;
+        item = items[at & mask];
+        head.store(at + 1, memory_order_seq_cst);
+        return true;
+    }
+
+    /**
+     * @return Items waiting; exact only on the producer or consumer thread<br>
+     */
+    size_t size() const { return tail.load(memory_order_seq_cst) - head.load(memory_order_seq_cst); }
+
+    size_t capacity() const { return mask + 1; }
+};
@@ -0,0 +1,143 @@
+#include "Sweep.hpp"
+#include <map>
+
+#define MOOD_COUNT 5
+
+/**
+ * Nearest-rank percentile of a sorted sample.<br>
+ */
+static double percentile(const vector<double>& sorted, double p) {
+    if (sorted.empty()) return 0;
+    size_t rank = size_t(ceil(p / 100 * sorted.size()));
+    return sorted[rank > 0 ? rank - 1 : 0];
+}
+
+/**
+ * Writes mean, standard deviation, p10, p50, and p90 of `sample`.<br>
+ */
+static void writeStats(ostream& out, vector<double> sample) {
+    sort(sample.begin(), sample.end());
+    double sum = 0, squares = 0;
+    for (double x : sample) sum += x;
+    double mean = sample.empty() ? 0 : sum / sample.size();
+    for (double x : sample) squares += (x - mean) * (x - mean);
+    double sd = sample.size() > 1 ? sqrt(squares / (sample.size() - 1)) : 0;
+    out << ',' << mean << ',' << sd << ',' << percentile(sample, 10)
+        << ',' << percentile(sample, 50) << ',' << percentile(sample, 90);
+}
+
+/**
+ * Lists every mood multiset of size `config.kids` in non-decreasing mood order.<br>
+ */
+Sweep::Sweep(const SweepConfig& config) : config(config) {
+    vector<Mood> combo(config.kids, Mood::LAZY);
+    for (;;) {
+        combos.push_back(combo);
+        int k = config.kids - 1;
+        while (k >= 0 && static_cast<int>(combo[k]) == MOOD_COUNT - 1) k--;
+        if (k < 0) break;
+        Mood next = static_cast<Mood>(static_cast<int>(combo[k]) + 1);
+        for (int j = k; j < config.kids; j++) combo[j] = next;
+    }
+}
+
+/**
+ * Runs one simulation. <br>
+ * -------------------------------------------------------
+ * - Seeds this thread's generator, so the run is the same on any worker.
+ * - All kids join at time 0, so the n-th kid added is Mom's kidName(n);
+ *   that is how Mom's per-name results map back to moods.
+ * - Heap allocations are counted on this thread only, so runs on other
+ *   workers don't show up in this one's count.
+ * -------------------------------------------------------
+ */
+Sweep::Outcome Sweep::simulate(const vector<Mood>& moods, unsigned seed) const {
+    seedRandom(seed);
+    long allocations = Heap::threadAllocations();
+    Simulation sim;
+    sim.setLatency(config.latency);
+    for (Mood mood : moods) sim.addKid(0, mood);
+    sim.run(config.seconds);
+    allocations = Heap::threadAllocations() - allocations;
+
+    const Mom& mom = sim.mother();
+    unordered_map<string, long> byName;
+    for (auto& [job, name] : mom.results()) byName[name] += job.getValue();
+    Outcome outcome;
+    for (size_t n = 0; n < moods.size(); n++) outcome.earnings.push_back(byName[mom.kidName(n)]);
+    outcome.jobs = mom.results().size();
+    outcome.messages = mom.messageCount();
+    outcome.allocations = allocations;
+    return outcome;
+}
+
+/**
+ * Queues one task per run; each writes only its own slot of `outcomes`.<br>
+ */
+void Sweep::run(ThreadPool& pool) {
+    outcomes.assign(combos.size() * config.runs, Outcome{});
+    for (size_t c = 0; c < combos.size(); c++) {
+        for (int r = 0; r < config.runs; r++) {
+            size_t slot = c * config.runs + r;
+            pool.submit([this, c, slot] {
+                outcomes[slot] = simulate(combos[c], config.seed + slot);
+            });
+        }
+    }
+    pool.wait();
+}
+
+/**
+ * Writes the report. <br>
+ * -------------------------------------------------------
+ * - `moods` names the combination, e.g. LAZY+GREEDY+GREEDY+COOPERATIVE.
+ * - `earnings_*` is the household total per run: mean, sd, p10, p50, p90.
+ * - `jobs_per_s_*` is completed jobs per simulated second, same statistics.
+ * - `messages_mean` and `allocations_mean` are the mean kid messages Mom
+ *   handled and heap allocations made per run.
+ * - `<MOOD>_mean` is the mean earnings of one kid in that mood (empty if
+ *   the combination has none).
+ * -------------------------------------------------------
+ */
+void Sweep::writeCsv(ostream& out) const {
+    out << "moods,runs"
+        << ",earnings_mean,earnings_sd,earnings_p10,earnings_p50,earnings_p90"
+        << ",jobs_per_s_mean,jobs_per_s_sd,jobs_per_s_p10,jobs_per_s_p50,jobs_per_s_p90"
+        << ",messages_mean,allocations_mean";
+    for (int m = 0; m < MOOD_COUNT; m++) out << ',' << moodName[m] << "_mean";
+    out << '\n' << fixed << setprecision(3);
+
+    for (size_t c = 0; c < combos.size(); c++) {
+        vector<double> totals, rates;
+        double messages = 0, allocations = 0;
+        map<int, pair<double, int>> perMood;
+        for (int r = 0; r < config.runs; r++) {
+            const Outcome& outcome = outcomes[c * config.runs + r];
+            long total = 0;
+            for (size_t n = 0; n < outcome.earnings.size(); n++) {
+                total += outcome.earnings[n];
+                auto& [sum, count] = perMood[static_cast<int>(combos[c][n])];
+                sum += outcome.earnings[n];
+                count++;
+            }
+            totals.push_back(total);
+            rates.push_back(outcome.jobs / config.seconds);
+            messages += outcome.messages;
+            allocations += outcome.allocations;
+        }
+
+        for (size_t n = 0; n < combos[c].size(); n++)
+            out << (n > 0 ? "+" : "") << moodName[static_cast<int>(combos[c][n])];
+        out << ',' << config.runs;
+        writeStats(out, totals);
+        writeStats(out, rates);
+        out << ',' << (config.runs > 0 ? messages / config.runs : 0);
+        out << ',' << (config.runs > 0 ? allocations / config.runs : 0);
+        for (int m = 0; m < MOOD_COUNT; m++) {
+            out << ',';
+            auto found = perMood.find(m);
+            if (found != perMood.end()) out << found->second.first / found->second.second;
+        }
+        out << '\n';
+    }
+}
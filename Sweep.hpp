@@ -0,0 +1,71 @@
+#pragma once
+#include "tools.hpp"
+#include "Enums.hpp"
+#include "Simulation.hpp"
+#include "ThreadPool.hpp"
+
+/**
+ * @struct SweepConfig<br>
+ * What a sweep runs: every mood combination, `runs` times each.<br>
+ */
+struct SweepConfig {
+    int kids = 4;                     ///< Kids in every run<br>
+    int runs = 100;                   ///< Seeded runs per mood combination<br>
+    double seconds = 21;              ///< Simulated length of each run<br>
+    double latency = SIM_LATENCY;     ///< Simulated delay of each kid message<br>
+    unsigned seed = 1;                ///< Seed of the first run; the rest count up from it<br>
+};
+
+/**
+ * @class Sweep<br>
+ * Monte-Carlo sweep of kid mood combinations over independent simulations.<br>
+ * -------------------------------------------------------<br>
+ * - A combination is a multiset of moods, one per kid (the order kids
+ *   join in does not matter to Mom, so LAZY+GREEDY is GREEDY+LAZY).<br>
+ * - Each run is its own Simulation on a ThreadPool worker with its own
+ *   seed, so results do not depend on the thread count or on scheduling.<br>
+ * - writeCsv() reports, per combination, the distribution of total
+ *   earnings and of throughput (jobs completed per simulated second),
+ *   plus the mean earnings of a kid in each mood.<br>
+ * -------------------------------------------------------<br>
+ */
+class Sweep {
+private:
+    /**
+     * @struct Outcome<br>
+     * What one run produced.<br>
+     */
+    struct Outcome {
+        vector<long> earnings;        ///< Per kid, in combination order, without Mom's bonus<br>
+        int jobs = 0;                 ///< Jobs Mom saw completed<br>
+        long messages = 0;            ///< Kid messages Mom handled<br>
+        long allocations = 0;         ///< Heap allocations the run made, on its worker's thread<br>
+    };
+
+    SweepConfig config;               ///< Sweep parameters<br>
+    vector<vector<Mood>> combos;      ///< Every mood multiset of size `config.kids`<br>
+    vector<Outcome> outcomes;         ///< combos.size() × config.runs results, filled in by workers<br>
+
+    /**
+     * Runs one seeded simulation with the given moods.<br>
+     */
+    Outcome simulate(const vector<Mood>& moods, unsigned seed) const;
+
+public:
+    explicit Sweep(const SweepConfig& config);
+
+    /**
+     * @return Number of mood combinations<br>
+     */
+    size_t combinations() const { return combos.size(); }
+
+    /**
+     * Runs every simulation on `pool` and waits for all of them.<br>
+     */
+    void run(ThreadPool& pool);
+
+    /**
+     * Writes one CSV row per combination.<br>
+     */
+    void writeCsv(ostream& out) const;
+};
@@ -0,0 +1,169 @@
+#include "TableCodec.hpp"
+
+#define PACKED_CODES 4096   ///< Distinct 12-bit slot codes<br>
+
+TableFormat tableFormatFromName(const string& name) {
+    for (short k = 0; k < 2; k++)
+        if (caseInsensitiveEquals(name, tableFormatName[k])) return static_cast<TableFormat>(k);
+    fatal("Unknown table format: " + name + " (use shorts or packed)");
+    return TableFormat::SHORTS;
+}
+
+/**
+ * Builds the decode table on first use (thread-safe static initialization).<br>
+ */
+const TableCodec::Slot* TableCodec::slotTable() {
+    static const vector<Slot> table = [] {
+        vector<Slot> slots(PACKED_CODES);
+        for (int code = 0; code < PACKED_CODES; code++) {
+            Slot& slot = slots[code];
+            slot.sequential = code & 1;
+            slot.slow = ((code >> 1) & 7) + 1;
+            slot.dirty = ((code >> 4) & 7) + 1;
+            slot.heavy = ((code >> 7) & 7) + 1;
+            int status = (code >> 10) & 3;
+            slot.status = static_cast<JobStatus>(status);
+            slot.value = slot.slow * (slot.dirty + slot.heavy);
+            slot.valid = slot.slow <= 5 && slot.dirty <= 5 && slot.heavy <= 5 && status <= 2;
+        }
+        return slots;
+    }();
+    return table.data();
+}
+
+void TableCodec::putVarint(string& out, uint32_t value) {
+    while (value >= 0x80) {
+        out += static_cast<char>(value | 0x80);
+        value >>= 7;
+    }
+    out += static_cast<char>(value);
+}
+
+bool TableCodec::getVarint(const string& in, size_t& at, uint32_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 32 && at < in.size(); shift += 7) {
+        uint8_t byte = in[at++];
+        value |= uint32_t(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+void TableCodec::encodeRows(const JobTable& table, vector<short>& rows) {
+    rows.resize(table.size() * ROW_SHORTS);
+    size_t index = 0;
+    for (const Job& job : table.jobs) {
+        rows[index++] = job.jobNumber;
+        rows[index++] = job.slow;
+        rows[index++] = job.dirty;
+        rows[index++] = job.heavy;
+        rows[index++] = job.value;
+        rows[index++] = static_cast<short>(job.status);
+        rows[index++] = static_cast<short>(job.generation);
+    }
+}
+
+/**
+ * Rows may come in any order; each lands at its own jobNumber.<br>
+ */
+bool TableCodec::decodeRows(const short* rows, short slots, JobTable& table) {
+    if (slots < 0 || slots > MAX_JOB_SLOTS) return false;
+    if (table.size() != slots) table.resize(slots);
+    for (int j = 0; j < slots * ROW_SHORTS; j += ROW_SHORTS) {
+        short number = rows[j];
+        if (number < 0 || number >= slots || rows[j + 5] < 0 || rows[j + 5] > 2) return false;
+        Job& job = table.jobs[number];
+        job.jobNumber = number;
+        job.slow = rows[j + 1];
+        job.dirty = rows[j + 2];
+        job.heavy = rows[j + 3];
+        job.value = rows[j + 4];
+        job.status = static_cast<JobStatus>(rows[j + 5]);
+        job.generation = static_cast<uint16_t>(rows[j + 6]);
+    }
+    return true;
+}
+
+void TableCodec::encodePacked(const JobTable& table, string& out) {
+    out.clear();
+    short slots = table.size();
+    putVarint(out, slots);
+    putVarint(out, slots > 0 ? table.jobs[0].jobNumber : 0);
+    vector<short> jumps;
+    uint32_t pair = 0;
+    for (short i = 0; i < slots; i++) {
+        const Job& job = table.jobs[i];
+        bool sequential = i == 0 || job.jobNumber == table.jobs[i - 1].jobNumber + 1;
+        if (!sequential) jumps.push_back(job.jobNumber);
+        uint32_t code = (sequential ? 1 : 0) | (job.slow - 1) << 1 | (job.dirty - 1) << 4
+                      | (job.heavy - 1) << 7 | static_cast<uint32_t>(job.status) << 10;
+        if (i % 2 == 0) pair = code;
+        else {
+            pair |= code << 12;
+            out += static_cast<char>(pair);
+            out += static_cast<char>(pair >> 8);
+            out += static_cast<char>(pair >> 16);
+        }
+    }
+    if (slots % 2 == 1) {
+        out += static_cast<char>(pair);
+        out += static_cast<char>(pair >> 8);
+    }
+    for (short number : jumps) putVarint(out, number);
+    for (const Job& job : table.jobs) putVarint(out, job.generation);
+}
+
+/**
+ * Decodes a packed table. <br>
+ * -------------------------------------------------------
+ * - The hot loop reads three bytes, splits them into two 12-bit codes,
+ *   and copies each code's pre-decoded attributes out of slotTable().
+ * - Job numbers are filled in afterwards from the sequential flags and
+ *   the trailing list, then checked to be in range; generations follow.
+ *   Until then each flag is parked in the job's number, so decoding
+ *   allocates nothing once the table is the right size.
+ * -------------------------------------------------------
+ */
+bool TableCodec::decodePacked(const string& in, JobTable& table) {
+    size_t at = 0;
+    uint32_t slots, first;
+    if (!getVarint(in, at, slots) || !getVarint(in, at, first) || slots > MAX_JOB_SLOTS) return false;
+    size_t codeBytes = slots / 2 * 3 + (slots % 2) * 2;
+    if (in.size() - at < codeBytes) return false;
+    if (table.size() != short(slots)) table.resize(slots);
+
+    const Slot* decode = slotTable();
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(in.data()) + at;
+    bool valid = true;
+    for (uint32_t i = 0; i < slots; i += 2) {
+        uint32_t pair = bytes[0] | bytes[1] << 8 | (i + 1 < slots ? bytes[2] << 16 : 0);
+        bytes += 3;
+        for (uint32_t k = 0; k < 2 && i + k < slots; k++) {
+            const Slot& slot = decode[(pair >> (12 * k)) & (PACKED_CODES - 1)];
+            Job& job = table.jobs[i + k];
+            job.slow = slot.slow;
+            job.dirty = slot.dirty;
+            job.heavy = slot.heavy;
+            job.value = slot.value;
+            job.status = slot.status;
+            job.jobNumber = slot.sequential;
+            valid &= slot.valid;
+        }
+    }
+    if (!valid) return false;
+    at += codeBytes;
+
+    uint32_t number = first;
+    for (uint32_t i = 0; i < slots; i++) {
+        if (i > 0 && table.jobs[i].jobNumber) number++;
+        else if (i > 0 && !getVarint(in, at, number)) return false;
+        if (number >= slots) return false;
+        table.jobs[i].jobNumber = number;
+    }
+    for (Job& job : table.jobs) {
+        uint32_t generation;
+        if (!getVarint(in, at, generation) || generation > UINT16_MAX) return false;
+        job.generation = generation;
+    }
+    return true;
+}
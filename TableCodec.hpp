@@ -0,0 +1,86 @@
+#pragma once
+#include "tools.hpp"
+#include "Enums.hpp"
+#include "JobTable.hpp"
+
+/**
+ * Maps a command-line name (shorts, packed) to its TableFormat.<br>
+ * @throws Terminates the program on an unknown name.<br>
+ */
+TableFormat tableFormatFromName(const string& name);
+
+/**
+ * @class TableCodec<br>
+ * Wire encodings of the job table.<br>
+ * -------------------------------------------------------<br>
+ * - Rows: ROW_SHORTS shorts per slot (jobNumber, slow, dirty, heavy, value,
+ *   status, generation). Used by TableFormat::SHORTS and by the shared-memory snapshot.<br>
+ * - Packed (TableFormat::PACKED):<br>
+ *     varint slots, varint first jobNumber,<br>
+ *     then 12 bits per slot, two slots to every three bytes, low bits first:<br>
+ *       bit 0      jobNumber is the previous one + 1<br>
+ *       bits 1-3   slow - 1<br>
+ *       bits 4-6   dirty - 1<br>
+ *       bits 7-9   heavy - 1<br>
+ *       bits 10-11 status<br>
+ *     then a varint jobNumber for each slot whose bit 0 was clear,<br>
+ *     then a varint generation for every slot.<br>
+ *   `value` is left out and recomputed as slow × (dirty + heavy).
+ *   Mom's tables are always numbered in order, so a slot costs 2.5 bytes
+ *   until its generation passes 127, against 14 as rows.<br>
+ * - Decoding packed slots is one lookup per 12-bit code in a table built
+ *   once per process.<br>
+ * -------------------------------------------------------<br>
+ */
+class TableCodec {
+private:
+    /**
+     * @struct Slot<br>
+     * A decoded 12-bit code; `valid` is false for attribute values out of range.<br>
+     */
+    struct Slot {
+        short slow, dirty, heavy, value;
+        JobStatus status;
+        bool sequential;
+        bool valid;
+    };
+
+    /**
+     * @return The 4096-entry decode table<br>
+     */
+    static const Slot* slotTable();
+
+public:
+    /**
+     * Appends `value` seven bits to a byte, low bits first, high bit set on all but the last.<br>
+     */
+    static void putVarint(string& out, uint32_t value);
+
+    /**
+     * Reads a varint at `at` and moves `at` past it.<br>
+     * @return false if `in` ends first<br>
+     */
+    static bool getVarint(const string& in, size_t& at, uint32_t& value);
+
+    /**
+     * Encodes the table as ROW_SHORTS shorts per slot.<br>
+     */
+    static void encodeRows(const JobTable& table, vector<short>& rows);
+
+    /**
+     * Fills `table` from `slots` rows of ROW_SHORTS shorts.<br>
+     * @return false if a row is malformed<br>
+     */
+    static bool decodeRows(const short* rows, short slots, JobTable& table);
+
+    /**
+     * Encodes the table in the packed format.<br>
+     */
+    static void encodePacked(const JobTable& table, string& out);
+
+    /**
+     * Fills `table` from a packed encoding.<br>
+     * @return false if the encoding is truncated or malformed<br>
+     */
+    static bool decodePacked(const string& in, JobTable& table);
+};
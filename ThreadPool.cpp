@@ -0,0 +1,87 @@
+#include "ThreadPool.hpp"
+
+ThreadPool::ThreadPool(unsigned count) {
+    if (count == 0) count = max(1u, thread::hardware_concurrency());
+    for (unsigned i = 0; i < count; i++) workers.push_back(make_unique<Worker>());
+    for (unsigned i = 0; i < count; i++) threads.emplace_back(&ThreadPool::work, this, i);
+}
+
+ThreadPool::~ThreadPool() {
+    wait();
+    {
+        lock_guard<mutex> guard(idleLock);
+        stopping = true;
+    }
+    idle.notify_all();
+    for (thread& worker : threads) worker.join();
+}
+
+/**
+ * Queues a task. <br>
+ * -------------------------------------------------------
+ * - From inside a task, the new task goes on the caller's own deque so
+ *   related work stays on one core unless somebody idle steals it.
+ * - The counters go up before the wake-up, which is taken under
+ *   `idleLock`, so a worker about to sleep cannot miss it.
+ * -------------------------------------------------------
+ */
+void ThreadPool::submit(function<void()> task) {
+    size_t index = self >= 0 ? self : nextWorker++ % workers.size();
+    pending++;
+    {
+        lock_guard<mutex> guard(workers[index]->lock);
+        workers[index]->tasks.push_back(std::move(task));
+    }
+    queued++;
+    lock_guard<mutex> guard(idleLock);
+    idle.notify_one();
+}
+
+bool ThreadPool::take(size_t index, function<void()>& task) {
+    {
+        Worker& own = *workers[index];
+        lock_guard<mutex> guard(own.lock);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            queued--;
+            return true;
+        }
+    }
+    for (size_t step = 1; step < workers.size(); step++) {
+        Worker& victim = *workers[(index + step) % workers.size()];
+        lock_guard<mutex> guard(victim.lock);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            queued--;
+            stolen++;
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::work(size_t index) {
+    self = index;
+    function<void()> task;
+    for (;;) {
+        if (take(index, task)) {
+            task();
+            task = nullptr;
+            if (--pending == 0) {
+                lock_guard<mutex> guard(idleLock);
+                idle.notify_all();
+            }
+            continue;
+        }
+        unique_lock<mutex> guard(idleLock);
+        idle.wait(guard, [this] { return stopping || queued > 0; });
+        if (stopping && queued == 0) return;
+    }
+}
+
+void ThreadPool::wait() {
+    unique_lock<mutex> guard(idleLock);
+    idle.wait(guard, [this] { return pending == 0; });
+}
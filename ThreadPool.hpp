@@ -0,0 +1,87 @@
+#pragma once
+#include "tools.hpp"
+#include <deque>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+/**
+ * @class ThreadPool<br>
+ * Work-stealing pool of worker threads, one per core by default.<br>
+ * -------------------------------------------------------<br>
+ * - Every worker owns a deque. It takes its own work from the back and,
+ *   when that runs dry, steals the oldest task from the front of another
+ *   worker's deque.<br>
+ * - Tasks submitted from outside the pool are dealt round-robin; tasks a
+ *   task submits go to the back of its own worker's deque.<br>
+ * - Idle workers sleep on a condition variable instead of spinning.<br>
+ * -------------------------------------------------------<br>
+ */
+class ThreadPool {
+private:
+    /**
+     * @struct Worker<br>
+     * One worker's task deque and its lock.<br>
+     */
+    struct Worker {
+        mutex lock;
+        deque<function<void()>> tasks;
+    };
+
+    vector<unique_ptr<Worker>> workers;   ///< Task deques, one per thread<br>
+    vector<thread> threads;               ///< The worker threads<br>
+    mutex idleLock;                       ///< Guards sleeping and waking<br>
+    condition_variable idle;              ///< Signalled on new work, on the last task finishing, and on shutdown<br>
+    atomic<long> queued{0};               ///< Tasks sitting in some deque<br>
+    atomic<long> pending{0};              ///< Tasks submitted and not yet finished<br>
+    atomic<long> stolen{0};               ///< Tasks run by a worker other than the one they were queued on<br>
+    atomic<size_t> nextWorker{0};         ///< Round-robin position for outside submissions<br>
+    bool stopping = false;                ///< Destructor has asked the workers to exit<br>
+
+    static inline thread_local long self = -1; ///< Index of the worker running on this thread (-1 outside the pool)<br>
+
+    /**
+     * Pops worker `index`'s newest task, or steals another worker's oldest.<br>
+     * @return false if every deque is empty<br>
+     */
+    bool take(size_t index, function<void()>& task);
+
+    /**
+     * Body of worker thread `index`.<br>
+     */
+    void work(size_t index);
+
+public:
+    /**
+     * Starts the workers.<br>
+     * @param count Number of threads; 0 means one per hardware thread<br>
+     */
+    explicit ThreadPool(unsigned count = 0);
+
+    /**
+     * Lets queued tasks finish, then joins every worker.<br>
+     */
+    ~ThreadPool();
+
+    /**
+     * Queues a task for some worker.<br>
+     */
+    void submit(function<void()> task);
+
+    /**
+     * Blocks until every submitted task has finished.<br>
+     */
+    void wait();
+
+    /**
+     * @return Number of worker threads<br>
+     */
+    unsigned size() const { return threads.size(); }
+
+    /**
+     * @return Tasks that were stolen from another worker's deque<br>
+     */
+    long steals() const { return stolen; }
+};
@@ -0,0 +1,77 @@
+#include "Tracer.hpp"
+
+void Tracer::span(const char* name, const char* category, int pid, int tid, double start, string args) {
+    events.push_back(Event{'X', name, category, start, clock.now() - start, pid, tid, 0, std::move(args)});
+}
+
+void Tracer::instant(const char* name, const char* category, int pid, int tid, string args) {
+    events.push_back(Event{'i', name, category, clock.now(), 0, pid, tid, 0, std::move(args)});
+}
+
+void Tracer::begin(const char* name, const char* category, int pid, long id, string args) {
+    events.push_back(Event{'b', name, category, clock.now(), 0, pid, 0, id, std::move(args)});
+}
+
+void Tracer::end(const char* name, const char* category, int pid, long id, string args) {
+    events.push_back(Event{'e', name, category, clock.now(), 0, pid, 0, id, std::move(args)});
+}
+
+void Tracer::label(int pid, int tid, const string& name) {
+    threadNames.emplace_back(make_pair(pid, tid), name);
+}
+
+string Tracer::arg(const char* key, long value) {
+    return "\"" + string(key) + "\":" + to_string(value);
+}
+
+/**
+ * Quotes `value`, escaping the characters JSON does not allow bare.<br>
+ */
+string Tracer::arg(const char* key, const string& value) {
+    string quoted = "\"" + string(key) + "\":\"";
+    for (char c : value) {
+        if (c == '"' || c == '\\') quoted += '\\';
+        if (static_cast<unsigned char>(c) < 0x20) continue;
+        quoted += c;
+    }
+    return quoted + "\"";
+}
+
+/**
+ * Writes the trace. <br>
+ * -------------------------------------------------------
+ * - Times are microseconds, as the format expects.
+ * - Labels become "M" (metadata) events ahead of the rest.
+ * - Instants are thread-scoped; async events carry their id as a string.
+ * -------------------------------------------------------
+ */
+void Tracer::write(ostream& out) const {
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    bool first = true;
+    for (auto& [where, name] : threadNames) {
+        out << (first ? "" : ",\n") << "{\"ph\":\"M\",\"pid\":" << where.first;
+        if (where.second < 0) out << ",\"name\":\"process_name\"";
+        else out << ",\"tid\":" << where.second << ",\"name\":\"thread_name\"";
+        out << ",\"args\":{" << arg("name", name) << "}}";
+        first = false;
+    }
+    out << fixed << setprecision(3);
+    for (const Event& event : events) {
+        out << (first ? "" : ",\n") << "{\"ph\":\"" << event.phase << "\",\"name\":\"" << event.name
+            << "\",\"cat\":\"" << event.category << "\",\"pid\":" << event.pid << ",\"tid\":" << event.tid
+            << ",\"ts\":" << event.start * 1e6;
+        if (event.phase == 'X') out << ",\"dur\":" << event.duration * 1e6;
+        if (event.phase == 'i') out << ",\"s\":\"t\"";
+        if (event.phase == 'b' || event.phase == 'e') out << ",\"id\":\"" << event.id << "\"";
+        if (!event.args.empty()) out << ",\"args\":{" << event.args << "}";
+        out << "}";
+        first = false;
+    }
+    out << "\n]}\n";
+}
+
+void Tracer::save(const string& path) const {
+    ofstream file(path);
+    if (!file) fatal("Can't write trace file " + path);
+    write(file);
+}
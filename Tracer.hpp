@@ -0,0 +1,93 @@
+#pragma once
+#include "tools.hpp"
+#include "Clock.hpp"
+
+#define TRACE_MOM_PID 0        ///< Trace process of Mom; kid n is TRACE_MOM_PID + 1 + n<br>
+#define TRACE_RESERVE 65536    ///< Events reserved up front so recording rarely reallocates<br>
+
+/**
+ * @class Tracer<br>
+ * Records spans and instants in memory and writes them as Chrome trace-event JSON.<br>
+ * -------------------------------------------------------<br>
+ * - Recording is a push onto a vector: names and categories are string
+ *   literals, times come from the tracer's clock, and nothing is
+ *   formatted or written until save().<br>
+ * - Spans ("X") belong to one thread of one process; async spans
+ *   ("b"/"e") follow one job across many kids and are matched by `id`.<br>
+ * - With the wall clock, times are CLOCK_MONOTONIC, so files written by
+ *   Mom and by each Kid line up when merged
+ *   (e.g. `jq -s '{traceEvents: map(.traceEvents) | add}'`).<br>
+ * - The file opens in chrome://tracing or ui.perfetto.dev.<br>
+ * -------------------------------------------------------<br>
+ */
+class Tracer {
+private:
+    /**
+     * @struct Event<br>
+     * One trace event; `args` holds ready-made JSON members.<br>
+     */
+    struct Event {
+        char phase;
+        const char* name;
+        const char* category;
+        double start;
+        double duration;
+        int pid;
+        int tid;
+        long id;
+        string args;
+    };
+
+    Clock& clock;                     ///< Time source for every event<br>
+    vector<Event> events;             ///< Everything recorded so far<br>
+    vector<pair<pair<int, int>, string>> threadNames; ///< (pid, tid) labels; tid -1 names the process<br>
+
+public:
+    explicit Tracer(Clock& clock) : clock(clock) { events.reserve(TRACE_RESERVE); }
+
+    /**
+     * @return Current time on the tracer's clock, to pass back as a span's start<br>
+     */
+    double now() { return clock.now(); }
+
+    /**
+     * Records a span from `start` until now on thread `tid` of process `pid`.<br>
+     */
+    void span(const char* name, const char* category, int pid, int tid, double start, string args = "");
+
+    /**
+     * Records a point event.<br>
+     */
+    void instant(const char* name, const char* category, int pid, int tid, string args = "");
+
+    /**
+     * Opens an async span keyed by `id`; nested ones with the same id stack.<br>
+     */
+    void begin(const char* name, const char* category, int pid, long id, string args = "");
+
+    /**
+     * Closes the async span `name` opened with the same `id`.<br>
+     */
+    void end(const char* name, const char* category, int pid, long id, string args = "");
+
+    /**
+     * Labels a process (`tid` = -1) or one of its threads in the viewer.<br>
+     */
+    void label(int pid, int tid, const string& name);
+
+    /**
+     * Formats one argument as a JSON member, e.g. `"slot":3`.<br>
+     */
+    static string arg(const char* key, long value);
+    static string arg(const char* key, const string& value);
+
+    /**
+     * Writes every event as a Chrome trace JSON object.<br>
+     */
+    void write(ostream& out) const;
+
+    /**
+     * Writes the trace to `path`; fatal if the file can't be created.<br>
+     */
+    void save(const string& path) const;
+};
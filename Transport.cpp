@@ -0,0 +1,451 @@
+#include "Transport.hpp"
+#include <sys/un.h>
+#include <sys/mman.h>
+#include <sys/eventfd.h>
+#include <sys/epoll.h>
+#include <sched.h>
+#include <fcntl.h>
+
+/**
+ * Builds the file-system path of the Unix socket Mom listens on for `port`.<br>
+ */
+static string socketPath(int port) {
+    return string(SOCKPATH) + "." + to_string(port) + ".sock";
+}
+
+/**
+ * Fills a sockaddr_un for the Unix socket belonging to `port`.<br>
+ */
+static socklen_t unixAddress(sockaddr_un& addr, int port) {
+    string path = socketPath(port);
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+    return sizeof(addr);
+}
+
+/**
+ * Passes the shared region and its two eventfds to the Kid (SCM_RIGHTS).<br>
+ */
+static bool sendFds(int sock, const int* fds, int n) {
+    char tag = 'S';
+    iovec iov{&tag, 1};
+    char control[CMSG_SPACE(3 * sizeof(int))]{};
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = CMSG_SPACE(n * sizeof(int));
+    cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(n * sizeof(int));
+    memcpy(CMSG_DATA(cmsg), fds, n * sizeof(int));
+    return sendmsg(sock, &msg, 0) == 1;
+}
+
+/**
+ * Receives the descriptors sent by sendFds().<br>
+ */
+static bool recvFds(int sock, int* fds, int n) {
+    char tag;
+    iovec iov{&tag, 1};
+    char control[CMSG_SPACE(3 * sizeof(int))]{};
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = CMSG_SPACE(n * sizeof(int));
+    if (recvmsg(sock, &msg, 0) != 1) return false;
+    cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    if (cmsg == nullptr || cmsg->cmsg_type != SCM_RIGHTS) return false;
+    memcpy(fds, CMSG_DATA(cmsg), n * sizeof(int));
+    return true;
+}
+
+TransportKind transportFromName(const string& name) {
+    for (short k = 0; k < 3; k++)
+        if (caseInsensitiveEquals(name, transportName[k])) return static_cast<TransportKind>(k);
+    fatal("Unknown transport: " + name + " (use tcp, unix, or shm)");
+    return TransportKind::TCP;
+}
+
+// -------------------------------------------------------------------
+// Transport
+// -------------------------------------------------------------------
+bool Transport::recvAll(void* data, size_t len) {
+    char* dst = static_cast<char*>(data);
+    while (len > 0) {
+        long nBytes = recv(dst, len);
+        if (nBytes <= 0) return false;
+        dst += nBytes;
+        len -= nBytes;
+    }
+    return true;
+}
+
+/**
+ * Connects to Mom with the requested transport.<br>
+ * -------------------------------------------------------
+ * - TCP: resolves localhost and connects on `port`.
+ * - UNIX: connects to Mom's socket file for `port`.
+ * - SHM: connects like UNIX and receives the shared region and eventfds;
+ *   all traffic goes through the rings, the socket only signals departure.
+ * - Another Mom connects with `required` off, so a peer that isn't up yet
+ *   is retried later instead of ending the run (TCP and UNIX only: an SHM
+ *   handshake would block until the peer's loop accepted).
+ * -------------------------------------------------------
+ * @throws Terminates the program if a required connection cannot be made.
+ */
+unique_ptr<Transport> Transport::connect(TransportKind kind, int port, bool required) {
+    if (kind == TransportKind::TCP) {
+        // Make an internet-transmitted, file-i/o-style, protocol-whatever plug
+        int sock = socket(AF_INET, SOCK_STREAM, 0);
+        if (sock < 0) fatal("Can't assign fd for client socket");
+
+        // Use a domain name server to get the IP address associated with the host.
+        hostInfo* remoteHost = gethostbyname(LOCALHOST);
+        if (remoteHost == nullptr) fatal("unknown host: " + string(LOCALHOST) + "\n");
+
+        sockInfo clientInfo{};
+        clientInfo.sin_family = AF_INET;
+        memmove(&clientInfo.sin_addr, remoteHost->h_addr_list[0], remoteHost->h_length);
+        clientInfo.sin_port = htons(port);
+        if (required) printSockInfo("client", clientInfo);
+
+        int status = ::connect(sock, (sockUnion*)&clientInfo, sizeof clientInfo);
+        if (status < 0 && !required) {
+            close(sock);
+            return nullptr;
+        }
+        if (status < 0) fatal("Connection to " + string(LOCALHOST) + " refused.");
+        cout << "connection established to " << LOCALHOST << ".\n";
+        return make_unique<SocketTransport>(sock);
+    }
+
+    int sock = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (sock < 0) fatal("Can't assign fd for client socket");
+    sockaddr_un addr;
+    socklen_t len = unixAddress(addr, port);
+    if (::connect(sock, (sockUnion*)&addr, len) < 0) {
+        if (!required) {
+            close(sock);
+            return nullptr;
+        }
+        fatal("Connection to " + string(addr.sun_path) + " refused.");
+    }
+    cout << "connection established to " << addr.sun_path << ".\n";
+    if (kind == TransportKind::UNIX) return make_unique<SocketTransport>(sock);
+
+    int fds[3];
+    if (!recvFds(sock, fds, 3)) fatal("Mom did not send the shared-memory region.");
+    return make_unique<ShmTransport>(fds[0], fds[2], fds[1], sock, false);
+}
+
+// -------------------------------------------------------------------
+// SocketTransport
+// -------------------------------------------------------------------
+/**
+ * Writes everything; MSG_NOSIGNAL turns a vanished peer into an error return instead of SIGPIPE.<br>
+ */
+long SocketTransport::send(const void* data, size_t len) {
+    const char* src = static_cast<const char*>(data);
+    size_t left = len;
+    while (left > 0) {
+        long nBytes = ::send(sock, src, left, MSG_NOSIGNAL);
+        syscalls++;
+        if (nBytes < 0 && errno == EINTR) continue;
+        if (nBytes <= 0) return -1;
+        src += nBytes;
+        left -= nBytes;
+    }
+    return len;
+}
+
+long SocketTransport::recv(void* data, size_t len) {
+    long nBytes;
+    do { nBytes = read(sock, data, len); syscalls++; }
+    while (nBytes < 0 && errno == EINTR);
+    return nBytes;
+}
+
+/**
+ * One MSG_DONTWAIT read, so the socket itself stays blocking for the Kid side.<br>
+ */
+long SocketTransport::tryRecv(void* data, size_t len) {
+    long nBytes;
+    do { nBytes = ::recv(sock, data, len, MSG_DONTWAIT); syscalls++; }
+    while (nBytes < 0 && errno == EINTR);
+    if (nBytes < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return TRANSPORT_AGAIN;
+    return nBytes;
+}
+
+long SocketTransport::trySend(const void* data, size_t len) {
+    long nBytes;
+    do { nBytes = ::send(sock, data, len, MSG_DONTWAIT | MSG_NOSIGNAL); syscalls++; }
+    while (nBytes < 0 && errno == EINTR);
+    if (nBytes < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return 0;
+    return nBytes;
+}
+
+// -------------------------------------------------------------------
+// ShmRing
+// -------------------------------------------------------------------
+/**
+ * Copies as much of `src` as fits into the ring (writer side only).<br>
+ * @return Number of bytes stored<br>
+ */
+size_t ShmRing::put(const char* src, size_t len) {
+    uint64_t t = tail.load(memory_order_relaxed);
+    size_t room = SHM_RING_BYTES - (t - head.load(memory_order_acquire));
+    size_t n = min(len, room);
+    size_t at = t % SHM_RING_BYTES;
+    size_t first = min(n, (size_t)SHM_RING_BYTES - at);
+    memcpy(data + at, src, first);
+    memcpy(data, src + first, n - first);
+    tail.store(t + n, memory_order_release);
+    return n;
+}
+
+/**
+ * Copies up to `len` waiting bytes out of the ring (reader side only).<br>
+ * @return Number of bytes consumed<br>
+ */
+size_t ShmRing::take(char* dst, size_t len) {
+    uint64_t h = head.load(memory_order_relaxed);
+    size_t n = min(len, (size_t)(tail.load(memory_order_acquire) - h));
+    size_t at = h % SHM_RING_BYTES;
+    size_t first = min(n, (size_t)SHM_RING_BYTES - at);
+    memcpy(dst, data + at, first);
+    memcpy(dst + first, data, n - first);
+    head.store(h + n, memory_order_release);
+    return n;
+}
+
+// -------------------------------------------------------------------
+// ShmTransport
+// -------------------------------------------------------------------
+ShmTransport::ShmTransport(int memFd, int inFd, int outFd, int sock, bool momSide)
+    : memFd(memFd), inFd(inFd), outFd(outFd), sock(sock) {
+    region = mmap(nullptr, 2 * sizeof(ShmRing), PROT_READ | PROT_WRITE, MAP_SHARED, memFd, 0);
+    if (region == MAP_FAILED) fatal("Can't map the shared-memory transport");
+    ShmRing* rings = static_cast<ShmRing*>(region);
+    in = momSide ? &rings[0] : &rings[1];
+    out = momSide ? &rings[1] : &rings[0];
+    waitFd = epoll_create1(EPOLL_CLOEXEC);
+    epoll_event watch{};
+    watch.events = EPOLLIN;
+    watch.data.fd = inFd;
+    epoll_ctl(waitFd, EPOLL_CTL_ADD, inFd, &watch);
+    watch.data.fd = sock;
+    epoll_ctl(waitFd, EPOLL_CTL_ADD, sock, &watch);
+}
+
+/**
+ * Tells the peer we are gone, then releases the region, eventfds, and socket.<br>
+ */
+ShmTransport::~ShmTransport() {
+    out->closed.store(true);
+    uint64_t one = 1;
+    write(outFd, &one, sizeof(one));
+    munmap(region, 2 * sizeof(ShmRing));
+    ::close(memFd);
+    ::close(inFd);
+    ::close(outFd);
+    ::close(waitFd);
+    ::close(sock);
+}
+
+void ShmTransport::checkPeer() {
+    char probe;
+    long nBytes = ::recv(sock, &probe, 1, MSG_DONTWAIT | MSG_PEEK);
+    syscalls++;
+    if (nBytes == 0 || (nBytes < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) gone = true;
+}
+
+/**
+ * Writes into the outbound ring and bumps the peer's eventfd.<br>
+ * -------------------------------------------------------
+ * - A message larger than the free space is written in pieces; the
+ *   writer yields until the reader drains the ring.
+ * -------------------------------------------------------
+ */
+long ShmTransport::send(const void* data, size_t len) {
+    const char* src = static_cast<const char*>(data);
+    size_t left = len;
+    uint64_t one = 1;
+    while (left > 0) {
+        if (in->closed.load(memory_order_relaxed) || gone) return -1;
+        size_t n = out->put(src, left);
+        if (n == 0) { sched_yield(); continue; }
+        src += n;
+        left -= n;
+        write(outFd, &one, sizeof(one));
+        syscalls++;
+    }
+    return len;
+}
+
+/**
+ * Reads from the inbound ring, sleeping on the eventfd only while it is empty.<br>
+ * The peer may write its last bytes between an empty take() and closing,
+ * so once it has closed the ring is taken from again before reporting EOF.<br>
+ */
+long ShmTransport::recv(void* data, size_t len) {
+    char* dst = static_cast<char*>(data);
+    for (;;) {
+        size_t n = in->take(dst, len);
+        if (n > 0) return n;
+        if (in->closed.load() || gone) return in->take(dst, len);
+        toPoll wait[2] = {{inFd, POLLIN, 0}, {sock, POLLIN, 0}};
+        if (poll(wait, 2, -1) < 0 && errno != EINTR) return -1;
+        syscalls++;
+        if (wait[1].revents) checkPeer();
+        if (!wait[0].revents) continue;
+        uint64_t count;
+        read(inFd, &count, sizeof(count));
+        syscalls++;
+    }
+}
+
+long ShmTransport::tryRecv(void* data, size_t len) {
+    size_t n = in->take(static_cast<char*>(data), len);
+    if (n > 0) return n;
+    return in->closed.load() || gone ? in->take(static_cast<char*>(data), len) : TRANSPORT_AGAIN;
+}
+
+/**
+ * Stores what fits in the outbound ring; the eventfd is only bumped if something went in.<br>
+ */
+long ShmTransport::trySend(const void* data, size_t len) {
+    if (in->closed.load(memory_order_relaxed) || gone) return -1;
+    size_t n = out->put(static_cast<const char*>(data), len);
+    if (n > 0) {
+        uint64_t one = 1;
+        write(outFd, &one, sizeof(one));
+        syscalls++;
+    }
+    return n;
+}
+
+/**
+ * Clears the eventfd, then checks the ring so no wakeup is lost. <br>
+ * -------------------------------------------------------
+ * - A wakeup with nothing in the ring may have come from the socket, so
+ *   the socket is checked then; io_uring's multishot poll only reports
+ *   edges, so this is the one chance to notice a departed peer.
+ * -------------------------------------------------------
+ */
+bool ShmTransport::wakeup() {
+    uint64_t count;
+    read(inFd, &count, sizeof(count));
+    syscalls++;
+    if (!buffered()) checkPeer();
+    return buffered();
+}
+
+// -------------------------------------------------------------------
+// Listeners
+// -------------------------------------------------------------------
+/**
+ * @class SocketListener<br>
+ * Listening AF_INET or AF_UNIX socket; SHM mode hands out rings instead.<br>
+ */
+class SocketListener : public Listener {
+private:
+    int fd;               ///< Welcome socket<br>
+    TransportKind kind;   ///< What accept() hands back<br>
+    string path;          ///< Socket file to remove (Unix family only)<br>
+
+public:
+    SocketListener(TransportKind kind, int port);
+    ~SocketListener() override;
+    unique_ptr<Transport> accept() override;
+    unique_ptr<Transport> adopt(int sock) override;
+    int pollFd() const override { return fd; }
+};
+
+/**
+ * Creates, binds, and listens on the welcome socket. <br>
+ * -------------------------------------------------------
+ * - TCP binds all interfaces on `port` and prints the bound address.
+ * - UNIX and SHM bind a socket file derived from `port`.
+ * - The welcome socket is non-blocking: kids may join at any time, and
+ *   Mom only accepts when its I/O engine says one is waiting.
+ * -------------------------------------------------------
+ * @throws Terminates the program if socket creation, binding, or listening fails.
+ */
+SocketListener::SocketListener(TransportKind kind, int port) : kind(kind) {
+    int status;
+    if (kind == TransportKind::TCP) {
+        fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (fd < 0) fatal("Socket: Can't create socket");
+        sockInfo info{};
+        info.sin_family = AF_INET;
+        info.sin_port = htons(port);
+        info.sin_addr.s_addr = INADDR_ANY;
+        status = ::bind(fd, (sockUnion*)&info, sizeof(info));
+        if (status < 0) fatal("Can't bind socket " + to_string(fd));
+        socklen_t addrlen = sizeof(info);
+        status = getsockname(fd, (sockUnion*)&info, &addrlen);
+        if (status < 0) fatal("Socket: getsockname failed on socket " + to_string(fd));
+        printSockInfo("Mom", info);
+    }
+    else {
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0) fatal("Socket: Can't create socket");
+        sockaddr_un addr;
+        socklen_t len = unixAddress(addr, port);
+        path = addr.sun_path;
+        unlink(path.c_str());
+        status = ::bind(fd, (sockUnion*)&addr, len);
+        if (status < 0) fatal("Can't bind socket " + path);
+    }
+    cout << "Just bound " << transportName[static_cast<short>(kind)] << " socket " << fd << endl;
+
+    // Declare that this is the welcome socket and it listens for kid contacts.
+    status = ::listen(fd, SOMAXCONN);
+    if (status < 0) fatal("Socket: Unable to listen on socket " + to_string(fd));
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    cout << "Just called listen(); now waiting for a client to show up\n";
+}
+
+SocketListener::~SocketListener() {
+    ::close(fd);
+    if (!path.empty()) unlink(path.c_str());
+}
+
+/**
+ * Accepts one Kid on the welcome socket, if one is waiting.<br>
+ */
+unique_ptr<Transport> SocketListener::accept() {
+    return adopt(::accept(fd, nullptr, nullptr));
+}
+
+/**
+ * Turns an accepted socket into the Kid's transport. <br>
+ * -------------------------------------------------------
+ * - For SHM, creates the two rings in a memfd plus one eventfd per
+ *   direction and ships them to the Kid; the socket stays open so Mom
+ *   can tell when the Kid exits.
+ * -------------------------------------------------------
+ */
+unique_ptr<Transport> SocketListener::adopt(int sock) {
+    if (sock < 0) return nullptr;
+    if (kind != TransportKind::SHM) return make_unique<SocketTransport>(sock);
+
+    int memFd = memfd_create("socketsync", 0);
+    int toMom = eventfd(0, EFD_NONBLOCK);
+    int toKid = eventfd(0, EFD_NONBLOCK);
+    if (memFd < 0 || toMom < 0 || toKid < 0 || ftruncate(memFd, 2 * sizeof(ShmRing)) < 0)
+        fatal("Can't create the shared-memory transport");
+    int fds[3] = {memFd, toMom, toKid};
+    bool sent = sendFds(sock, fds, 3);
+    unique_ptr<Transport> link = make_unique<ShmTransport>(memFd, toMom, toKid, sock, true);
+    if (!sent) return nullptr;
+    return link;
+}
+
+unique_ptr<Listener> Listener::open(TransportKind kind, int port) {
+    return make_unique<SocketListener>(kind, port);
+}
@@ -0,0 +1,200 @@
+#pragma once
+#include "tools.hpp"
+#include "Enums.hpp"
+#include <atomic>
+#include <memory>
+
+#define SHM_RING_BYTES (1 << 20)
+#define TRANSPORT_AGAIN (-2)   ///< tryRecv(): nothing is waiting yet<br>
+
+/**
+ * Maps a command-line name (tcp, unix, shm) to its TransportKind.<br>
+ * @throws Terminates the program on an unknown name.<br>
+ */
+TransportKind transportFromName(const string& name);
+
+/**
+ * @class Transport<br>
+ * Byte-stream link between Mom and one Kid.<br>
+ * -------------------------------------------------------<br>
+ * - Mom and Kid speak the same short-based protocol over every transport.<br>
+ * - `pollFd()` becomes readable when the peer has sent something, so Mom can
+ *   keep one poll() loop for all transports.<br>
+ * -------------------------------------------------------<br>
+ */
+class Transport {
+public:
+    static inline atomic<long> syscalls{0}; ///< I/O system calls made by this process, on every thread<br>
+
+    virtual ~Transport() = default;
+
+    /**
+     * Sends all `len` bytes to the peer.<br>
+     * @return Bytes sent, or -1 if the peer is gone<br>
+     */
+    virtual long send(const void* data, size_t len) = 0;
+
+    /**
+     * Receives up to `len` bytes, blocking until at least one arrives.<br>
+     * @return Bytes received, 0 when the peer closed, -1 on error<br>
+     */
+    virtual long recv(void* data, size_t len) = 0;
+
+    /**
+     * Receives whatever is already waiting, without blocking.<br>
+     * @return Bytes received, 0 when the peer closed, -1 on error, TRANSPORT_AGAIN if nothing is waiting<br>
+     */
+    virtual long tryRecv(void* data, size_t len) = 0;
+
+    /**
+     * Sends as much of `data` as fits right now, without blocking.<br>
+     * @return Bytes accepted (possibly 0), or -1 if the peer is gone<br>
+     */
+    virtual long trySend(const void* data, size_t len) = 0;
+
+    /**
+     * @return File descriptor to poll for POLLIN<br>
+     */
+    virtual int pollFd() const = 0;
+
+    /**
+     * @return File descriptor to poll for POLLOUT, or -1 if writability cannot be polled<br>
+     */
+    virtual int writeFd() const { return socketFd(); }
+
+    /**
+     * @return The underlying stream socket, or -1 if the transport is not a socket<br>
+     */
+    virtual int socketFd() const { return -1; }
+
+    /**
+     * Consumes a readiness notification reported on pollFd().<br>
+     * @return false if the notification was stale and recv() would block<br>
+     */
+    virtual bool wakeup() { return true; }
+
+    /**
+     * @return true if input is already waiting in user space, which poll() cannot see<br>
+     */
+    virtual bool buffered() const { return false; }
+
+    /**
+     * Receives exactly `len` bytes, looping over short reads.<br>
+     * @return false if the peer closed before everything arrived<br>
+     */
+    bool recvAll(void* data, size_t len);
+
+    /**
+     * Connects a Kid (or another Mom) to the Mom listening on `port` with the given transport.<br>
+     * @param required Terminate if nobody is listening; otherwise return nullptr (TCP and UNIX only)<br>
+     */
+    static unique_ptr<Transport> connect(TransportKind kind, int port, bool required = true);
+};
+
+/**
+ * @class Listener<br>
+ * Mom's welcome point for new Kid transports.<br>
+ */
+class Listener {
+public:
+    virtual ~Listener() = default;
+
+    /**
+     * Accepts a waiting Kid and returns its transport.<br>
+     * @return nullptr if no Kid is waiting or the handshake failed<br>
+     */
+    virtual unique_ptr<Transport> accept() = 0;
+
+    /**
+     * Finishes setting up a Kid whose socket was already accepted elsewhere.<br>
+     * @param sock Accepted socket (ownership passes to the listener)<br>
+     */
+    virtual unique_ptr<Transport> adopt(int sock) = 0;
+
+    /**
+     * @return File descriptor that is readable when a Kid is waiting<br>
+     */
+    virtual int pollFd() const = 0;
+
+    /**
+     * Creates, binds, and listens for the given transport on `port`.<br>
+     */
+    static unique_ptr<Listener> open(TransportKind kind, int port);
+};
+
+/**
+ * @class SocketTransport<br>
+ * Transport over a connected stream socket (AF_INET or AF_UNIX).<br>
+ */
+class SocketTransport : public Transport {
+private:
+    int sock;   ///< Connected socket descriptor<br>
+
+public:
+    explicit SocketTransport(int sock) : sock(sock) {}
+    ~SocketTransport() override { ::close(sock); }
+    long send(const void* data, size_t len) override;
+    long recv(void* data, size_t len) override;
+    long tryRecv(void* data, size_t len) override;
+    long trySend(const void* data, size_t len) override;
+    int pollFd() const override { return sock; }
+    int socketFd() const override { return sock; }
+};
+
+/**
+ * @struct ShmRing<br>
+ * Single-producer single-consumer byte ring living in shared memory.<br>
+ * head and tail only grow; the slot index is the position modulo the size.<br>
+ */
+struct ShmRing {
+    alignas(64) atomic<uint64_t> head;  ///< Next byte the reader will consume<br>
+    alignas(64) atomic<uint64_t> tail;  ///< Next byte the writer will fill<br>
+    alignas(64) atomic<bool> closed;    ///< Writer has hung up<br>
+    alignas(64) char data[SHM_RING_BYTES];
+
+    size_t put(const char* src, size_t len);
+    size_t take(char* dst, size_t len);
+    bool empty() const { return head.load(memory_order_relaxed) == tail.load(memory_order_acquire); }
+};
+
+/**
+ * @class ShmTransport<br>
+ * Transport over a pair of ShmRings, one per direction.<br>
+ * -------------------------------------------------------<br>
+ * - The region is a memfd handed from Mom to the Kid over a Unix socket.<br>
+ * - Each direction has an eventfd the writer bumps after filling its ring;
+ *   the reader only sleeps on it when its ring is empty.<br>
+ * - Both sides keep the Unix socket open but silent: it turns readable
+ *   (end of stream) only when the peer exits, even if it was killed.<br>
+ * - pollFd() is an epoll descriptor over the eventfd and that socket, so
+ *   one poll() entry covers both data and departure.<br>
+ * -------------------------------------------------------<br>
+ */
+class ShmTransport : public Transport {
+private:
+    int memFd;       ///< Backing memfd of the shared region<br>
+    int inFd;        ///< eventfd signalled when `in` gets data<br>
+    int outFd;       ///< eventfd we signal after filling `out`<br>
+    int sock;        ///< Hand-off socket, kept only to notice the peer leaving<br>
+    int waitFd;      ///< epoll set of `inFd` and `sock`<br>
+    bool gone = false; ///< The peer's end of `sock` has closed<br>
+    ShmRing* in;     ///< Ring we read from<br>
+    ShmRing* out;    ///< Ring we write to<br>
+    void* region;    ///< Mapping holding both rings<br>
+
+    /**
+     * Checks the hand-off socket for end of stream and records it in `gone`.<br>
+     */
+    void checkPeer();
+
+public:
+    ShmTransport(int memFd, int inFd, int outFd, int sock, bool momSide);
+    ~ShmTransport() override;
+    long send(const void* data, size_t len) override;
+    long recv(void* data, size_t len) override;
+    long tryRecv(void* data, size_t len) override;
+    long trySend(const void* data, size_t len) override;
+    int pollFd() const override { return waitFd; }
+    bool wakeup() override;
+    bool buffered() const override { return !in->empty() || in->closed.load() || gone; }
+};
@@ -0,0 +1,391 @@
+#include "UringEngine.hpp"
+
+#ifdef HAVE_IO_URING
+#include <sys/syscall.h>
+
+/**
+ * Operation carried in the low byte of each request's user_data.<br>
+ */
+enum UringOp : uint64_t { OP_ACCEPT = 1, OP_RECV, OP_POLL, OP_SEND, OP_CANCEL };
+
+static uint64_t tag(uint32_t token, UringOp op) { return (uint64_t(token) << 8) | op; }
+
+// -------------------------------------------------------------------
+// UringLink
+// -------------------------------------------------------------------
+/**
+ * Queues bytes for the next batched SEND.<br>
+ */
+long UringLink::send(const void* data, size_t len) {
+    if (dead) return -1;
+    outbox.insert(outbox.end(), static_cast<const char*>(data), static_cast<const char*>(data) + len);
+    if (!queued) {
+        queued = true;
+        engine.dirty.push_back(this);
+    }
+    return len;
+}
+
+/**
+ * Serves bytes from the inbox, pumping the ring while it is empty.<br>
+ */
+long UringLink::recv(void* data, size_t len) {
+    while (inHead == inbox.size() && !eof) engine.pump();
+    size_t n = min(len, inbox.size() - inHead);
+    if (n == 0) return 0;
+    memcpy(data, inbox.data() + inHead, n);
+    inHead += n;
+    if (inHead == inbox.size()) { inbox.clear(); inHead = 0; }
+    return n;
+}
+
+long UringLink::tryRecv(void* data, size_t len) {
+    if (inHead == inbox.size()) return eof ? 0 : TRANSPORT_AGAIN;
+    return recv(data, len);
+}
+
+/**
+ * Queues what fits under URING_LINK_BYTES of unsent output.<br>
+ */
+long UringLink::trySend(const void* data, size_t len) {
+    if (dead) return -1;
+    size_t held = outbox.size() + inflight.size() - sent;
+    if (held >= URING_LINK_BYTES) return 0;
+    return send(data, min(len, URING_LINK_BYTES - held));
+}
+
+// -------------------------------------------------------------------
+// Ring set-up
+// -------------------------------------------------------------------
+unique_ptr<IoEngine> UringEngine::open() {
+    unique_ptr<UringEngine> engine(new UringEngine());
+    if (!engine->setup()) return nullptr;
+    return engine;
+}
+
+/**
+ * Creates the ring, maps its queues, and registers the provided buffers. <br>
+ * -------------------------------------------------------
+ * - Asks for a single-issuer ring first and retries without flags on
+ *   older kernels.
+ * -------------------------------------------------------
+ * @return false if any step is refused.
+ */
+bool UringEngine::setup() {
+    io_uring_params p{};
+    p.flags = IORING_SETUP_SINGLE_ISSUER | IORING_SETUP_COOP_TASKRUN;
+    ringFd = syscall(__NR_io_uring_setup, URING_ENTRIES, &p);
+    if (ringFd < 0) {
+        p = io_uring_params{};
+        ringFd = syscall(__NR_io_uring_setup, URING_ENTRIES, &p);
+    }
+    if (ringFd < 0) return false;
+
+    sqBytes = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    cqBytes = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+    if (p.features & IORING_FEAT_SINGLE_MMAP) sqBytes = cqBytes = max(sqBytes, cqBytes);
+    sqMap = mmap(nullptr, sqBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQ_RING);
+    if (sqMap == MAP_FAILED) return false;
+    if (p.features & IORING_FEAT_SINGLE_MMAP) cqMap = sqMap;
+    else cqMap = mmap(nullptr, cqBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_CQ_RING);
+    if (cqMap == MAP_FAILED) return false;
+    void* sqeMap = mmap(nullptr, p.sq_entries * sizeof(io_uring_sqe), PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQES);
+    if (sqeMap == MAP_FAILED) return false;
+    sqes = static_cast<io_uring_sqe*>(sqeMap);
+
+    char* sq = static_cast<char*>(sqMap);
+    sqHead = (unsigned*)(sq + p.sq_off.head);
+    sqTail = (unsigned*)(sq + p.sq_off.tail);
+    sqMask = (unsigned*)(sq + p.sq_off.ring_mask);
+    sqArray = (unsigned*)(sq + p.sq_off.array);
+    char* cq = static_cast<char*>(cqMap);
+    cqHead = (unsigned*)(cq + p.cq_off.head);
+    cqTail = (unsigned*)(cq + p.cq_off.tail);
+    cqMask = (unsigned*)(cq + p.cq_off.ring_mask);
+    cqes = (io_uring_cqe*)(cq + p.cq_off.cqes);
+    sqLocal = *sqTail;
+
+    // Provided-buffer ring: the kernel picks a buffer for each recv completion.
+    void* ringMem = mmap(nullptr, URING_BUFFERS * sizeof(io_uring_buf), PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ringMem == MAP_FAILED) return false;
+    bufRing = static_cast<io_uring_buf_ring*>(ringMem);
+    memset(bufRing, 0, URING_BUFFERS * sizeof(io_uring_buf));
+    bufMem = new char[URING_BUFFERS * URING_BUFFER_BYTES];
+    io_uring_buf_reg reg{};
+    reg.ring_addr = (uint64_t)bufRing;
+    reg.ring_entries = URING_BUFFERS;
+    reg.bgid = 0;
+    if (syscall(__NR_io_uring_register, ringFd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0) return false;
+    for (unsigned short bid = 0; bid < URING_BUFFERS; bid++) recycle(bid);
+    return true;
+}
+
+UringEngine::~UringEngine() {
+    if (ringFd >= 0) close(ringFd);
+    if (sqes != nullptr) munmap(sqes, URING_ENTRIES * sizeof(io_uring_sqe));
+    if (cqMap != MAP_FAILED && cqMap != sqMap) munmap(cqMap, cqBytes);
+    if (sqMap != MAP_FAILED) munmap(sqMap, sqBytes);
+    if (bufRing != nullptr) munmap(bufRing, URING_BUFFERS * sizeof(io_uring_buf));
+    delete[] bufMem;
+    for (int fd : accepted) close(fd);
+}
+
+// -------------------------------------------------------------------
+// Submission and completion
+// -------------------------------------------------------------------
+/**
+ * Returns a cleared SQE, submitting early if the queue is full.<br>
+ */
+io_uring_sqe* UringEngine::nextSqe() {
+    if (sqLocal - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE) >= URING_ENTRIES) submit(0, 0);
+    unsigned index = sqLocal & *sqMask;
+    io_uring_sqe* sqe = &sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    sqArray[index] = index;
+    sqLocal++;
+    toSubmit++;
+    return sqe;
+}
+
+/**
+ * Publishes prepared SQEs and optionally waits, all in one io_uring_enter().<br>
+ * @param waitFor Completions to wait for (0 = just submit)<br>
+ * @param timeoutMs Wait limit; negative waits forever<br>
+ */
+void UringEngine::submit(unsigned waitFor, int timeoutMs) {
+    __atomic_store_n(sqTail, sqLocal, __ATOMIC_RELEASE);
+    if (toSubmit == 0 && waitFor == 0) return;
+    __kernel_timespec ts{timeoutMs / 1000, (timeoutMs % 1000) * 1000000L};
+    io_uring_getevents_arg arg{};
+    arg.ts = timeoutMs >= 0 ? (uint64_t)&ts : 0;
+    unsigned flags = IORING_ENTER_EXT_ARG | (waitFor > 0 ? IORING_ENTER_GETEVENTS : 0);
+    long done = syscall(__NR_io_uring_enter, ringFd, toSubmit, waitFor, flags, &arg, sizeof(arg));
+    Transport::syscalls++;
+    if (done > 0) toSubmit -= min<unsigned>(toSubmit, done);
+}
+
+void UringEngine::armAccept() {
+    io_uring_sqe* sqe = nextSqe();
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = welcomeFd;
+    sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    sqe->user_data = tag(0, OP_ACCEPT);
+}
+
+void UringEngine::armRecv(uint32_t token, int sock) {
+    io_uring_sqe* sqe = nextSqe();
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = sock;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = 0;
+    sqe->user_data = tag(token, OP_RECV);
+}
+
+void UringEngine::armPoll(uint32_t token, int fd) {
+    io_uring_sqe* sqe = nextSqe();
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = fd;
+    sqe->poll32_events = POLLIN;
+    sqe->len = IORING_POLL_ADD_MULTI;
+    sqe->user_data = tag(token, OP_POLL);
+}
+
+void UringEngine::startSend(uint32_t token, UringLink& link) {
+    io_uring_sqe* sqe = nextSqe();
+    sqe->opcode = IORING_OP_SEND;
+    sqe->fd = link.socketFd();
+    sqe->addr = (uint64_t)(link.inflight.data() + link.sent);
+    sqe->len = link.inflight.size() - link.sent;
+    sqe->msg_flags = MSG_NOSIGNAL;
+    sqe->user_data = tag(token, OP_SEND);
+    link.sending = true;
+}
+
+/**
+ * Hands a consumed receive buffer back to the kernel.<br>
+ * -------------------------------------------------------
+ * - The ring's header overlays its first entry; indexing through `bufs`
+ *   is off in C++, where the flexible-array wrapper takes a byte.
+ * -------------------------------------------------------
+ */
+void UringEngine::recycle(unsigned short bid) {
+    io_uring_buf& buf = reinterpret_cast<io_uring_buf*>(bufRing)[bufTail & (URING_BUFFERS - 1)];
+    buf.addr = (uint64_t)(bufMem + bid * URING_BUFFER_BYTES);
+    buf.len = URING_BUFFER_BYTES;
+    buf.bid = bid;
+    bufTail++;
+    __atomic_store_n(&bufRing->tail, bufTail, __ATOMIC_RELEASE);
+}
+
+/**
+ * Turns every link's queued output into one SEND, unless one is already in flight.<br>
+ */
+void UringEngine::flushSends() {
+    for (UringLink* link : dirty) {
+        link->queued = false;
+        if (link->sending || link->outbox.empty()) continue;
+        link->inflight.swap(link->outbox);
+        link->outbox.clear();
+        link->sent = 0;
+        startSend(tokens[link], *link);
+    }
+    dirty.clear();
+}
+
+void UringEngine::markReady(Transport* link) {
+    if (find(pending.begin(), pending.end(), link) == pending.end()) pending.push_back(link);
+}
+
+/**
+ * Drains the completion queue. <br>
+ * -------------------------------------------------------
+ * - ACCEPT: queues the new socket for accept(); re-armed if it stops.
+ * - RECV: copies the provided buffer into the link's inbox and recycles it;
+ *   a zero-length or failed receive marks end of stream.
+ * - POLL: confirms shared-memory readiness with wakeup().
+ * - SEND: continues a partial send or starts the next queued one, and
+ *   reports the link so Mom can move more of its backlog.
+ * - Multishot requests that stop are re-armed.
+ * -------------------------------------------------------
+ */
+void UringEngine::reap() {
+    unsigned head = *cqHead;
+    unsigned tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+    for (; head != tail; head++) {
+        io_uring_cqe cqe = cqes[head & *cqMask];
+        uint32_t token = cqe.user_data >> 8;
+        UringOp op = static_cast<UringOp>(cqe.user_data & 0xff);
+        bool more = cqe.flags & IORING_CQE_F_MORE;
+        auto found = watches.find(token);
+        Watch* watch = found == watches.end() ? nullptr : &found->second;
+
+        if (op == OP_ACCEPT) {
+            if (cqe.res >= 0) accepted.push_back(cqe.res);
+            if (!more) armAccept();
+        }
+        else if (op == OP_RECV) {
+            if (cqe.flags & IORING_CQE_F_BUFFER) {
+                unsigned short bid = cqe.flags >> IORING_CQE_BUFFER_SHIFT;
+                if (watch != nullptr && cqe.res > 0)
+                    watch->wrapped->inbox.append(bufMem + bid * URING_BUFFER_BYTES, cqe.res);
+                recycle(bid);
+            }
+            if (watch == nullptr) continue;
+            if (cqe.res == 0 || (cqe.res < 0 && cqe.res != -ENOBUFS)) watch->wrapped->eof = true;
+            else if (!more) armRecv(token, watch->link->socketFd());
+            markReady(watch->link);
+        }
+        else if (op == OP_POLL) {
+            if (watch == nullptr) continue;
+            if (!more) armPoll(token, watch->link->pollFd());
+            if (watch->link->wakeup()) markReady(watch->link);
+        }
+        else if (op == OP_SEND) {
+            if (watch == nullptr) { orphans.erase(token); continue; }
+            UringLink& link = *watch->wrapped;
+            link.sending = false;
+            markReady(watch->link);
+            if (cqe.res < 0) { link.dead = true; continue; }
+            link.sent += cqe.res;
+            if (link.sent < link.inflight.size()) { startSend(token, link); continue; }
+            link.inflight.clear();
+            link.sent = 0;
+            if (!link.outbox.empty() && !link.queued) {
+                link.queued = true;
+                dirty.push_back(&link);
+            }
+        }
+    }
+    __atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+}
+
+void UringEngine::pump() {
+    flushSends();
+    submit(1, -1);
+    reap();
+}
+
+// -------------------------------------------------------------------
+// IoEngine interface
+// -------------------------------------------------------------------
+void UringEngine::listen(Listener& welcome) {
+    welcomeFd = welcome.pollFd();
+    armAccept();
+}
+
+/**
+ * Hands out the next kid the multishot accept produced, if any.<br>
+ */
+unique_ptr<Transport> UringEngine::accept(Listener& welcome) {
+    if (accepted.empty()) return nullptr;
+    int sock = accepted.front();
+    accepted.pop_front();
+    return welcome.adopt(sock);
+}
+
+/**
+ * Watches a kid: sockets are wrapped and get a multishot recv,
+ * everything else gets a multishot poll on its pollFd().<br>
+ */
+unique_ptr<Transport> UringEngine::add(unique_ptr<Transport> link) {
+    uint32_t token = nextToken++;
+    if (link->socketFd() < 0) {
+        watches[token] = Watch{link.get(), nullptr};
+        tokens[link.get()] = token;
+        armPoll(token, link->pollFd());
+        return link;
+    }
+    unique_ptr<UringLink> wrapped = make_unique<UringLink>(std::move(link), *this);
+    watches[token] = Watch{wrapped.get(), wrapped.get()};
+    tokens[wrapped.get()] = token;
+    armRecv(token, wrapped->socketFd());
+    return wrapped;
+}
+
+/**
+ * Cancels a transport's requests; an unfinished send keeps its buffer alive until it completes.<br>
+ */
+void UringEngine::remove(Transport& link) {
+    auto found = tokens.find(&link);
+    if (found == tokens.end()) return;
+    uint32_t token = found->second;
+    Watch watch = watches[token];
+    io_uring_sqe* sqe = nextSqe();
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->addr = tag(token, watch.wrapped != nullptr ? OP_RECV : OP_POLL);
+    sqe->user_data = tag(token, OP_CANCEL);
+    if (watch.wrapped != nullptr) {
+        if (watch.wrapped->sending) orphans[token].swap(watch.wrapped->inflight);
+        dirty.erase(std::remove(dirty.begin(), dirty.end(), watch.wrapped), dirty.end());
+    }
+    pending.erase(std::remove(pending.begin(), pending.end(), &link), pending.end());
+    watches.erase(token);
+    tokens.erase(found);
+}
+
+/**
+ * One batch: submit everything queued, wait for completions, report the links they touched.<br>
+ */
+void UringEngine::wait(int timeoutMs, vector<Transport*>& ready) {
+    flushSends();
+    submit(pending.empty() && accepted.empty() ? 1 : 0, timeoutMs);
+    reap();
+    ready.swap(pending);
+    pending.clear();
+}
+
+void UringEngine::drain() {
+    for (;;) {
+        flushSends();
+        bool busy = !orphans.empty();
+        for (auto& [token, watch] : watches)
+            if (watch.wrapped != nullptr && watch.wrapped->sending) busy = true;
+        if (!busy) return;
+        submit(1, -1);
+        reap();
+    }
+}
+#endif
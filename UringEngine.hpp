@@ -0,0 +1,139 @@
+#pragma once
+#include "IoEngine.hpp"
+
+#ifdef HAVE_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <deque>
+
+#define URING_ENTRIES 256
+#define URING_BUFFERS 256
+#define URING_BUFFER_BYTES 4096
+#define URING_LINK_BYTES (64 * 1024)   ///< Output a link holds before trySend() pushes back<br>
+
+class UringEngine;
+
+/**
+ * @class UringLink<br>
+ * Socket transport whose bytes move through Mom's io_uring.<br>
+ * -------------------------------------------------------<br>
+ * - Received bytes land in `inbox` from multishot recv completions.<br>
+ * - send() only queues; the engine submits one SEND per kid per batch.<br>
+ * - trySend() stops taking bytes at URING_LINK_BYTES; the kid is reported
+ *   ready again when its SEND completes.<br>
+ * -------------------------------------------------------<br>
+ */
+class UringLink : public Transport {
+private:
+    unique_ptr<Transport> inner;  ///< Socket transport that owns the descriptor<br>
+    UringEngine& engine;          ///< Engine that fills and drains this link<br>
+    string inbox;                 ///< Bytes received but not yet read<br>
+    size_t inHead = 0;            ///< Read position in `inbox`<br>
+    vector<char> outbox;          ///< Bytes queued since the last submission<br>
+    vector<char> inflight;        ///< Bytes the kernel is currently sending; a vector, not a string,
+                                  ///< so its bytes stay put when it is swapped or moved (no small-string buffer)<br>
+    size_t sent = 0;              ///< Bytes of `inflight` already sent<br>
+    bool eof = false;             ///< Kid hung up or the recv failed<br>
+    bool dead = false;            ///< A send failed; further sends are refused<br>
+    bool sending = false;         ///< A SEND is outstanding<br>
+    bool queued = false;          ///< Listed in the engine's dirty list<br>
+
+    friend class UringEngine;
+
+public:
+    UringLink(unique_ptr<Transport> inner, UringEngine& engine)
+        : inner(std::move(inner)), engine(engine) {}
+    long send(const void* data, size_t len) override;
+    long recv(void* data, size_t len) override;
+    long tryRecv(void* data, size_t len) override;
+    long trySend(const void* data, size_t len) override;
+    int pollFd() const override { return inner->pollFd(); }
+    int socketFd() const override { return inner->socketFd(); }
+    bool buffered() const override { return inHead < inbox.size() || eof; }
+};
+
+/**
+ * @class UringEngine<br>
+ * io_uring engine for Mom, driven by raw system calls.<br>
+ * -------------------------------------------------------<br>
+ * - Multishot accept on the welcome socket.<br>
+ * - Multishot recv into a registered provided-buffer ring for socket kids;
+ *   multishot poll on the eventfd for shared-memory kids.<br>
+ * - Queued replies, buffer recycling, and re-arms go to the kernel in a
+ *   single io_uring_enter() per batch.<br>
+ * -------------------------------------------------------<br>
+ */
+class UringEngine : public IoEngine {
+private:
+    /**
+     * @struct Watch<br>
+     * A transport the ring is watching; `wrapped` is null for poll-watched ones.<br>
+     */
+    struct Watch {
+        Transport* link;
+        UringLink* wrapped;
+    };
+
+    int ringFd = -1;                           ///< io_uring instance<br>
+    void* sqMap = MAP_FAILED;                  ///< Submission ring mapping<br>
+    void* cqMap = MAP_FAILED;                  ///< Completion ring mapping<br>
+    size_t sqBytes = 0, cqBytes = 0;           ///< Sizes of the two mappings<br>
+    io_uring_sqe* sqes = nullptr;              ///< Submission entries<br>
+    unsigned* sqHead; unsigned* sqTail; unsigned* sqMask; unsigned* sqArray;
+    unsigned* cqHead; unsigned* cqTail; unsigned* cqMask;
+    io_uring_cqe* cqes;                        ///< Completion entries<br>
+    unsigned sqLocal = 0;                      ///< Our tail, published at submit<br>
+    unsigned toSubmit = 0;                     ///< SQEs prepared but not submitted<br>
+
+    io_uring_buf_ring* bufRing = nullptr;      ///< Provided-buffer ring<br>
+    char* bufMem = nullptr;                    ///< Backing memory of the buffers<br>
+    unsigned short bufTail = 0;                ///< Our provided-buffer tail<br>
+
+    unordered_map<uint32_t, Watch> watches;    ///< Watched transports by token<br>
+    unordered_map<Transport*, uint32_t> tokens;///< Token of each watched transport<br>
+    uint32_t nextToken = 1;                    ///< Next token to hand out<br>
+    vector<UringLink*> dirty;                  ///< Links with queued output<br>
+    vector<Transport*> pending;                ///< Links that got input outside wait()<br>
+    unordered_map<uint32_t, vector<char>> orphans; ///< In-flight sends of removed links<br>
+    deque<int> accepted;                       ///< Accepted sockets not yet handed out<br>
+    int welcomeFd = -1;                        ///< Listening socket, for re-arming the accept<br>
+
+    UringEngine() = default;
+    bool setup();
+    io_uring_sqe* nextSqe();
+    void submit(unsigned waitFor, int timeoutMs);
+    void reap();
+    void armAccept();
+    void armRecv(uint32_t token, int sock);
+    void armPoll(uint32_t token, int fd);
+    void startSend(uint32_t token, UringLink& link);
+    void recycle(unsigned short bid);
+    void flushSends();
+    void markReady(Transport* link);
+
+    friend class UringLink;
+
+public:
+    ~UringEngine() override;
+
+    /**
+     * Sets up a ring and its provided buffers.<br>
+     * @return nullptr if the kernel refuses io_uring<br>
+     */
+    static unique_ptr<IoEngine> open();
+
+    string name() const override { return "uring"; }
+
+    void listen(Listener& welcome) override;
+    unique_ptr<Transport> accept(Listener& welcome) override;
+    unique_ptr<Transport> add(unique_ptr<Transport> link) override;
+    void remove(Transport& link) override;
+    void wait(int timeoutMs, vector<Transport*>& ready) override;
+    void drain() override;
+
+    /**
+     * Submits queued work and blocks for at least one completion.<br>
+     */
+    void pump();
+};
+#endif
@@ -3,9 +3,17 @@
 /**
  * Main function (Kid)<br>
  * -------------------------------------------------------<br>
- * - Seeds the random number generator (used for mood/job creation).<br>
+ * - Seeds the random number generator (used for mood/job creation) from the
+ *   time and the process ID, so kids started in the same second differ.<br>
+ * - Reads the transport choice: `-t tcp|unix|shm` (must match Mom's).<br>
+ * - `-s` reads the job table from Mom's shared-memory snapshot.<br>
+ * - `-f shorts|packed` table encoding to ask Mom for (default packed).<br>
+ * - `-p` pipelined mode: reserves the next job while doing the current one.<br>
+ * - `-P port` joins the Mom on that port (default 1099), e.g. one Mom of a cluster.<br>
+ * - `-Q name,name,...` subscribes to those of Mom's job queues (see mom -Q) and sees only their slots.<br>
+ * - `-T file` writes a Chrome trace of the kid's round trips and work.<br>
  * - Initializes a Kid object which:<br>
- *    - Connects to the Mom server via sockets.<br>
+ *    - Connects to the Mom server over the chosen transport.<br>
  *    - Receives a Kid ID and selects a mood.<br>
  *    - Continuously requests and performs jobs.<br>
  *    - Sends job completion messages to Mom.<br>
@@ -13,9 +21,41 @@
  * -------------------------------------------------------<br>
  * @return 0 on successful execution<br>
  */
-int main() {
-    srand(time(nullptr));
-    Kid kid{};
+int main(int argc, char* argv[]) {
+    TransportKind transport = TransportKind::TCP;
+    bool useSnapshot = false;
+    bool prefetch = false;
+    int port = PORT;
+    string tracePath;
+    TableFormat format = TableFormat::PACKED;
+    vector<string> queues;
+    int opt;
+    while ((opt = getopt(argc, argv, "t:spf:T:P:Q:")) != -1) {
+        if (opt == 't') transport = transportFromName(optarg);
+        else if (opt == 's') useSnapshot = true;
+        else if (opt == 'p') prefetch = true;
+        else if (opt == 'f') format = tableFormatFromName(optarg);
+        else if (opt == 'T') tracePath = optarg;
+        else if (opt == 'P') port = atoi(optarg);
+        else if (opt == 'Q') {
+            stringstream list(optarg);
+            string name;
+            while (getline(list, name, ',')) queues.push_back(name);
+        }
+        else fatal("Usage: kid [-t tcp|unix|shm] [-s] [-p] [-f shorts|packed] [-T trace.json] [-P port] [-Q queue,queue,...]");
+    }
+    if (useSnapshot && !queues.empty()) fatal("kid: the snapshot is the whole table, so -s can't be combined with -Q");
+    seedRandom(time(nullptr) ^ (unsigned(getpid()) << 16) ^ getpid());
+    Kid kid{transport, useSnapshot, port};
+    kid.askFormat(format);
+    kid.setPrefetch(prefetch);
+    kid.subscribeTo(queues);
+    unique_ptr<Tracer> tracer;
+    if (!tracePath.empty()) {
+        tracer = make_unique<Tracer>(Clock::wall());
+        kid.traceTo(*tracer);
+    }
     kid.run();
+    if (tracer) tracer->save(tracePath);
     return 0;
 }
@@ -1,10 +1,42 @@
 #include "tools.hpp"
 #include "Mom.hpp"
+#include "Printer.hpp"
 
 /**
  * Main function<br>
  * -------------------------------------------------------<br>
- * - Seeds the random number generator for job attributes.<br>
+ * - Seeds the random number generator for job attributes: `-r seed` (default
+ *   the current time), so a replayed capture can meet the same jobs.<br>
+ * - Reads the transport choice: `-t tcp|unix|shm` (default tcp).<br>
+ * - Reads the I/O engine choice: `-e poll|uring` (default poll).<br>
+ * - `-n slots` runs a job table of that many slots (default 10).<br>
+ * - `-T file` writes a Chrome trace of job lifecycles and kid servicing.<br>
+ * - `-c file` captures every kid's messages, with timestamps, for the replay tool.<br>
+ * - `-R limit` jobs a kid may reserve beyond the one it is doing (default 1).<br>
+ * - `-J source` takes jobs from a file (CSV or binary), a FIFO, `-` (standard input),
+ *   or `unix:PATH` instead of rolling them (see JobSource::open).<br>
+ * - `-D graph.csv` takes jobs with prerequisites from a graph file instead
+ *   (see JobGraph): a job reaches the table only once its parents are done,
+ *   and the run ends when they all are.<br>
+ * - `-W ms` holds claims for that long and assigns each batch together, for
+ *   the most total value; `-A jobs` makes it the most jobs handed out instead.<br>
+ * - `-S seconds` lets Mom split a slow job (slow 4 or 5) that has gone unclaimed
+ *   that long while kids stand idle; the pieces are claimed and credited separately.<br>
+ * - `-L slack` gives every job a deadline, its own (a fourth CSV field) or
+ *   `slow` + slack seconds, fills slots earliest deadline first, and reports hits and misses.<br>
+ * - `-Q name:slots[:source],...` splits the table into named queues of that
+ *   many slots each, fed from their own source (as for -J) or, without one,
+ *   from Mom's; kids subscribe with kid -Q and see only their queues' slots.
+ *   Replaces -n; not with -D, -L or -C.<br>
+ * - `-I threads` moves reading, decoding and writing to that many I/O threads
+ *   (1..16), each with its own engine, feeding one scheduler thread that
+ *   owns the job table; not with -W or -C.<br>
+ * - `-H` backs Mom's arena (job records, sessions, connections) with huge pages
+ *   where the system has them.<br>
+ * - `-P port` listens on that port (default 1099), so several Moms can run side by side.<br>
+ * - `-C port,port,...` joins a cluster with the Moms on those ports (tcp or unix):
+ *   each takes her consistent-hash share of the job source, steals from the
+ *   others when hers runs dry, and prints the merged earnings.<br>
  * - Initializes and starts the Mom server process.<br>
  * - Executes the full simulation including:<br>
  *    - Job table initialization<br>
@@ -15,10 +47,101 @@
  * -------------------------------------------------------<br>
  * @return 0 on successful execution<br>
  */
-int main() {
-    srand(time(nullptr));
-    Mom mom;
+int main(int argc, char* argv[]) {
+    TransportKind transport = TransportKind::TCP;
+    IoEngineKind io = IoEngineKind::POLL;
+    string tracePath;
+    string capturePath;
+    unsigned seed = time(nullptr);
+    string jobSource = "random";
+    string jobGraph;
+    int slots = JOB_SLOTS;
+    int reservations = 1;
+    double window = 0;
+    bool forJobs = false;
+    double splitAfter = 0;
+    double slack = -1;
+    int port = PORT;
+    vector<int> members;
+    vector<string> queues;
+    bool hugePages = false;
+    int ioThreads = 0;
+    int opt;
+    while ((opt = getopt(argc, argv, "t:e:n:T:c:r:J:D:R:W:A:S:L:Q:P:C:I:H")) != -1) {
+        if (opt == 't') transport = transportFromName(optarg);
+        else if (opt == 'e') io = ioEngineFromName(optarg);
+        else if (opt == 'n') slots = atoi(optarg);
+        else if (opt == 'T') tracePath = optarg;
+        else if (opt == 'c') capturePath = optarg;
+        else if (opt == 'r') seed = strtoul(optarg, nullptr, 10);
+        else if (opt == 'J') jobSource = optarg;
+        else if (opt == 'D') jobGraph = optarg;
+        else if (opt == 'R') reservations = atoi(optarg);
+        else if (opt == 'S') splitAfter = atof(optarg);
+        else if (opt == 'L') slack = max(atof(optarg), 0.0);
+        else if (opt == 'W') window = atof(optarg) / 1000;
+        else if (opt == 'A' && (string(optarg) == "value" || string(optarg) == "jobs")) forJobs = string(optarg) == "jobs";
+        else if (opt == 'Q') {
+            stringstream list(optarg);
+            string queue;
+            while (getline(list, queue, ',')) queues.push_back(queue);
+        }
+        else if (opt == 'I') ioThreads = atoi(optarg);
+        else if (opt == 'H') hugePages = true;
+        else if (opt == 'P') port = atoi(optarg);
+        else if (opt == 'C') {
+            stringstream list(optarg);
+            string member;
+            while (getline(list, member, ',')) members.push_back(atoi(member.c_str()));
+        }
+        else fatal("Usage: mom [-t tcp|unix|shm] [-e poll|uring] [-n slots] [-T trace.json] [-c capture] [-r seed] [-J jobs.csv|jobs.bin|-|unix:PATH] [-D graph.csv] [-R limit] [-W ms] [-A value|jobs] [-S seconds] [-L slack] [-Q name:slots[:source],...] [-I threads] [-H] [-P port] [-C port,port,...]");
+    }
+    if (slots < 1 || slots > MAX_JOB_SLOTS) fatal("mom: the table needs 1.." + to_string(MAX_JOB_SLOTS) + " slots");
+    if (reservations < 0 || reservations > MAX_CLAIMS) fatal("mom: the reservation limit is 0.." + to_string(MAX_CLAIMS));
+    if (port < 1 || port > UINT16_MAX) fatal("mom: ports are 1.." + to_string(UINT16_MAX));
+    if (!members.empty() && transport == TransportKind::SHM) fatal("mom: a cluster needs -t tcp or -t unix");
+    if (!jobGraph.empty() && (jobSource != "random" || !members.empty())) fatal("mom: -D can't be combined with -J or -C");
+    if (!queues.empty() && (!jobGraph.empty() || !members.empty() || slack >= 0)) fatal("mom: -Q can't be combined with -D, -L or -C");
+    if (ioThreads < 0 || ioThreads > MAX_IO_THREADS) fatal("mom: -I takes 0.." + to_string(MAX_IO_THREADS) + " I/O threads");
+    if (ioThreads > 0 && (window > 0 || !members.empty())) fatal("mom: -I can't be combined with -W or -C");
+    seedRandom(seed);
+    Mom mom(transport, io);
+    if (hugePages) mom.useHugePages();
+    mom.setIoThreads(ioThreads);
+    mom.setPort(port);
+    mom.setTableSize(slots);
+    mom.setReservationLimit(reservations);
+    mom.setClaimWindow(max(window, 0.0), forJobs);
+    mom.setSplitAfter(max(splitAfter, 0.0));
+    if (slack >= 0) mom.setDeadlines(slack);
+    if (!members.empty()) mom.joinCluster(members, JobSource::open(jobSource));
+    else if (!jobGraph.empty()) mom.setJobGraph(make_unique<JobGraph>(jobGraph));
+    else if (jobSource != "random") mom.setJobSource(JobSource::open(jobSource));
+    for (const string& queue : queues) {
+        size_t colon = queue.find(':');
+        size_t more = colon == string::npos ? string::npos : queue.find(':', colon + 1);
+        if (colon == string::npos) fatal("mom: a queue is name:slots[:source], not " + queue);
+        mom.addQueue(queue.substr(0, colon), atoi(queue.substr(colon + 1, more - colon - 1).c_str()),
+                     more == string::npos ? nullptr : JobSource::open(queue.substr(more + 1)));
+    }
+    unique_ptr<Tracer> tracer;
+    if (!tracePath.empty()) {
+        tracer = make_unique<Tracer>(Clock::wall());
+        mom.traceTo(*tracer);
+    }
+    unique_ptr<Capture> capture;
+    if (!capturePath.empty()) {
+        capture = make_unique<Capture>(Clock::wall(), seed, slots);
+        mom.captureTo(*capture);
+    }
     mom.run();
+    if (tracer) tracer->save(tracePath);
+    if (capture) {
+        capture->save(capturePath);
+        ss << "Captured " << capture->records() << " records (" << capture->size() << " bytes) to " << capturePath
+           << "; replay against mom -r " << seed << endl;
+        Printer::write(ss, cout);
+    }
     bye();
     return 0;
 }
@@ -0,0 +1,36 @@
+#include "tools.hpp"
+#include "Relay.hpp"
+
+/**
+ * Main function (Relay)<br>
+ * -------------------------------------------------------<br>
+ * - Reads the transport choice: `-t tcp|unix|shm`, used both towards the
+ *   kids and towards Mom.<br>
+ * - Reads the I/O engine choice: `-e poll|uring` (default poll).<br>
+ * - `-P port` where kids connect (default 2099); start kids with the same `-P`.<br>
+ * - `-M port` where Mom listens (default 1099).<br>
+ * - `-u links` connections to open to Mom (default 2).<br>
+ * - Runs the relay until Mom sends QUIT, then tells every kid to QUIT.<br>
+ * -------------------------------------------------------<br>
+ * @return 0 on successful execution<br>
+ */
+int main(int argc, char* argv[]) {
+    TransportKind transport = TransportKind::TCP;
+    IoEngineKind io = IoEngineKind::POLL;
+    int port = RELAY_PORT;
+    int momPort = PORT;
+    int links = RELAY_LINKS;
+    int opt;
+    while ((opt = getopt(argc, argv, "t:e:P:M:u:")) != -1) {
+        if (opt == 't') transport = transportFromName(optarg);
+        else if (opt == 'e') io = ioEngineFromName(optarg);
+        else if (opt == 'P') port = atoi(optarg);
+        else if (opt == 'M') momPort = atoi(optarg);
+        else if (opt == 'u') links = atoi(optarg);
+        else fatal("Usage: relay [-t tcp|unix|shm] [-e poll|uring] [-P port] [-M mom port] [-u links]");
+    }
+    if (links < 1 || links > RELAY_MAX_LINKS) fatal("relay: 1.." + to_string(RELAY_MAX_LINKS) + " links to Mom");
+    Relay relay(transport, io, port, momPort, links);
+    relay.run();
+    return 0;
+}
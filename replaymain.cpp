@@ -0,0 +1,51 @@
+#include "tools.hpp"
+#include "Replay.hpp"
+#include "Printer.hpp"
+
+/**
+ * Main function (Replay)<br>
+ * -------------------------------------------------------<br>
+ * - Plays the kid sessions in a capture (mom -c or sim -c) against the Mom
+ *   already running on `-P port`, and reports her throughput and latency.<br>
+ * - Reads the transport choice: `-t tcp|unix|shm` (must match Mom's).<br>
+ * - `-P port` Mom's port (default 1099).<br>
+ * - `-x` sends each message as soon as the last is answered instead of at its captured time.<br>
+ * - `-o file` writes the results as `metric,value` lines.<br>
+ * - `-b file` results of an earlier replay (another build, say) to compare with.<br>
+ * - For comparable runs, start Mom with the seed the capture names (mom -r)
+ *   and the same table, and replay the same way each time.<br>
+ * -------------------------------------------------------<br>
+ * @return 0 on successful execution<br>
+ */
+int main(int argc, char* argv[]) {
+    TransportKind transport = TransportKind::TCP;
+    int port = PORT;
+    bool fast = false;
+    string csvPath;
+    string baselinePath;
+    bool usage = false;
+    int opt;
+    while ((opt = getopt(argc, argv, "t:P:xo:b:")) != -1) {
+        if (opt == 't') transport = transportFromName(optarg);
+        else if (opt == 'P') port = atoi(optarg);
+        else if (opt == 'x') fast = true;
+        else if (opt == 'o') csvPath = optarg;
+        else if (opt == 'b') baselinePath = optarg;
+        else usage = true;
+    }
+    if (usage || optind != argc - 1)
+        fatal("Usage: replay [-t tcp|unix|shm] [-P port] [-x] [-o results.csv] [-b baseline.csv] capture");
+
+    Replay replay(argv[optind], transport, port, fast);
+    ofstream csvFile;
+    if (!csvPath.empty()) {
+        csvFile.open(csvPath);
+        if (!csvFile) fatal("replay: can't write " + csvPath);
+    }
+    replay.run();
+    replay.report(ss);
+    if (!baselinePath.empty()) replay.compare(baselinePath, ss);
+    Printer::write(ss, cout);
+    if (csvFile.is_open()) replay.writeCsv(csvFile);
+    return 0;
+}
@@ -0,0 +1,100 @@
+#include "tools.hpp"
+#include "Simulation.hpp"
+#include "Printer.hpp"
+#include <map>
+
+/**
+ * Main function (Simulator)<br>
+ * -------------------------------------------------------<br>
+ * - Runs Mom and a group of Kids in one process on simulated time.<br>
+ * - `-k kids` number of kids (default 4).<br>
+ * - `-d seconds` simulated length of the run (default 21).<br>
+ * - `-l seconds` simulated delay of each kid message (default 0.001).<br>
+ * - `-r seed` random seed (default: the current time); the same seed
+ *   replays the same run.<br>
+ * - `-n slots` job table size (default 10); `-f shorts|packed` kids' table encoding (default packed).<br>
+ * - `-W ms` has Mom assign claims in batches held that long; `-A jobs` for the
+ *   most jobs rather than the most value.<br>
+ * - `-S seconds` lets Mom split slow jobs left unclaimed that long.<br>
+ * - `-L slack` gives jobs deadlines of `slow` + slack seconds, handled earliest deadline first.<br>
+ * - `-p` puts every kid in pipelined mode (reserve the next job while working).<br>
+ * - `-T file` writes a Chrome trace of the run (in simulated time).<br>
+ * - `-c file` captures the kids' messages to Mom for the replay tool, paced in simulated time.<br>
+ * - `-q` silences Mom and the Kids and prints only each kid's total, the
+ *   messages Mom handled and the heap allocations the run made.<br>
+ * -------------------------------------------------------<br>
+ * @return 0 on successful execution<br>
+ */
+int main(int argc, char* argv[]) {
+    int kids = 4;
+    double seconds = 21;
+    unsigned seed = time(nullptr);
+    double latency = SIM_LATENCY;
+    bool quiet = false;
+    bool prefetch = false;
+    double window = 0;
+    bool forJobs = false;
+    double splitAfter = 0;
+    double slack = -1;
+    string tracePath;
+    string capturePath;
+    int slots = JOB_SLOTS;
+    TableFormat format = TableFormat::PACKED;
+    int opt;
+    while ((opt = getopt(argc, argv, "k:d:l:r:n:f:T:c:W:A:S:L:qp")) != -1) {
+        if (opt == 'k') kids = atoi(optarg);
+        else if (opt == 'd') seconds = atof(optarg);
+        else if (opt == 'l') latency = atof(optarg);
+        else if (opt == 'r') seed = strtoul(optarg, nullptr, 10);
+        else if (opt == 'n') slots = atoi(optarg);
+        else if (opt == 'f') format = tableFormatFromName(optarg);
+        else if (opt == 'T') tracePath = optarg;
+        else if (opt == 'c') capturePath = optarg;
+        else if (opt == 'q') quiet = true;
+        else if (opt == 'p') prefetch = true;
+        else if (opt == 'S') splitAfter = atof(optarg);
+        else if (opt == 'L') slack = max(atof(optarg), 0.0);
+        else if (opt == 'W') window = atof(optarg) / 1000;
+        else if (opt == 'A' && (string(optarg) == "value" || string(optarg) == "jobs")) forJobs = string(optarg) == "jobs";
+        else fatal("Usage: sim [-k kids] [-d seconds] [-l latency] [-r seed] [-n slots] [-f shorts|packed] [-T trace.json] [-c capture] [-W ms] [-A value|jobs] [-S seconds] [-L slack] [-q] [-p]");
+    }
+    if (kids < 1 || kids > MAXCLIENTS || seconds <= 0 || latency <= 0 || slots < 1 || slots > MAX_JOB_SLOTS)
+        fatal("sim: need 1.." + to_string(MAXCLIENTS) + " kids, 1.." + to_string(MAX_JOB_SLOTS)
+              + " slots, a positive length and a positive latency");
+    seedRandom(seed);
+    Simulation sim;
+    sim.setLatency(latency);
+    sim.setTable(slots, format);
+    sim.setPrefetch(prefetch);
+    sim.setClaimWindow(max(window, 0.0), forJobs);
+    sim.setSplitAfter(max(splitAfter, 0.0));
+    if (slack >= 0) sim.setDeadlines(slack);
+    unique_ptr<Tracer> tracer;
+    if (!tracePath.empty()) {
+        tracer = make_unique<Tracer>(sim.simClock());
+        sim.traceTo(*tracer);
+    }
+    unique_ptr<Capture> capture;
+    if (!capturePath.empty()) {
+        capture = make_unique<Capture>(sim.simClock(), seed, slots);
+        sim.captureTo(*capture);
+    }
+    for (int k = 0; k < kids; k++) sim.addKid();
+    Printer::mute(quiet);
+    long allocations = Heap::allocations();
+    sim.run(seconds);
+    allocations = Heap::allocations() - allocations;
+    Printer::mute(false);
+    if (tracer) tracer->save(tracePath);
+    if (capture) capture->save(capturePath);
+    if (quiet) {
+        map<string, long> totals;
+        for (auto& [job, name] : sim.mother().results()) totals[name] += job.getValue();
+        for (auto& [name, total] : totals) ss << name << ": " << total << endl;
+        ss << sim.mother().messageCount() << " messages" << endl;
+        ss << allocations << " heap allocations" << endl;
+    }
+    ss << "Simulated " << seconds << " s with " << kids << " kids, seed " << seed << endl;
+    Printer::write(ss, cout);
+    return 0;
+}
@@ -0,0 +1,60 @@
+#include "tools.hpp"
+#include "Sweep.hpp"
+#include "Printer.hpp"
+#include <chrono>
+
+/**
+ * Main function (Sweep)<br>
+ * -------------------------------------------------------<br>
+ * - Runs every combination of kid moods many times in simulated time,
+ *   spread over all cores, and writes a CSV of the results.<br>
+ * - `-k kids` kids per run (default 4).<br>
+ * - `-n runs` seeded runs per combination (default 100).<br>
+ * - `-d seconds` simulated length of each run (default 21).<br>
+ * - `-l seconds` simulated delay of each kid message (default 0.001).<br>
+ * - `-r seed` seed of the first run (default 1); run i uses seed + i.<br>
+ * - `-j threads` worker threads (default: one per hardware thread).<br>
+ * - `-o file` CSV destination (default: standard output).<br>
+ * -------------------------------------------------------<br>
+ * @return 0 on successful execution<br>
+ */
+int main(int argc, char* argv[]) {
+    SweepConfig config;
+    unsigned threads = 0;
+    string csvPath;
+    int opt;
+    while ((opt = getopt(argc, argv, "k:n:d:l:r:j:o:")) != -1) {
+        if (opt == 'k') config.kids = atoi(optarg);
+        else if (opt == 'n') config.runs = atoi(optarg);
+        else if (opt == 'd') config.seconds = atof(optarg);
+        else if (opt == 'l') config.latency = atof(optarg);
+        else if (opt == 'r') config.seed = strtoul(optarg, nullptr, 10);
+        else if (opt == 'j') threads = atoi(optarg);
+        else if (opt == 'o') csvPath = optarg;
+        else fatal("Usage: sweep [-k kids] [-n runs] [-d seconds] [-l latency] [-r seed] [-j threads] [-o file.csv]");
+    }
+    if (config.kids < 1 || config.kids > MAXCLIENTS || config.runs < 1 || config.seconds <= 0 || config.latency <= 0)
+        fatal("sweep: need 1.." + to_string(MAXCLIENTS) + " kids, at least one run, and a positive length and latency");
+
+    ofstream csvFile;
+    if (!csvPath.empty()) {
+        csvFile.open(csvPath);
+        if (!csvFile) fatal("sweep: can't write " + csvPath);
+    }
+
+    Sweep sweep(config);
+    ThreadPool pool(threads);
+    auto start = chrono::steady_clock::now();
+    Printer::mute(true);
+    sweep.run(pool);
+    Printer::mute(false);
+    double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    if (csvFile.is_open()) sweep.writeCsv(csvFile);
+    else sweep.writeCsv(cout);
+    ss << "Swept " << sweep.combinations() << " mood combinations x " << config.runs << " runs on "
+       << pool.size() << " threads in " << fixed << setprecision(2) << elapsed << " s ("
+       << pool.steals() << " tasks stolen)" << endl;
+    Printer::write(ss, cerr);
+    return 0;
+}
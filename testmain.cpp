@@ -0,0 +1,258 @@
+#include "tools.hpp"
+#include "AssignmentSolver.hpp"
+#include "TableCodec.hpp"
+#include "JobGraph.hpp"
+#include "MpmcRing.hpp"
+#include "Mom.hpp"
+#include "Printer.hpp"
+#include <thread>
+
+/**
+ * Stops the run with `what` unless `ok`.<br>
+ */
+static void check(bool ok, const string& what) {
+    if (!ok) fatal("FAILED: " + what);
+}
+
+/**
+ * Best total worth by trying every assignment; fine for a handful of bidders.<br>
+ */
+static long bruteForce(const vector<vector<pair<int, long>>>& options, size_t bidder, vector<bool>& taken) {
+    if (bidder == options.size()) return 0;
+    long best = bruteForce(options, bidder + 1, taken);
+    for (auto& [object, worth] : options[bidder]) {
+        if (taken[object]) continue;
+        taken[object] = true;
+        best = max(best, worth + bruteForce(options, bidder + 1, taken));
+        taken[object] = false;
+    }
+    return best;
+}
+
+/**
+ * AssignmentSolver against brute force on small random problems. <br>
+ * -------------------------------------------------------
+ * - Up to six bidders and six objects, each bidder listing a random subset
+ *   with worths from 0 to 20, so ties and worthless options come up often.
+ * - The result must be a valid assignment (listed objects, none twice)
+ *   whose total matches the best brute force finds.
+ * - One solver is cleared and reused throughout, as Mom does.
+ * -------------------------------------------------------
+ */
+static void testSolver(int rounds) {
+    AssignmentSolver solver;
+    for (int round = 0; round < rounds; round++) {
+        int objects = 1 + randomInt(6);
+        vector<vector<pair<int, long>>> options(1 + randomInt(6));
+        for (auto& listed : options)
+            for (int object = 0; object < objects; object++)
+                if (randomInt(2)) listed.emplace_back(object, randomInt(21));
+        solver.clear();
+        for (auto& listed : options) solver.addBidder(listed);
+        const vector<int>& won = solver.solve();
+        check(won.size() == options.size(), "solver returns one object per bidder");
+        vector<bool> taken(objects, false);
+        long total = 0;
+        for (size_t bidder = 0; bidder < options.size(); bidder++) {
+            if (won[bidder] < 0) continue;
+            auto found = find_if(options[bidder].begin(), options[bidder].end(),
+                                 [&](const pair<int, long>& option) { return option.first == won[bidder]; });
+            check(found != options[bidder].end(), "solver grants only listed objects");
+            check(!taken[won[bidder]], "solver grants each object once");
+            taken[won[bidder]] = true;
+            total += found->second;
+        }
+        taken.assign(objects, false);
+        check(total == bruteForce(options, 0, taken), "solver total matches brute force in round " + to_string(round));
+    }
+    ss << "AssignmentSolver: " << rounds << " random problems match brute force" << endl;
+}
+
+/**
+ * TableCodec round trips on random tables. <br>
+ * -------------------------------------------------------
+ * - A table of 0 to 40 slots with random attributes, statuses and
+ *   generations (the full 16 bits) is built from rows given out of order.
+ * - Encoding it as rows must give back the same rows in slot order, and
+ *   packing and unpacking it must give a table with those rows too.
+ * - Every prefix of the packed encoding must be refused as cut short.
+ * -------------------------------------------------------
+ */
+static void testCodec(int rounds) {
+    vector<short> rows, shuffled, again;
+    string packed;
+    JobTable table(0), unpacked(0);
+    for (int round = 0; round < rounds; round++) {
+        short slots = randomInt(41);
+        rows.clear();
+        for (short i = 0; i < slots; i++) {
+            short slow = 1 + randomInt(5), dirty = 1 + randomInt(5), heavy = 1 + randomInt(5);
+            short row[ROW_SHORTS] = {i, slow, dirty, heavy, short(slow * (dirty + heavy)),
+                                     short(randomInt(3)), short(randomInt(UINT16_MAX + 1))};
+            rows.insert(rows.end(), row, row + ROW_SHORTS);
+        }
+        shuffled = rows;
+        for (short i = slots - 1; i > 0; i--) {
+            short j = randomInt(i + 1);
+            swap_ranges(shuffled.begin() + i * ROW_SHORTS, shuffled.begin() + (i + 1) * ROW_SHORTS, shuffled.begin() + j * ROW_SHORTS);
+        }
+        check(TableCodec::decodeRows(shuffled.data(), slots, table), "rows decode");
+        TableCodec::encodeRows(table, again);
+        check(again == rows, "rows round trip in round " + to_string(round));
+
+        TableCodec::encodePacked(table, packed);
+        check(TableCodec::decodePacked(packed, unpacked), "packed table decodes");
+        TableCodec::encodeRows(unpacked, again);
+        check(again == rows, "packed round trip in round " + to_string(round));
+        for (size_t cut = 0; cut < packed.size(); cut++)
+            check(!TableCodec::decodePacked(packed.substr(0, cut), unpacked), "packed table cut short is refused");
+    }
+    ss << "TableCodec: " << rounds << " random tables survive rows and packed round trips" << endl;
+}
+
+/**
+ * MpmcRing under four producers and four consumers. <br>
+ * -------------------------------------------------------
+ * - A small ring, so both full and empty come up constantly.
+ * - Every number pushed must be popped exactly once: the count and the
+ *   sum of what the consumers took must match what went in.
+ * -------------------------------------------------------
+ */
+static void testRing(long perProducer) {
+    const int threads = 4;
+    MpmcRing<long> ring(16);
+    atomic<long> popped{0}, sum{0};
+    vector<thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&] {
+            for (long n = 1; n <= perProducer; n++) {
+                long item = n;
+                while (!ring.push(item)) this_thread::yield();
+            }
+        });
+        workers.emplace_back([&] {
+            long item, mine = 0;
+            while (popped.load() < threads * perProducer) {
+                if (!ring.pop(item)) {
+                    this_thread::yield();
+                    continue;
+                }
+                mine += item;
+                popped++;
+            }
+            sum += mine;
+        });
+    }
+    for (thread& worker : workers) worker.join();
+    check(popped == threads * perProducer, "ring delivers every item once");
+    check(sum == threads * perProducer * (perProducer + 1) / 2, "ring delivers what was pushed");
+    ss << "MpmcRing: " << threads * perProducer << " items through " << threads << " producers and consumers" << endl;
+}
+
+/**
+ * JobGraph on a small file with comments, a header and a diamond. <br>
+ * -------------------------------------------------------
+ * - Jobs 0 and 1 are ready at once; 2 waits for both; 3 waits for 2.
+ * - Each job must come out with its own attributes, and only once the
+ *   last of its parents is complete.
+ * -------------------------------------------------------
+ */
+static void testGraph() {
+    char path[] = "/tmp/jobgraphXXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) fatal("Can't create a test job graph");
+    string text = "slow,dirty,heavy,parents\n# 0 and 1 first\n2,3,1\n 1, 1, 4\r\n\n5,2,2,0,1\n3,3,3,2";
+    check(write(fd, text.data(), text.size()) == ssize_t(text.size()), "job graph written");
+    close(fd);
+    JobGraph graph(path);
+    unlink(path);
+    check(graph.size() == 4 && graph.edges() == 3, "graph has 4 jobs and 3 edges");
+    uint32_t node;
+    Job job;
+    check(graph.takeReady(node, job) && node == 0 && job.getValue() == 2 * (3 + 1), "job 0 comes first");
+    check(graph.takeReady(node, job) && node == 1 && job.getValue() == 1 * (1 + 4), "job 1 is ready too");
+    check(!graph.takeReady(node, job), "job 2 waits for its parents");
+    graph.complete(1);
+    check(!graph.takeReady(node, job), "job 2 waits for its last parent");
+    graph.complete(0);
+    check(graph.takeReady(node, job) && node == 2 && job.getValue() == 5 * (2 + 2), "job 2 follows its parents");
+    check(!graph.takeReady(node, job), "job 3 waits for job 2");
+    graph.complete(2);
+    check(graph.takeReady(node, job) && node == 3, "job 3 follows job 2");
+    graph.complete(3);
+    check(graph.finished() && graph.longestQueue() == 2, "graph finishes");
+    ss << "JobGraph: parsing and readiness order" << endl;
+}
+
+/**
+ * Mom's opening table with a supply that can't fill it. <br>
+ * -------------------------------------------------------
+ * - A graph with two jobs ready at the start, on a ten-slot table: two
+ *   slots get jobs and the other eight start out vacant.
+ * - Every row must still carry its own slot as its job number, and the
+ *   vacant ones must read as COMPLETE, so a kid decoding the rows ends up
+ *   with Mom's table rather than eight rows piled onto slot 0.
+ * -------------------------------------------------------
+ */
+static void testEmptySupply() {
+    char path[] = "/tmp/jobgraphXXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) fatal("Can't create a test job graph");
+    string text = "2,3,1\n1,1,4\n5,2,2,0,1\n";
+    check(write(fd, text.data(), text.size()) == ssize_t(text.size()), "job graph written");
+    close(fd);
+    Mom mom;
+    mom.setTableSize(10);
+    mom.setJobGraph(make_unique<JobGraph>(path));
+    unlink(path);
+    Printer::write(ss, cout);
+    Printer::mute(true);
+    mom.initializeJobTable();
+    Printer::mute(false);
+    vector<short> rows, again;
+    TableCodec::encodeRows(mom.jobTable(), rows);
+    for (short i = 0; i < 10; i++) {
+        check(rows[i * ROW_SHORTS] == i, "slot " + to_string(i) + " carries its own number");
+        JobStatus status = static_cast<JobStatus>(rows[i * ROW_SHORTS + 5]);
+        check(status == (i < 2 ? JobStatus::NOT_STARTED : JobStatus::COMPLETE), "slot " + to_string(i) + " is filled or vacant");
+    }
+    JobTable kidTable(0);
+    check(TableCodec::decodeRows(rows.data(), 10, kidTable), "opening table decodes");
+    TableCodec::encodeRows(kidTable, again);
+    check(again == rows, "a kid decodes the opening table as Mom has it");
+    ss << "Mom: an opening table the supply can't fill has every slot numbered" << endl;
+}
+
+/**
+ * Main function (Tests)<br>
+ * -------------------------------------------------------<br>
+ * - Checks the pieces that can be checked without a run: the claim
+ *   solver, the table encodings, the lane queue, the job graph and
+ *   Mom's opening table.<br>
+ * - `-r seed` seeds the random problems (default 1), `-n rounds` sets how
+ *   many of each (default 2000).<br>
+ * - The first failure ends the run with an error; `make test` runs it.<br>
+ * -------------------------------------------------------<br>
+ * @return 0 if every check passed<br>
+ */
+int main(int argc, char* argv[]) {
+    unsigned seed = 1;
+    int rounds = 2000;
+    bool usage = false;
+    int opt;
+    while ((opt = getopt(argc, argv, "r:n:")) != -1) {
+        if (opt == 'r') seed = strtoul(optarg, nullptr, 10);
+        else if (opt == 'n') rounds = atoi(optarg);
+        else usage = true;
+    }
+    if (usage || optind != argc || rounds < 1) fatal("Usage: tests [-r seed] [-n rounds]");
+    seedRandom(seed);
+    testSolver(rounds);
+    testCodec(rounds);
+    testRing(rounds * 50L);
+    testGraph();
+    testEmptySupply();
+    ss << "All tests passed (seed " << seed << ")" << endl;
+    Printer::write(ss, cout);
+    return 0;
+}
@@ -165,3 +165,16 @@ void printSockInfo( const char* who, sockInfo sock ){
     <<" sin_addr.s_addr = " <<inet_ntoa (sock.sin_addr) <<"\n\t" //Linux: ntop
     <<" sin_port (!!!)  = " <<ntohs(sock.sin_port) <<"\n\t};\n";
 }
+
+
+//----------------------------------------------------------------------------
+// Per-thread random numbers: the same seed gives the same sequence on
+// every thread, whatever the other threads are doing
+//-----------------------------------------------------------------------------
+void seedRandom(unsigned seed) {
+    rng.seed(seed);
+}
+
+int randomInt(int n) {
+    return uniform_int_distribution<int>(0, n - 1)(rng);
+}
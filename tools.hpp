@@ -14,6 +14,7 @@
 #include <limits>
 #include <utility>
 #include <unordered_map>
+#include <random>
 
 #include <cmath>
 #include <ctime>
@@ -45,6 +46,7 @@ using namespace std;
 
 #define LOCALHOST "localhost"
 #define PORT 1099
+#define SOCKPATH "/tmp/socketsync"
 
 typedef struct sockaddr_in  sockInfo;
 typedef struct sockaddr     sockUnion;
@@ -97,6 +99,9 @@ int  menu( const char* title, int n, const string menu[] );
 //----------------------------------------------------------------------
 bool caseInsensitiveEquals(const string& str1, const string& str2);
 void printSockInfo( const char* who, sockInfo sock );
-//Global variable
-inline stringstream ss;
+void seedRandom(unsigned seed);
+int randomInt(int n);
+//Global variables, one copy per thread so simulations can run side by side
+inline thread_local stringstream ss;
+inline thread_local mt19937 rng;
 